@@ -16,6 +16,7 @@ typedef struct {
     subscribe_tuples sub_properties;
     command_table commands[MAX_COMMAND_NUM];
     size_t command_count;
+    void (*payload_handler)(char *payload, uint32_t payload_len);  // Optional, invoked when no command matches the payload
 } app_subscription_entry;
 
 typedef void (*mqtt_callback)(int event_type, mqtt_publish *pub_pkt);
@@ -26,8 +27,9 @@ void mqtt_trigger_event(int event_type, mqtt_publish *pub_pkt);
 
 app_subscription_entry match_topic(char *topic_filter, vector subscription_list);
 int mqtt_client_handle_publish(mqtt_publish pub, vector subscription_list, int sock);
+int mqtt_client_send_puback(uint16_t pkt_id, int sock);
 int mqtt_client_subscribe_to_topic(subscribe_tuples subscription, uint16_t *packet_id, int sock);
 int mqtt_client_send_connect_packet(int sock);
-void publish(mqtt_publish pub, uint8_t pub_flags, int sock);
+int publish(mqtt_publish pub, uint8_t pub_flags, int sock);     // Returns the number of bytes sent, -1 on failure
 
 #endif
\ No newline at end of file
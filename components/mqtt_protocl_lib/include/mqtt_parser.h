@@ -223,6 +223,30 @@ int unpack_connack(mqtt_connack *connack, uint8_t **buf, size_t buf_size, int ac
  */
 int unpack_publish(mqtt_publish *publish, mqtt_header header, uint8_t **buf, size_t buf_size, int accumulated_size);
 
+/**
+ * @brief Zero-copy variant of unpack_publish.
+ *
+ * Fills topic and payload with pointers into the packet buffer instead of allocating copies. They are NOT
+ * NUL terminated, are only valid as long as the buffer is, and must not be released with free_publish.
+ *
+ * @param[out] publish Pointer to the publish struct to fill.
+ * @param[in] header The MQTT fixed header.
+ * @param[in,out] buf Pointer to the buffer pointer.
+ * @param[in] buf_size Size of the buffer.
+ * @param[in] accumulated_size Number of bytes already consumed from the buffer (fixed header).
+ * @return MQTT_PUBLISH on success, or an error code on failure.
+ */
+int peek_publish(mqtt_publish *publish, mqtt_header header, uint8_t **buf, size_t buf_size, int accumulated_size);
+
+/**
+ * @brief Determines the total length of the packet at the start of a (possibly partial) stream buffer.
+ *
+ * @param[in] buf Start of the packet.
+ * @param[in] buf_len Number of bytes available.
+ * @return Total packet length (fixed header included), 0 if more bytes are needed to tell, or MALFORMED_PACKET.
+ */
+int peek_packet_length(const uint8_t *buf, size_t buf_len);
+
 /**
  * @brief Unpacks a SUBSCRIBE packet from the buffer into a mqtt_subscribe structure.
  *
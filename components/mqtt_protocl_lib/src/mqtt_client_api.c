@@ -3,6 +3,8 @@
 #include "esp_log.h"
 #include <string.h>
 #include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 
 #define MQTT_TAG        "MQTT"
@@ -11,6 +13,34 @@
 
 mqtt_callback client_callback = NULL;
 
+static StaticSemaphore_t send_lock_buffer;
+static SemaphoreHandle_t send_lock = NULL;
+static portMUX_TYPE send_lock_init = portMUX_INITIALIZER_UNLOCKED;
+
+
+/*
+ * Sends a whole packet. Several tasks write to the broker socket (the broker task acknowledges, the state
+ * reporter publishes), so every packet goes out under one lock and packets never interleave on the stream.
+ */
+static ssize_t send_packet(int sock, const uint8_t *buf, size_t len) {
+    portENTER_CRITICAL(&send_lock_init);
+    if (!send_lock) send_lock = xSemaphoreCreateMutexStatic(&send_lock_buffer);
+    portEXIT_CRITICAL(&send_lock_init);
+
+    xSemaphoreTake(send_lock, portMAX_DELAY);
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t bytes_written = send(sock, buf + sent, len - sent, 0);
+        if (bytes_written <= 0) {
+            sent = 0;
+            break;
+        }
+        sent += bytes_written;
+    }
+    xSemaphoreGive(send_lock);
+    return sent ? (ssize_t)sent : -1;
+}
+
 
 void mqtt_client_register_callback(mqtt_callback callback_func) {
     client_callback = callback_func;
@@ -44,22 +74,35 @@ int mqtt_client_handle_publish(mqtt_publish pub, vector subscription_list, int s
         return -1;
     }
     // Match payload to allowed commands for the particular subscription
+    int matched = 0;
     for (int i = 0; i < ret_sub_entry.command_count; ++i) {
         if (!strcmp(pub.payload, ret_sub_entry.commands[i].command_name)) {
             ret_sub_entry.commands[i].callback(NULL);   // Invoke callback if command is validated
+            matched = 1;
         }
     }
+    if (!matched && ret_sub_entry.payload_handler) {
+        ret_sub_entry.payload_handler(pub.payload, pub.payload_len);
+    }
 
-    // Pack and send puback to broker
+    // QoS 0 publishes carry no packet ID and are not acknowledged
+    if (pub.pkt_id == 0) return 0;
+    return mqtt_client_send_puback(pub.pkt_id, sock);
+}
+
+
+int mqtt_client_send_puback(uint16_t pkt_id, int sock) {
     mqtt_puback puback = {
-        .pkt_id = pub.pkt_id,
+        .pkt_id = pkt_id,
     };
     packing_status packed = pack_puback(puback);
     if (packed.return_code < 0) {
         ESP_LOGI(MQTT_TAG, "Packing puback failed with err code %d", packed.return_code);
+        free(packed.buf);
         return -1;
     }
-    ssize_t bytes_written = send(sock, (uint8_t *)packed.buf, packed.buf_len, 0);
+    ssize_t bytes_written = send_packet(sock, (uint8_t *)packed.buf, packed.buf_len);
+    free(packed.buf);
     if (bytes_written == -1) {
         ESP_LOGE(MQTT_TAG, "Send failed!");
         return -1;
@@ -83,9 +126,11 @@ int mqtt_client_subscribe_to_topic(subscribe_tuples subscription, uint16_t *pack
     packing_status packed = pack_subscribe(&sub);
     if (packed.return_code < 0) {
         ESP_LOGI(MQTT_TAG, "Packing subscribe failed with err code %d\n", packed.return_code);
+        free(packed.buf);
         return -1;
     }    
-    ssize_t bytes_written = send(sock, (uint8_t *)packed.buf, packed.buf_len, 0);
+    ssize_t bytes_written = send_packet(sock, (uint8_t *)packed.buf, packed.buf_len);
+    free(packed.buf);
     if (bytes_written == -1) {
         ESP_LOGE(MQTT_TAG, "Failed sending subscribe packet to broker");
         return -1;
@@ -104,7 +149,7 @@ int mqtt_client_send_connect_packet(int sock) {
         ESP_LOGI(MQTT_TAG, "Packing connect failed with err code %d\n", status.return_code);
     }
 
-    ssize_t bytes_written = send(sock, (uint8_t *)status.buf, status.buf_len, 0);
+    ssize_t bytes_written = send_packet(sock, (uint8_t *)status.buf, status.buf_len);
     if (bytes_written  == -1) {
         ESP_LOGE(MQTT_TAG, "Send failed!");
     }
@@ -112,14 +157,18 @@ int mqtt_client_send_connect_packet(int sock) {
 }
 
 
-void publish(mqtt_publish pub, uint8_t pub_flags, int sock) {
+int publish(mqtt_publish pub, uint8_t pub_flags, int sock) {
     packing_status packed = pack_publish(&pub, pub_flags);
     if (packed.return_code < 0) {
         ESP_LOGI(MQTT_TAG, "Packing publish failed with err code %d", packed.return_code);
-        return;
+        free(packed.buf);
+        return -1;
     }
-    ssize_t bytes_written = send(sock, (uint8_t *)packed.buf, packed.buf_len, 0);
+    ssize_t bytes_written = send_packet(sock, (uint8_t *)packed.buf, packed.buf_len);
+    free(packed.buf);
     if (bytes_written == -1) {
         ESP_LOGE(MQTT_TAG, "Send failed!");
+        return -1;
     }
+    return bytes_written;
 }
\ No newline at end of file
@@ -199,6 +199,58 @@ int unpack_publish(mqtt_publish *publish, mqtt_header header, uint8_t **buf, siz
 }
 
 
+int peek_publish(mqtt_publish *publish, mqtt_header header, uint8_t **buf, size_t buf_size, int accumulated_size) {
+    int rc;
+    int variable_header_size = 0;
+
+    // Topic length
+    rc = unpack_uint16(buf, buf_size, &accumulated_size);
+    if (rc < 0) return OUT_OF_BOUNDS;
+    publish->topic_len = (uint16_t)rc;
+    variable_header_size += sizeof(uint16_t);
+    // Topic name
+    if (accumulated_size + publish->topic_len > (int)buf_size) return OUT_OF_BOUNDS;
+    publish->topic = (char *)*buf;
+    *buf += publish->topic_len;
+    accumulated_size += publish->topic_len;
+    variable_header_size += publish->topic_len;
+
+    // Packet ID
+    if ((header.fixed_header & PUBLISH_QOS_FLAG_MASK) != PUBLISH_QOS_0) {
+        rc = unpack_uint16(buf, buf_size, &accumulated_size);
+        if (rc == 0) return PACKET_ID_NOT_ALLOWED;
+        if (rc < 0) return OUT_OF_BOUNDS;
+        publish->pkt_id = (uint16_t)rc;
+        variable_header_size += sizeof(uint16_t);
+    }
+
+    // Payload
+    if (variable_header_size > (int)header.remaining_length) return MALFORMED_PACKET;
+    publish->payload_len = header.remaining_length - variable_header_size;
+    if (accumulated_size + publish->payload_len > buf_size) return OUT_OF_BOUNDS;
+    publish->payload = (char *)*buf;
+    *buf += publish->payload_len;
+
+    return MQTT_PUBLISH;
+}
+
+
+int peek_packet_length(const uint8_t *buf, size_t buf_len) {
+    uint32_t multiplier = 1;
+    uint32_t remaining_length = 0;
+    size_t i = 1;   // Skip the fixed header byte
+
+    do {
+        if (i >= buf_len) return 0;
+        if (i > 4) return MALFORMED_PACKET;     // Remaining Length is at most 4 bytes
+        remaining_length += (buf[i] & 127) * multiplier;
+        multiplier *= 128;
+    } while ((buf[i++] & 128) != 0);
+
+    return (int)(i + remaining_length);
+}
+
+
 int unpack_subscribe(mqtt_subscribe *subscribe, uint8_t **buf, size_t buf_size, int accumulated_size) {
     int rc;
     int subscribe_global_failure = 0;  // Flag set in case of global subscribe packet failures
@@ -534,8 +586,11 @@ packing_status pack_publish(mqtt_publish *pub, uint8_t flags) {
     // Topic Name
     CHECK(pack16(&status.buf, &status.buf_len, pub->topic_len), FAILED_MEM_ALLOC, status.return_code);
     CHECK(pack_str(&status.buf, &status.buf_len, pub->topic, pub->topic_len), FAILED_MEM_ALLOC, status.return_code);
-    // Packet ID
-    CHECK(pack16(&status.buf, &status.buf_len, pub->pkt_id), FAILED_MEM_ALLOC, status.return_code);
+    // Packet ID (only present for QoS 1 and 2)
+    if ((flags & PUBLISH_QOS_FLAG_MASK) != PUBLISH_QOS_0) {
+        CHECK(!pub->pkt_id, PACKET_ID_NOT_ALLOWED, status.return_code);
+        CHECK(pack16(&status.buf, &status.buf_len, pub->pkt_id), FAILED_MEM_ALLOC, status.return_code);
+    }
 
     /* Payload */
     if (pub->payload_len > 0) CHECK(pack_str(&status.buf, &status.buf_len, pub->payload, pub->payload_len), FAILED_MEM_ALLOC, status.return_code);
@@ -577,9 +632,9 @@ packing_status pack_subscribe(mqtt_subscribe *sub) {
     CHECK(!sub->pkt_id, MALFORMED_PACKET, status.return_code);
     CHECK(!sub->tuples_len, MALFORMED_PACKET, status.return_code);
     for (int i = 0; i < sub->tuples_len; ++i) {
-        CHECK(!sub->tuples->qos, MALFORMED_PACKET, status.return_code);
-        CHECK(!sub->tuples->topic, MALFORMED_PACKET, status.return_code);
-        CHECK(!sub->tuples->topic_len, MALFORMED_PACKET, status.return_code);
+        CHECK(sub->tuples[i].qos > QOS_2, MALFORMED_PACKET, status.return_code);
+        CHECK(!sub->tuples[i].topic, MALFORMED_PACKET, status.return_code);
+        CHECK(!sub->tuples[i].topic_len, MALFORMED_PACKET, status.return_code);
     }
     if (status.return_code) return status;
 
@@ -0,0 +1,69 @@
+#ifndef JSON_SAX_H
+#define JSON_SAX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+
+#define JSON_MAX_DEPTH          16
+
+
+typedef enum {
+    JSON_OBJECT_START,
+    JSON_OBJECT_END,
+    JSON_ARRAY_START,
+    JSON_ARRAY_END,
+    JSON_KEY,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL,
+} json_event_type;
+
+/*
+ * A single token emitted by the parser.
+ * - str/str_len point into the input buffer (no copy, not NUL terminated, escapes are validated but left as-is).
+ * - number holds NUMBER values truncated towards zero and saturated to the int32 range. The exact value is
+ *   mantissa * 10^exponent, see json_number_scaled for fixed point units.
+ * - depth is the nesting level the token belongs to (members of the top level object are at depth 1).
+ */
+typedef struct {
+    json_event_type type;
+    const char *str;
+    size_t str_len;
+    int32_t number;
+    int64_t mantissa;
+    int32_t exponent;
+    uint8_t depth;
+} json_event;
+
+typedef esp_err_t (*json_event_cb)(const json_event *event, void *ctx);
+
+
+/**
+ * @brief Single pass, allocation free JSON tokenizer.
+ *
+ * Validates the document structure and invokes the callback once per token, in document order.
+ *
+ * @param[in] buf Input buffer (does not need to be NUL terminated).
+ * @param[in] len Length of the input buffer.
+ * @param[in] cb Callback invoked for every token. Returning anything other than ESP_OK aborts the parse.
+ * @param[in] ctx User context forwarded to the callback.
+ * @return
+ *      - ESP_OK if the whole document was parsed
+ *      - ESP_ERR_INVALID_ARG for malformed JSON
+ *      - ESP_ERR_INVALID_SIZE if the document is truncated or nested deeper than JSON_MAX_DEPTH
+ *      - Any error returned by the callback
+ */
+esp_err_t json_sax_parse(const char *buf, size_t len, json_event_cb cb, void *ctx);
+
+/**
+ * @brief Value of a NUMBER event times 10^decimals, truncated towards zero and saturated to the int32 range.
+ *
+ * E.g. decimals = 3 reads seconds as milliseconds, so "0.4" yields 400 where `number` holds 0.
+ */
+int32_t json_number_scaled(const json_event *ev, int decimals);
+
+#endif
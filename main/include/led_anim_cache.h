@@ -0,0 +1,88 @@
+#ifndef LED_ANIM_CACHE_H
+#define LED_ANIM_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+
+#define LED_ANIM_PARTITION_LABEL        "anim"
+#define LED_ANIM_PARTITION_SUBTYPE      0x40
+#define LED_ANIM_SLOTS                  4           // The partition is split into this many equally sized clips
+#define LED_ANIM_MIN_INTERVAL_MS        10
+
+
+/*
+ * Animation clips cached in flash and played back straight out of the memory mapped partition.
+ *
+ * A clip is a sequence of frames, each a big endian 16 bit length followed by a led_frame_codec frame. The
+ * first frame must be a keyframe so the clip can loop. Clips are uploaded in chunks over MQTT, one message
+ * per operation:
+ *
+ *  ANIM_OP_BEGIN   [op] [slot] [size, be32] [frame count, be16] [frame interval ms, be16]
+ *  ANIM_OP_DATA    [op] [slot] [offset, be32] [data ...]
+ *  ANIM_OP_END     [op] [slot] [CRC-32 of the clip, be32]
+ *  ANIM_OP_PLAY    [op] [slot] [ANIM_PLAY_LOOP or 0]
+ *  ANIM_OP_STOP    [op]
+ *
+ * BEGIN erases the slot, DATA chunks must follow in order (repeated chunks are ignored) and END only marks
+ * the clip valid if the CRC matches and every frame length lines up. A rejected message is answered on the
+ * status topic with
+ *
+ *  [op] [slot] [esp_err_t, be32] [bytes of the current upload stored so far, be32]
+ *
+ * so the uploader can resend from the last stored byte or start over. Playback skips frames while a slot is
+ * being erased.
+ */
+
+#define ANIM_OP_BEGIN                   0
+#define ANIM_OP_DATA                    1
+#define ANIM_OP_END                     2
+#define ANIM_OP_PLAY                    3
+#define ANIM_OP_STOP                    4
+
+#define ANIM_PLAY_LOOP                  0x01
+
+#define ANIM_STATUS_LEN                 10
+
+
+/**
+ * @brief Finds the animation partition and creates the playback timer and task.
+ *
+ * @return
+ *      - ESP_ERR_NOT_FOUND if the partition table has no animation partition
+ *      - ESP_ERR_NO_MEM if the lock or the play task could not be created
+ *      - ESP_OK on success
+ */
+esp_err_t led_anim_init(void);
+
+/**
+ * @brief Handles one upload or playback control message (see the operations above).
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG for malformed messages or an invalid slot
+ *      - ESP_ERR_INVALID_STATE for chunks outside an upload, or playing an empty slot
+ *      - ESP_ERR_INVALID_SIZE if a clip doesn't fit its slot or its chunks don't line up
+ *      - ESP_ERR_INVALID_CRC if an uploaded clip is corrupt
+ *      - flash and mmap errors
+ *      - ESP_OK on success
+ */
+esp_err_t led_anim_handle_message(const uint8_t *payload, size_t len);
+
+/**
+ * @brief Bytes of the upload in progress written so far, 0 if there is none.
+ */
+uint32_t led_anim_upload_written(void);
+
+/**
+ * @brief Plays the clip in `slot` from its first frame, at its frame interval.
+ */
+esp_err_t led_anim_play(uint8_t slot, bool loop);
+
+/**
+ * @brief Stops playback, the last frame stays up.
+ */
+void led_anim_stop(void);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef LED_CLOCK_SYNC_H
+#define LED_CLOCK_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#define CLOCK_SYNC_PORT                 123     // Plain (S)NTP, any NTP server on the show controller works
+#define CLOCK_SYNC_INTERVAL_MS          2000
+#define CLOCK_SYNC_FILTER_SIZE          8       // Samples the minimum round trip filter picks from
+
+
+typedef struct {
+    bool synced;
+    int64_t offset_us;      // Server time - local esp_timer time
+    uint32_t rtt_us;        // Round trip of the sample the offset was taken from
+    uint32_t samples;
+    uint32_t failures;
+} led_clock_stats_t;
+
+
+/**
+ * @brief Task keeping the local clock offset to an NTP server up to date.
+ *
+ * Each exchange yields an offset and a round trip time. Wi-Fi delays are asymmetric and bursty, so the offset
+ * of the sample with the smallest round trip out of the last CLOCK_SYNC_FILTER_SIZE is used: its error is
+ * bounded by half of that round trip.
+ *
+ * @param[in] arg Server IPv4 address as a string.
+ */
+void process_clock_sync(void *arg);
+
+/**
+ * @brief Feeds one NTP exchange into the offset filter. Called by the clock sync task.
+ *
+ * @param[in] t0_us Request sent, local esp_timer time.
+ * @param[in] t1_us Request received, server time.
+ * @param[in] t2_us Response sent, server time.
+ * @param[in] t3_us Response received, local esp_timer time.
+ */
+void led_clock_add_exchange(int64_t t0_us, int64_t t1_us, int64_t t2_us, int64_t t3_us);
+
+/**
+ * @brief Counts an exchange that timed out or was refused.
+ */
+void led_clock_add_failure(void);
+
+/**
+ * @brief Converts a DDP timecode (the middle 32 bits of an NTP timestamp, 16.16 seconds) into local
+ *        esp_timer time.
+ *
+ * The timecode only covers 18 hours, it is taken to be the instance closest to the current time.
+ *
+ * @param[in] timecode Timecode in network time.
+ * @param[out] local_us Same instant in esp_timer microseconds.
+ * @return false if the clock isn't synchronized yet.
+ */
+bool led_clock_from_timecode(uint32_t timecode, int64_t *local_us);
+
+led_clock_stats_t led_clock_sync_get_stats(void);
+
+#endif
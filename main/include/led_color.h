@@ -0,0 +1,46 @@
+#ifndef LED_COLOR_H
+#define LED_COLOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define LED_HUE_DEGREES(deg)            ((uint16_t)((uint32_t)(deg) % 360 * 65536 / 360))
+
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} led_rgb_t;
+
+
+/**
+ * @brief Scales `value` by `scale` / 255, exact at both ends (scale 255 returns value, 0 returns 0).
+ */
+static inline uint8_t led_scale8(uint8_t value, uint8_t scale) {
+    return ((uint16_t)value * (scale + 1)) >> 8;
+}
+
+/**
+ * @brief Integer HSV to RGB conversion.
+ *
+ * @param[in] hue Full circle in 16 bits, 0 = red, 21845 = green, 43690 = blue (see LED_HUE_DEGREES).
+ * @param[in] sat Saturation, 0 - 255.
+ * @param[in] val Value, 0 - 255.
+ */
+led_rgb_t led_hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val);
+
+/**
+ * @brief Sets `count` pixels of an RGB frame, starting at pixel `first`, to one color.
+ */
+void led_fill_solid(uint8_t *frame, size_t first, size_t count, led_rgb_t color);
+
+/**
+ * @brief Fills `count` pixels of an RGB frame with a hue gradient, starting at `hue` and
+ *        advancing by `hue_step` (16 bit hue units, wrapping) per pixel.
+ */
+void led_fill_gradient(uint8_t *frame, size_t first, size_t count, uint16_t hue, int32_t hue_step,
+                       uint8_t sat, uint8_t val);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef LED_COMPOSITOR_H
+#define LED_COMPOSITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "led_color.h"
+
+
+#define LED_LAYER_MAX_SPANS             4       // Dirty spans tracked per layer, more are merged
+
+
+typedef enum {
+    LED_LAYER_BASE,             // Effect or color, opaque
+    LED_LAYER_OVERLAY,          // Highlights, e.g. on motion
+    LED_LAYER_NOTIFY,           // Notifications, on top
+    LED_LAYER_COUNT,
+} led_layer_id_t;
+
+typedef enum {
+    LED_BLEND_NORMAL,           // Covers the layers below by alpha
+    LED_BLEND_ADD,              // Brightens, saturating
+    LED_BLEND_MULTIPLY,         // Darkens, black stays black and white leaves the layers below as they are
+} led_blend_t;
+
+
+/*
+ * Stack of RGB layers on the logical grid, composited bottom to top into one frame.
+ *
+ * Every layer has an alpha value per pixel and a blend mode and opacity for the whole layer. Writes to a layer
+ * mark the pixels they touched as a dirty span, and led_compositor_compose only recomposites the union of the
+ * dirty spans of all layers into the frame it keeps, so a static overlay on an animated base costs nothing
+ * where the base doesn't change. Showing, hiding or changing the blend of a layer dirties all of it. Overlays
+ * start hidden, blending normally at full opacity.
+ *
+ * Only the render loop may call these.
+ */
+
+/**
+ * @brief Sets how a layer blends onto the ones below. Ignored for the base layer.
+ */
+void led_layer_set_blend(led_layer_id_t layer, led_blend_t blend, uint8_t opacity);
+
+/**
+ * @brief Shows or hides an overlay. Hidden layers keep their pixels.
+ *
+ * @return true if the visibility changed.
+ */
+bool led_layer_show(led_layer_id_t layer, bool visible);
+
+/**
+ * @brief Sets `count` pixels of a layer, starting at pixel `first`, to one color and alpha.
+ */
+void led_layer_fill(led_layer_id_t layer, size_t first, size_t count, led_rgb_t color, uint8_t alpha);
+
+/**
+ * @brief Copies a full frame into an opaque layer, only marking the pixels that differ as dirty.
+ *
+ * @param[in] pixels RGB frame (LED_FRAME_BYTES), or LED_COUNT palette indices if `palette` is set.
+ * @param[in] palette Colors of an indexed frame, NULL for RGB.
+ */
+void led_layer_update(led_layer_id_t layer, const uint8_t *pixels, const led_rgb_t *palette);
+
+/**
+ * @brief RGB pixels and alpha values of a layer, for drawing into directly; mark what was drawn with
+ *        led_layer_mark.
+ */
+uint8_t *led_layer_pixels(led_layer_id_t layer);
+
+uint8_t *led_layer_alpha(led_layer_id_t layer);
+
+void led_layer_mark(led_layer_id_t layer, size_t first, size_t count);
+
+/**
+ * @brief true while any layer above the base is shown.
+ */
+bool led_compositor_active(void);
+
+/**
+ * @brief Recomposites the dirty spans and copies the composited frame to `out` (LED_FRAME_BYTES, RGB).
+ *
+ * @return Number of pixels recomposited.
+ */
+size_t led_compositor_compose(uint8_t *out);
+
+#endif
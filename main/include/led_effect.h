@@ -0,0 +1,88 @@
+#ifndef LED_EFFECT_H
+#define LED_EFFECT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#include "led_color.h"
+
+
+#define LED_EFFECT_STATE_BYTES          1024    // Largest per effect state
+#define LED_EFFECT_SPLIT_MIN_PIXELS     512     // Below this a core hand-off costs more than it saves
+#define LED_EFFECT_PALETTE_SIZE         256
+
+
+typedef enum {
+    LED_EFFECT_NONE,            // Plain solid color
+    LED_EFFECT_CHASE,
+    LED_EFFECT_RAINBOW,
+    LED_EFFECT_BREATHE,
+    LED_EFFECT_FIRE,
+    LED_EFFECT_PLASMA,
+    LED_EFFECT_TEXT,
+    LED_EFFECT_PROGRAM,         // Bytecode uploaded with led_effect_load_program
+    LED_EFFECT_COUNT,
+} led_effect_id_t;
+
+typedef struct {
+    led_rgb_t color;            // Device color, unscaled
+    const char *text;           // NUL terminated, for the text effect
+} led_effect_params_t;
+
+/*
+ * An effect renders into a canvas (RGB frame) that persists across frames, so it only has to write
+ * the pixels that changed since its previous render.
+ *
+ *  init    Resets the state. The canvas has been cleared to black.
+ *  step    Advances the state by `elapsed_ms`; returns true if any pixel changes.
+ *  render  Writes the changed pixels within [first, first + count). With `parallel` set it may be called for
+ *          two halves of the strip concurrently, so it must not modify the state.
+ *  palette Set for indexed effects: their canvas holds one palette index per pixel and this writes the
+ *          palette after every step that changed something. Animating the palette alone changes the whole
+ *          strip for 256 colors' worth of work.
+ */
+typedef struct {
+    const char *name;
+    size_t state_size;
+    bool parallel;
+    void (*init)(void *state, const led_effect_params_t *params);
+    bool (*step)(void *state, const led_effect_params_t *params, uint32_t elapsed_ms);
+    void (*render)(uint8_t *canvas, size_t first, size_t count, void *state);
+    void (*palette)(led_rgb_t *palette, const void *state);
+} led_effect_t;
+
+
+/**
+ * @brief Looks up an effect by name.
+ *
+ * @return The effect id, or -1 if there is no such effect.
+ */
+int led_effect_find(const char *name, size_t len);
+
+const char *led_effect_name(uint8_t id);
+
+/**
+ * @brief Advances `id` to the current time and writes the resulting frame to `out`.
+ *
+ * Switching to another effect restarts it on a black canvas.
+ *
+ * @param[in] id Effect to render, not LED_EFFECT_NONE.
+ * @param[in] params Current parameters.
+ * @param[out] out RGB frame (LED_FRAME_BYTES), or LED_COUNT palette indices for an indexed effect.
+ * @param[out] palette LED_EFFECT_PALETTE_SIZE colors, only written for an indexed effect.
+ * @return true if the effect is indexed.
+ */
+bool led_effect_render_frame(uint8_t id, const led_effect_params_t *params, uint8_t *out, led_rgb_t *palette);
+
+/**
+ * @brief Verifies a led_vm program and hands it to the "program" effect, which restarts with it on its next
+ *        frame. Safe to call from any task.
+ *
+ * @return The led_vm_load errors, ESP_OK on success.
+ */
+esp_err_t led_effect_load_program(const uint8_t *data, size_t len);
+
+#endif
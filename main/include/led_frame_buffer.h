@@ -0,0 +1,62 @@
+#ifndef LED_FRAME_BUFFER_H
+#define LED_FRAME_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#include "led_pixel_format.h"
+
+
+#define LED_COUNT                       300
+#define LED_FRAME_BYTES                 (LED_COUNT * LED_PIXEL_BYTES)   // RGB, encoded for LED_CHIP on the way out
+
+
+/*
+ * Triple buffered frame store between frame producers (network) and the render loop.
+ *
+ * Producers always write into the back buffer, the render loop always owns the front buffer and the third
+ * buffer holds the newest complete frame. The render loop never waits for a producer: a producer running
+ * faster than the render loop simply replaces the pending frame.
+ *
+ * The back buffer keeps its contents across begin/end pairs that don't commit, so a frame may be assembled
+ * from several packets. After a commit it holds an older frame: producers either rewrite it completely
+ * (led_fb_begin_write) or start from a copy of the newest frame (led_fb_begin_update).
+ */
+
+/**
+ * @brief Allocates the synchronization primitives. Must be called before any producer starts.
+ *
+ * @return
+ *      - ESP_ERR_NO_MEM if the semaphores could not be created
+ *      - ESP_OK on success
+ */
+esp_err_t led_fb_init(void);
+
+/**
+ * @brief Locks the back buffer for the calling producer and returns it.
+ */
+uint8_t *led_fb_begin_write(void);
+
+/**
+ * @brief Like led_fb_begin_write, but the back buffer is brought up to date with the newest committed frame
+ *        first, so the producer only has to write what changed.
+ */
+uint8_t *led_fb_begin_update(void);
+
+/**
+ * @brief Unlocks the back buffer.
+ *
+ * @param[in] commit true to make the back buffer the newest frame, false to keep assembling it.
+ */
+void led_fb_end_write(bool commit);
+
+/**
+ * @brief Takes the newest committed frame for the render loop.
+ *
+ * @return The frame, or NULL if no new frame was committed since the previous call. The returned buffer
+ *         stays untouched until the next call.
+ */
+const uint8_t *led_fb_take_latest(void);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef LED_FRAME_CODEC_H
+#define LED_FRAME_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+
+/*
+ * Compressed frame format, 3 byte RGB pixels:
+ *
+ *  [flags] [op] [op] ...
+ *
+ * flags: FRAME_CODEC_KEYFRAME -> ops apply onto a black frame, otherwise onto the previous frame.
+ * op:    top 2 bits select the operation, low 6 bits the pixel count - 1 (1 - 63). A count field of 0x3F
+ *        is followed by an extension byte and the count becomes 64 + extension (64 - 319).
+ *
+ *  FRAME_OP_SKIP   n pixels stay unchanged               (no data)
+ *  FRAME_OP_COPY   n pixels are replaced                 (3 * n bytes)
+ *  FRAME_OP_FILL   n pixels are set to one color         (3 bytes)
+ *  FRAME_OP_XOR    n pixels are XORed with a mask        (3 * n bytes)
+ *
+ * Pixels past the last op stay unchanged.
+ */
+
+#define FRAME_CODEC_KEYFRAME        0x01
+
+#define FRAME_OP_MASK               0xC0
+#define FRAME_OP_SKIP               0x00
+#define FRAME_OP_COPY               0x40
+#define FRAME_OP_FILL               0x80
+#define FRAME_OP_XOR                0xC0
+#define FRAME_OP_COUNT_MASK         0x3F
+#define FRAME_OP_MAX_COUNT          (64 + 255)
+
+
+/**
+ * @brief Applies an encoded frame onto `frame`.
+ *
+ * The whole payload is validated before the first pixel is touched, so a malformed payload leaves the frame
+ * as it was.
+ *
+ * @param[in] data Encoded frame.
+ * @param[in] len Length of the encoded frame.
+ * @param[in,out] frame Frame to apply the ops to (the previous frame for delta frames).
+ * @param[in] frame_bytes Size of the frame in bytes.
+ * @return
+ *      - ESP_ERR_INVALID_SIZE if the payload is truncated or addresses pixels past the end of the frame
+ *      - ESP_OK on success
+ */
+esp_err_t led_frame_decode(const uint8_t *data, size_t len, uint8_t *frame, size_t frame_bytes);
+
+/**
+ * @brief Encodes `frame`, as a delta against `prev` or as a keyframe if `prev` is NULL.
+ *
+ * @param[in] frame Frame to encode.
+ * @param[in] prev Frame the receiver currently shows, or NULL.
+ * @param[in] frame_bytes Size of both frames in bytes.
+ * @param[out] out Output buffer.
+ * @param[in] out_len Size of the output buffer.
+ * @return Encoded length, or 0 if the output buffer is too small.
+ */
+size_t led_frame_encode(const uint8_t *frame, const uint8_t *prev, size_t frame_bytes, uint8_t *out, size_t out_len);
+
+#endif
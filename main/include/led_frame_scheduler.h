@@ -0,0 +1,64 @@
+#ifndef LED_FRAME_SCHEDULER_H
+#define LED_FRAME_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+
+typedef struct {
+    uint32_t target_fps;            // Frame clock rate, the render loop wakes at most this often unless woken
+} led_sched_config_t;
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t frames_rendered;
+    uint32_t frames_skipped;        // Ticks with nothing to show
+    uint64_t idle_us;               // Time the render loop spent waiting for a tick
+    uint64_t busy_us;               // Time the render loop spent between ticks
+} led_sched_stats_t;
+
+
+/*
+ * Fixed cadence frame clock for the render loop.
+ *
+ * An esp_timer wakes the render loop at the target rate; it renders and transmits only if something marked
+ * the frame dirty since the last frame and otherwise goes straight back to sleep. Producers with their own
+ * timing (presentation timestamped frames) can wake it ahead of the next tick.
+ */
+
+/**
+ * @brief Starts the frame clock. Must be called from the render task, which is the one woken by it.
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG if the target rate is 0
+ *      - esp_timer errors
+ *      - ESP_OK on success
+ */
+esp_err_t led_sched_init(const led_sched_config_t *config);
+
+/**
+ * @brief Marks the frame dirty, it is rendered on the next tick. Safe to call from any task.
+ */
+void led_sched_mark_dirty(void);
+
+/**
+ * @brief Marks the frame dirty and wakes the render loop right away instead of on the next tick.
+ */
+void led_sched_render_now(void);
+
+/**
+ * @brief Blocks until the next tick (or wake up).
+ *
+ * @return true if the frame is dirty, which also clears the flag.
+ */
+bool led_sched_wait_frame(void);
+
+/**
+ * @brief Books the current tick as a rendered or skipped frame.
+ */
+void led_sched_end_frame(bool rendered);
+
+led_sched_stats_t led_sched_get_stats(void);
+
+#endif
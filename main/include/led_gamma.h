@@ -0,0 +1,51 @@
+#ifndef LED_GAMMA_H
+#define LED_GAMMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+
+#define LED_GAMMA_LINEAR                0       // Curves come from LED_GAMMA_CURVES in main/CMakeLists.txt,
+#define LED_GAMMA_DEFAULT               1       // linear always first, then the configured ones in order
+
+
+typedef struct {
+    uint16_t levels[256];       // 8.8 fixed point output level per channel value
+    uint8_t dither_offset;      // Added to the levels of the first pixel
+    uint8_t dither_stride;      // Added to the offset for every further pixel, 0 without dithering
+} led_gamma_lut_t;
+
+/*
+ * Output stage: gamma correction and brightness in a single per channel lookup, plus optional temporal
+ * dithering.
+ *
+ * The gamma curves are generated at build time (scripts/generate_gamma_lut.py) as 8.8 fixed point tables.
+ * led_gamma_set folds the brightness into a copy of the selected curve, so applying both costs one load per
+ * channel. The table travels with the frame to the strip encoder, which applies it while encoding instead of
+ * in a separate pass over the frame. With dithering, the fraction below one output step is spread over
+ * successive frames, which recovers the low levels that an 8 bit curve collapses onto 0 and 1. The fraction
+ * only averages out while frames keep coming, so a dithered static scene never lets the frame clock idle.
+ */
+
+/**
+ * @brief Selects the curve and brightness the next frames are corrected with. Cheap enough to call every
+ *        frame, the table is only rebuilt when either changes.
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG for an unknown curve
+ *      - ESP_OK on success
+ */
+esp_err_t led_gamma_set(uint8_t curve, uint8_t brightness);
+
+/**
+ * @brief Copies the current table, and the dither offsets of the next frame, into `lut`.
+ *
+ * @param[out] lut Table the next frame is encoded with.
+ * @param[in] dither Spread sub step levels over frames.
+ * @return true if dithering needs further frames to show the same picture (the caller should keep rendering).
+ */
+bool led_gamma_prepare(led_gamma_lut_t *lut, bool dither);
+
+#endif
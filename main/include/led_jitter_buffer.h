@@ -0,0 +1,53 @@
+#ifndef LED_JITTER_BUFFER_H
+#define LED_JITTER_BUFFER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+
+#define LED_JB_SLOTS                    6
+#define LED_JB_MAX_LEAD_US              2000000     // Frames scheduled further ahead point at a clock problem
+
+
+typedef struct {
+    uint32_t scheduled;
+    uint32_t presented;
+    uint32_t late;              // Arrived after their presentation time, presented immediately
+    uint32_t superseded;        // Never presented, a newer frame was due at the same time
+    uint32_t overflow;          // Dropped, every slot was taken
+    uint32_t rejected;          // Dropped, presentation time too far ahead
+    int32_t max_release_error_us;   // Largest delay between presentation time and release so far
+} led_jb_stats_t;
+
+
+/*
+ * Presentation timestamped frames waiting for their time.
+ *
+ * Frames are held until their presentation time (local esp_timer time, see led_clock_from_timecode) and are
+ * then committed into the frame buffer by a release task the timer wakes, which wakes the render loop right away.
+ * Strips sharing a clock thus show the same frame at the same instant regardless of when it arrived.
+ */
+
+/**
+ * @brief Creates the release timer and task. Must be called after led_fb_init and before the first push.
+ *
+ * @return
+ *      - ESP_ERR_NO_MEM if the lock or the task could not be created
+ *      - esp_timer_create errors
+ *      - ESP_OK on success
+ */
+esp_err_t led_jb_init(void);
+
+/**
+ * @brief Queues a copy of `frame` (LED_FRAME_BYTES, RGB) for presentation at `pts_us`.
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG if the presentation time is more than LED_JB_MAX_LEAD_US ahead
+ *      - ESP_ERR_NO_MEM if every slot is taken
+ *      - ESP_OK on success
+ */
+esp_err_t led_jb_push(const uint8_t *frame, int64_t pts_us);
+
+led_jb_stats_t led_jb_get_stats(void);
+
+#endif
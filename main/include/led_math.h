@@ -0,0 +1,103 @@
+#ifndef LED_MATH_H
+#define LED_MATH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * Integer math for effects: everything a per pixel, per frame effect needs without touching float.
+ *
+ * Angles are a full turn in 16 bits (16384 is 90 degrees), sines come back as signed 1.15 fixed point from a
+ * quarter wave table with linear interpolation (error below 2^-13). Noise coordinates are 8.8 fixed point with
+ * the lattice on whole numbers, so neighbouring pixels one unit apart get unrelated values and smaller steps
+ * give smooth gradients.
+ */
+
+typedef struct {
+    uint32_t state;             // Never 0
+} led_rng_t;
+
+
+/**
+ * @brief Sine of `angle`, -32767 - 32767.
+ */
+int16_t led_sin16(uint16_t angle);
+
+static inline int16_t led_cos16(uint16_t angle) {
+    return led_sin16(angle + 16384);
+}
+
+/**
+ * @brief Sine of `theta` (a full turn in 8 bits) mapped to 0 - 255, 128 at theta 0.
+ */
+static inline uint8_t led_sin8(uint8_t theta) {
+    return (led_sin16(theta << 8) >> 8) + 128;
+}
+
+static inline uint8_t led_cos8(uint8_t theta) {
+    return led_sin8(theta + 64);
+}
+
+/**
+ * @brief 1D value noise at `x` (8.8 fixed point), 0 - 255.
+ */
+uint8_t led_noise8(uint16_t x);
+
+/**
+ * @brief 2D value noise at (`x`, `y`) (8.8 fixed point), 0 - 255.
+ */
+uint8_t led_noise8_2d(uint16_t x, uint16_t y);
+
+
+/**
+ * @brief Scales `value` by `scale` / 65535, exact at both ends.
+ */
+static inline uint16_t led_scale16(uint16_t value, uint16_t scale) {
+    return ((uint32_t)value * (scale + 1u)) >> 16;
+}
+
+/**
+ * @brief Product of two signed 1.15 fixed point values.
+ */
+static inline int16_t led_mul_q15(int16_t a, int16_t b) {
+    return ((int32_t)a * b) >> 15;
+}
+
+/**
+ * @brief Moves `from` towards `to` by `amount` / 255, rounded to nearest; 0 keeps `from`, 255 lands on `to`.
+ */
+static inline uint8_t led_lerp8(uint8_t from, uint8_t to, uint8_t amount) {
+    // Unsigned, so moving down rounds like moving up. The division by a constant compiles to a multiply.
+    return ((uint32_t)from * (255u - amount) + (uint32_t)to * amount + 127) / 255;
+}
+
+
+static inline void led_rng_seed(led_rng_t *rng, uint32_t seed) {
+    rng->state = seed ? seed : 0x2545F491;
+}
+
+/**
+ * @brief Next value of a xorshift32 generator: three shifts and three xors, period 2^32 - 1.
+ */
+static inline uint32_t led_rng_next(led_rng_t *rng) {
+    uint32_t x = rng->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng->state = x;
+    return x;
+}
+
+static inline uint8_t led_random8(led_rng_t *rng) {
+    return led_rng_next(rng) >> 24;       // The high bits are the better mixed ones
+}
+
+/**
+ * @brief Uniform value in [0, `range`), by multiplication rather than a division.
+ */
+static inline uint32_t led_random_below(led_rng_t *rng, uint32_t range) {
+    return ((uint64_t)led_rng_next(rng) * range) >> 32;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef LED_PIXEL_FORMAT_H
+#define LED_PIXEL_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "led_color.h"
+
+
+/*
+ * Pixel formats, fixed at build time by LED_CHIP in main/CMakeLists.txt.
+ *
+ * Frames are always rendered in RGB, LED_PIXEL_BYTES per pixel, whatever the strip takes; effects, streams and
+ * the compositor never see the wire format. The chip decides what the encoders send for every pixel: the
+ * channel order, a white channel split off the output levels, 8 or 16 bits per channel, and the bit timing. All
+ * of it is constant, so every encoder compiles into one loop for the selected chip, without a per pixel
+ * branch or order lookup.
+ */
+
+#define LED_CHIP_WS2812                 0       // GRB, 8 bit
+#define LED_CHIP_WS2811                 1       // RGB, 8 bit, 800 kHz mode
+#define LED_CHIP_SK6812_RGBW            2       // GRBW, 8 bit
+#define LED_CHIP_UCS8903                3       // RGB, 16 bit
+
+#ifndef LED_CHIP
+#define LED_CHIP                        LED_CHIP_WS2812
+#endif
+
+#if LED_CHIP == LED_CHIP_WS2812
+#define LED_WIRE_ORDER                  1, 0, 2     // Channel sent at each wire position: R 0, G 1, B 2, W 3
+#define LED_WIRE_WHITE                  0
+#define LED_WIRE_BITS                   8
+#define LED_T0H_NS                      300
+#define LED_T0L_NS                      900
+#define LED_T1H_NS                      900
+#define LED_T1L_NS                      300
+#define LED_RESET_US                    50
+#elif LED_CHIP == LED_CHIP_WS2811
+#define LED_WIRE_ORDER                  0, 1, 2
+#define LED_WIRE_WHITE                  0
+#define LED_WIRE_BITS                   8
+#define LED_T0H_NS                      250
+#define LED_T0L_NS                      1000
+#define LED_T1H_NS                      600
+#define LED_T1L_NS                      650
+#define LED_RESET_US                    50
+#elif LED_CHIP == LED_CHIP_SK6812_RGBW
+#define LED_WIRE_ORDER                  1, 0, 2, 3
+#define LED_WIRE_WHITE                  1
+#define LED_WIRE_BITS                   8
+#define LED_T0H_NS                      300
+#define LED_T0L_NS                      900
+#define LED_T1H_NS                      600
+#define LED_T1L_NS                      600
+#define LED_RESET_US                    80
+#elif LED_CHIP == LED_CHIP_UCS8903
+#define LED_WIRE_ORDER                  0, 1, 2
+#define LED_WIRE_WHITE                  0
+#define LED_WIRE_BITS                   16
+#define LED_T0H_NS                      400
+#define LED_T0L_NS                      850
+#define LED_T1H_NS                      850
+#define LED_T1L_NS                      400
+#define LED_RESET_US                    280
+#else
+#error "Unknown LED_CHIP"
+#endif
+
+#define LED_PIXEL_BYTES                 3       // Frames: RGB
+#define LED_WIRE_CHANNELS               (3 + LED_WIRE_WHITE)
+#define LED_WIRE_BYTES                  (LED_WIRE_CHANNELS * LED_WIRE_BITS / 8)     // Per pixel on the wire
+#define LED_WIRE_BIT_NS                 (LED_T0H_NS + LED_T0L_NS)
+
+
+static inline void led_pixel_store(uint8_t *pixel, led_rgb_t color) {
+    pixel[0] = color.r;
+    pixel[1] = color.g;
+    pixel[2] = color.b;
+}
+
+/**
+ * @brief Wire bytes of one pixel: channels looked up in `levels`, white split off, in wire order.
+ *
+ * The white split works on output levels, not on channel values: light adds up linearly after the gamma
+ * curve, so the white LED takes the level all three colors share and each color LED the rest of its own.
+ *
+ * @param[in] rgb Pixel as rendered.
+ * @param[in] levels 8.8 fixed point output level for each of the 256 channel values.
+ * @param[in] offset Dither offset added below the output step. 16 bit chips take the whole level instead.
+ * @param[out] out LED_WIRE_BYTES bytes, most significant byte first.
+ */
+static inline void led_wire_pixel(const uint8_t *rgb, const uint16_t *levels, uint8_t offset, uint8_t *out) {
+    static const uint8_t order[LED_WIRE_CHANNELS] = { LED_WIRE_ORDER };
+#if LED_WIRE_WHITE
+    uint16_t r = levels[rgb[0]];
+    uint16_t g = levels[rgb[1]];
+    uint16_t b = levels[rgb[2]];
+    uint16_t white = r < g ? r : g;
+    if (b < white) white = b;
+    const uint16_t channels[4] = { r - white, g - white, b - white, white };
+#else
+    const uint16_t channels[3] = { levels[rgb[0]], levels[rgb[1]], levels[rgb[2]] };
+#endif
+    for (int i = 0; i < LED_WIRE_CHANNELS; ++i) {
+        uint16_t level = channels[order[i]];
+#if LED_WIRE_BITS == 16
+        out[2 * i] = level >> 8;
+        out[2 * i + 1] = level;
+        (void)offset;
+#else
+        out[i] = (level + offset) >> 8;
+#endif
+    }
+}
+
+#endif
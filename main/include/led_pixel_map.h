@@ -0,0 +1,62 @@
+#ifndef LED_PIXEL_MAP_H
+#define LED_PIXEL_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+
+#define LED_MAP_NONE                    0xFFFF
+
+
+typedef enum {
+    LED_MAP_LINEAR,             // Logical order is wiring order, a 1 pixel high row
+    LED_MAP_MATRIX,             // Strip folded into rows
+    LED_MAP_CUSTOM,             // Positions from pixel_map.csv (scripts/generate_pixel_map.py)
+} led_map_layout_t;
+
+typedef struct {
+    led_map_layout_t layout;
+    uint16_t width;             // Matrix: LEDs per wired row
+    uint16_t height;            // Matrix: wired rows
+    bool serpentine;            // Matrix: every other row is wired backwards
+    uint8_t rotation;           // Matrix: quarter turns clockwise from the wired rows to the logical grid
+} led_map_config_t;
+
+
+/*
+ * Mapping from the logical frame effects render into to the physical LED order.
+ *
+ * The logical frame is a width x height grid stored row by row, pixel (x, y) at index y * width + x, and has
+ * to fit into LED_COUNT pixels. At init a table is built holding the logical index of every physical LED. The
+ * table travels with the frame to the strip encoder, which gathers each LED's pixel through it while encoding,
+ * so mapping adds no pass over the frame. Streamed frames are sent in wiring order and are not mapped.
+ */
+
+/**
+ * @brief Builds the mapping table.
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG for an unknown layout, a rotation above 3 or an empty grid
+ *      - ESP_ERR_INVALID_SIZE if the grid doesn't fit into LED_COUNT pixels or the custom map doesn't list
+ *        LED_COUNT LEDs
+ *      - ESP_OK on success
+ */
+esp_err_t led_map_init(const led_map_config_t *config);
+
+/**
+ * @brief Logical index of every physical LED, or NULL for the linear layout.
+ */
+const uint16_t *led_map_table(void);
+
+uint16_t led_map_width(void);
+
+uint16_t led_map_height(void);
+
+/**
+ * @brief Logical index of (x, y), or LED_MAP_NONE outside the grid.
+ */
+uint16_t led_map_index(int x, int y);
+
+#endif
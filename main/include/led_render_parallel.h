@@ -0,0 +1,47 @@
+#ifndef LED_RENDER_PARALLEL_H
+#define LED_RENDER_PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+
+#define LED_NET_CORE                    0       // Wi-Fi, lwIP, esp_timer and the network tasks
+#define LED_RENDER_CORE                 1       // Render loop and the RMT interrupt
+#define LED_CORE_COUNT                  2
+
+#define LED_RENDER_WORKER_PRIORITY      19      // Above lwIP (18): a frame has a deadline, a packet can wait a span
+
+
+/**
+ * @brief Renders pixels [first, first + count) of `frame`. Must only touch that span.
+ */
+typedef void (*led_span_render_fn)(uint8_t *frame, size_t first, size_t count, void *ctx);
+
+typedef struct {
+    uint32_t split_frames;
+    uint64_t span_us[LED_CORE_COUNT];       // Time spent rendering spans, per core
+    uint8_t load_percent[LED_CORE_COUNT];   // Core utilization since the previous led_render_get_stats call
+} led_render_stats_t;
+
+
+/**
+ * @brief Starts the render worker on the network core.
+ *
+ * @return
+ *      - ESP_ERR_NO_MEM if the worker or its semaphores could not be created
+ *      - ESP_OK on success
+ */
+esp_err_t led_render_parallel_init(void);
+
+/**
+ * @brief Renders `count` pixels with `fn`, the first half on the network core and the second half on the
+ *        calling core. Returns once both halves are done.
+ *
+ * Only worth it for effects whose per pixel cost dwarfs the two context switches of the hand-off.
+ */
+void led_render_split(led_span_render_fn fn, uint8_t *frame, size_t count, void *ctx);
+
+led_render_stats_t led_render_get_stats(void);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef LED_SPRITE_H
+#define LED_SPRITE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "led_color.h"
+
+
+#define LED_SPRITE_HEIGHT               8
+#define LED_TEXT_SPACING                1       // Blank columns between glyphs
+
+
+typedef struct {
+    const uint8_t *columns;     // One byte per column, bit 0 is the top row
+    uint8_t width;
+} led_sprite_t;
+
+
+/*
+ * Text and icons for matrix fixtures.
+ *
+ * The font and the icons are rasterized at build time (scripts/generate_glyph_atlas.py) into a single table of
+ * 8 pixel high, 1 bit columns, so a glyph is a few bytes and drawing it needs no rasterization. Blits go into
+ * an RGB frame on the logical grid of led_pixel_map.h, are clipped to it, and blend the sprite's color over
+ * what is already there by `alpha`.
+ */
+
+/**
+ * @brief Looks up an icon by name.
+ *
+ * @return false if there is no such icon.
+ */
+bool led_sprite_find(const char *name, size_t len, led_sprite_t *sprite);
+
+/**
+ * @brief Glyph of `c`, '?' for characters the font doesn't have.
+ */
+led_sprite_t led_sprite_glyph(char c);
+
+/**
+ * @brief Draws `sprite` with its top left corner at (x, y), clipped to the grid.
+ *
+ * @param[in,out] frame RGB frame on the logical grid.
+ * @param[in] alpha Opacity, 255 replaces the covered pixels.
+ */
+void led_blit(uint8_t *frame, const led_sprite_t *sprite, int x, int y, led_rgb_t color, uint8_t alpha);
+
+/**
+ * @brief Width of `text` in columns, as led_blit_text draws it.
+ */
+int led_text_width(const char *text);
+
+/**
+ * @brief Draws NUL terminated `text` starting at (x, y), clipped to the grid. An icon name in braces, e.g.
+ *        "{alert}", draws that icon; unknown names are drawn as text. Glyphs entirely outside the grid
+ *        cost nothing but their width lookup.
+ *
+ * @return The column after the last glyph drawn; drawing stops once the text runs off the right edge.
+ */
+int led_blit_text(uint8_t *frame, const char *text, int x, int y, led_rgb_t color, uint8_t alpha);
+
+#endif
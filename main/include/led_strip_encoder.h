@@ -5,8 +5,11 @@
  */
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include "driver/rmt_encoder.h"
+#include "led_color.h"
+#include "led_pixel_format.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,13 +22,49 @@ typedef struct {
     uint32_t resolution; /*!< Encoder resolution, in Hz */
 } led_strip_encoder_config_t;
 
+/**
+ * @brief Frame handed to rmt_transmit as payload, with sizeof(led_strip_frame_t) as payload size.
+ *        It is read while the transaction is encoded, so it must stay valid until the transaction is done.
+ *
+ * Every channel value v of pixel p goes out as (levels[v] + dither_offset + p * dither_stride) >> 8,
+ * the offset wrapping at 8 bits, or as the whole 16 bit level on 16 bit chips; see led_wire_pixel. Indexed frames hold one palette index per pixel instead of RGB. With a map,
+ * LED p shows pixel map[p] of `pixels`.
+ */
+typedef struct {
+    const uint8_t *pixels;   /*!< RGB, 3 bytes per pixel, or 1 byte palette indices */
+    const led_rgb_t *palette; /*!< 256 colors for indexed frames, NULL for RGB */
+    const uint16_t *map;     /*!< Pixel index for every LED, NULL to send the pixels in order */
+    size_t pixel_count;
+    const uint16_t *levels;  /*!< 8.8 fixed point output level for each of the 256 channel values */
+    uint8_t dither_offset;
+    uint8_t dither_stride;   /*!< 0 without dithering */
+} led_strip_frame_t;
+
+/**
+ * @brief RGB bytes LED `pixel` shows, gathered through the map and looked up in the palette as set
+ */
+static inline const uint8_t *led_strip_frame_pixel(const led_strip_frame_t *frame, size_t pixel)
+{
+    if (frame->map) {
+        pixel = frame->map[pixel];
+    }
+    if (frame->palette) {
+        return &frame->palette[frame->pixels[pixel]].r;
+    }
+    return frame->pixels + pixel * LED_PIXEL_BYTES;
+}
+
 /**
  * @brief Create RMT encoder for encoding LED strip pixels into RMT symbols
  *
+ * The encoder converts, scales and encodes the pixels in one go while the RMT interrupt refills the channel
+ * memory; every output byte is copied from a table of the 8 symbols for each byte value. The table is shared by
+ * all encoders, so they must all use the same resolution. Wire format and bit timing are those of LED_CHIP.
+ *
  * @param[in] config Encoder configuration
  * @param[out] ret_encoder Returned encoder handle
  * @return
- *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments, or a resolution other than that of earlier encoders
  *      - ESP_ERR_NO_MEM out of memory when creating led strip encoder
  *      - ESP_OK if creating encoder successfully
  */
@@ -0,0 +1,147 @@
+#ifndef LED_STRIP_OUTPUT_H
+#define LED_STRIP_OUTPUT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+
+#include "led_frame_buffer.h"
+#include "led_gamma.h"
+#include "led_strip_encoder.h"
+
+
+#define LED_OUTPUT_BUFFERS              3       // One on the wire, one queued, one being rendered
+#define LED_OUTPUT_MAX_SEGMENTS         16      // Data lines of the parallel bus
+#define LED_OUTPUT_MAX_RMT_SEGMENTS     8       // RMT TX channels on the ESP32
+#define LED_OUTPUT_MAX_SPI_SEGMENTS     2       // SPI2 and SPI3
+#define LED_OUTPUT_SPI_BIT_NS           1250    // led_strip_spi_encoder.c and led_strip_parallel_encoder.c
+#define LED_OUTPUT_RESET_US             LED_RESET_US
+
+
+typedef enum {
+    LED_OUTPUT_BACKEND_RMT,     // Symbols encoded in the RMT interrupt as the channel memory drains
+    LED_OUTPUT_BACKEND_SPI,     // Whole frame encoded up front, streamed by SPI DMA
+    LED_OUTPUT_BACKEND_PARALLEL,    // All segments on one I2S bus in LCD mode, one data line each
+} led_output_backend_t;
+
+typedef struct {
+    led_output_backend_t backend;
+    const gpio_num_t *gpio_nums;        // One strip segment per GPIO
+    size_t segment_count;               // LED_COUNT is split evenly over the segments, in GPIO order
+    uint32_t resolution_hz;             // RMT only
+    gpio_num_t parallel_clock_gpio;     // Parallel only: bus clock and D/C lines, not connected to the strips
+    gpio_num_t parallel_dc_gpio;
+} led_output_config_t;
+
+#define LED_PALETTE_SIZE                256
+
+
+typedef struct {
+    union {
+        uint8_t pixels[LED_FRAME_BYTES];            // RGB
+        struct {                                    // Indexed
+            uint8_t indices[LED_COUNT];
+            led_rgb_t palette[LED_PALETTE_SIZE];
+        };
+    };
+    bool indexed;
+    const uint16_t *map;                // Logical pixel for every LED (led_map_table), NULL for wiring order
+    led_gamma_lut_t lut;                // Output levels, applied while the frame is encoded
+} led_output_frame_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t render_stalls;     // acquire calls that had to wait for the wire
+} led_output_stats_t;
+
+
+/*
+ * Asynchronous strip output.
+ *
+ * The render loop acquires a free buffer, renders a whole frame into it and submits it. Submitted buffers
+ * belong to the driver until their transaction is done; the done interrupt hands them back. Frame N + 1 is
+ * thus rendered while frame N is on the wire and the render loop only waits once it gets
+ * LED_OUTPUT_BUFFERS - 1 frames ahead of the wire.
+ *
+ * The RMT backend refills the small channel memory from its interrupt, so long interrupt latency (Wi-Fi) can
+ * stretch a bit on the wire. The SPI backend encodes the whole frame into a DMA buffer when it is submitted
+ * and needs no CPU until the frame is out, at the cost of 4 bytes of DMA memory per pixel byte per buffer.
+ * The parallel backend does the same for up to 16 segments at once on the data lines of the I2S peripheral
+ * in LCD mode, with 3 bus words per strip bit.
+ *
+ * The strip may be split into segments on separate GPIOs, each driven by its own RMT channel, SPI host or
+ * parallel data line. All segments of a frame go out at the same time (on the parallel bus and on targets with
+ * RMT TX synchronization exactly so, otherwise started back to back), so the wire time per frame is that of
+ * the longest segment and the buffer is handed back once every segment is done.
+ *
+ * Frames are rendered in RGB, or as palette indices plus a palette. Palette lookup, the LED_CHIP wire format,
+ * gamma and brightness are applied by the encoder as the frame goes out, so the render loop never makes a pass over the
+ * finished frame. An indexed frame is a third of the pixel data to render and copy, and animating its palette
+ * costs the same regardless of the strip length.
+ */
+
+/**
+ * @brief First LED of `segment` out of `segment_count`. Segment lengths differ by one LED at most.
+ */
+static inline size_t led_output_segment_first(size_t segment, size_t segment_count) {
+    return LED_COUNT * segment / segment_count;
+}
+
+/**
+ * @brief LEDs of the longest segment, the one that sets the wire time.
+ */
+static inline size_t led_output_segment_pixels(size_t segment_count) {
+    return (LED_COUNT + segment_count - 1) / segment_count;
+}
+
+/**
+ * @brief LED_CHIP bit period as led_strip_encoder.c sends it: high and low time are each rounded down to
+ *        whole ticks of the RMT resolution. The longer of the two bits, should they come out different.
+ */
+static inline uint32_t led_output_rmt_bit_ns(uint32_t resolution_hz) {
+    uint64_t bit0_ticks = (uint64_t)LED_T0H_NS * resolution_hz / 1000000000 +
+                          (uint64_t)LED_T0L_NS * resolution_hz / 1000000000;
+    uint64_t bit1_ticks = (uint64_t)LED_T1H_NS * resolution_hz / 1000000000 +
+                          (uint64_t)LED_T1L_NS * resolution_hz / 1000000000;
+    uint64_t ticks = bit0_ticks > bit1_ticks ? bit0_ticks : bit1_ticks;
+    return ticks * 1000000000 / resolution_hz;
+}
+
+/**
+ * @brief Time one frame spends on the wire with `config`, that of the longest segment, reset code included.
+ */
+static inline uint32_t led_output_wire_time_us(const led_output_config_t *config) {
+    uint32_t bit_ns = config->backend == LED_OUTPUT_BACKEND_RMT ? led_output_rmt_bit_ns(config->resolution_hz)
+                                                                : LED_OUTPUT_SPI_BIT_NS;
+    uint64_t bits = (uint64_t)led_output_segment_pixels(config->segment_count) * LED_WIRE_BYTES * 8;
+    return bits * bit_ns / 1000 + LED_OUTPUT_RESET_US;
+}
+
+/**
+ * @brief Creates and enables an RMT channel and a strip encoder, or an SPI bus and device, per segment, or
+ *        the parallel bus for all of them.
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG for a segment count of 0 or above the backend's maximum
+ *      - ESP_ERR_NO_MEM if the buffer queues or DMA buffers could not be allocated
+ *      - RMT, SPI or LCD driver errors
+ *      - ESP_OK on success
+ */
+esp_err_t led_output_init(const led_output_config_t *config);
+
+/**
+ * @brief Takes a frame to render the next frame into, waiting for the wire to release one if necessary.
+ *        Its previous contents, pixels, palette and table, are undefined and `indexed` and `map` have to be
+ *        set.
+ */
+led_output_frame_t *led_output_acquire(void);
+
+/**
+ * @brief Queues an acquired frame for transmission. The frame must not be touched afterwards.
+ */
+esp_err_t led_output_submit(led_output_frame_t *frame);
+
+led_output_stats_t led_output_get_stats(void);
+
+#endif
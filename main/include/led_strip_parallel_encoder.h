@@ -0,0 +1,61 @@
+#ifndef LED_STRIP_PARALLEL_ENCODER_H
+#define LED_STRIP_PARALLEL_ENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#include "led_strip_encoder.h"
+
+
+#define LED_PARALLEL_MAX_LANES          16
+#define LED_PARALLEL_PCLK_HZ            2400000     // 417 ns per slot
+#define LED_PARALLEL_SLOTS_PER_BIT      3           // high, data, low: T0H 0.42 us, T1H 0.83 us
+#define LED_PARALLEL_BIT_NS             1250
+#define LED_PARALLEL_RESET_SLOTS        (LED_RESET_US * 12 / 5)     // LED_RESET_US low, as the RMT encoder sends
+#define LED_PARALLEL_BUS_WIDTH(lanes)   ((lanes) > 8 ? 16 : 8)
+#define LED_PARALLEL_BYTES(lanes, pixels_per_lane) \
+    (((pixels_per_lane) * LED_WIRE_BYTES * 8 * LED_PARALLEL_SLOTS_PER_BIT + LED_PARALLEL_RESET_SLOTS) \
+     * (LED_PARALLEL_BUS_WIDTH(lanes) / 8))
+
+
+typedef struct {
+    size_t lane_count;
+    size_t word_bytes;              // 1 for an 8 bit bus, 2 for 16
+} led_strip_parallel_encoder_t;
+
+
+/*
+ * Strip encoding for a parallel bus (I2S in LCD mode), one strip per data line.
+ *
+ * Every strip bit takes three bus words: all lanes high, the data bits of all lanes, all lanes low. The slot
+ * length is fixed, so every LED_CHIP gets these WS2812 style timings, which all of them accept. Only the data
+ * words change between frames, so led_strip_parallel_prepare writes the constant ones once and the encoder
+ * only fills in the data words. For every wire byte position the lanes' bytes form an 8x8 bit matrix,
+ * which is transposed so that word i holds bit 7 - i of every lane.
+ */
+
+/**
+ * @brief Transposes an 8x8 bit matrix: bit i of out[j * stride] = bit 7 - j of in[i].
+ *
+ * @param[in] in One byte per lane, lane i ends up on data line i.
+ * @param[out] out Eight bytes, `stride` bytes apart.
+ */
+void led_transpose8x8(const uint8_t in[8], uint8_t *out, size_t stride);
+
+esp_err_t led_strip_parallel_encoder_init(led_strip_parallel_encoder_t *encoder, size_t lane_count);
+
+/**
+ * @brief Writes the constant high and low words and the reset code into a DMA buffer of
+ *        LED_PARALLEL_BYTES(lane_count, pixels_per_lane) bytes.
+ */
+void led_strip_parallel_prepare(const led_strip_parallel_encoder_t *encoder, uint8_t *out, size_t pixels_per_lane);
+
+/**
+ * @brief Encodes one frame per lane into a buffer set up by led_strip_parallel_prepare. Lanes shorter than
+ *        `pixels_per_lane` are padded with black.
+ */
+void led_strip_parallel_encode(const led_strip_parallel_encoder_t *encoder, const led_strip_frame_t *lanes,
+                               size_t pixels_per_lane, uint8_t *out);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef LED_STRIP_SPI_ENCODER_H
+#define LED_STRIP_SPI_ENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#include "led_strip_encoder.h"
+
+
+#define LED_STRIP_SPI_CLOCK_HZ          3200000     // 312.5 ns per SPI bit
+#define LED_STRIP_SPI_BITS_PER_BIT      4           // WS2812: 0 -> 1000 (T0H 0.31 us), 1 -> 1110 (T1H 0.94 us)
+#define LED_STRIP_SPI_BIT_NS            1250
+#define LED_STRIP_SPI_RESET_BYTES       ((LED_RESET_US * 2 + 4) / 5)    // LED_RESET_US low, 2.5 us per byte
+#define LED_STRIP_SPI_BYTES(pixels) \
+    ((pixels) * LED_WIRE_BYTES * LED_STRIP_SPI_BITS_PER_BIT + LED_STRIP_SPI_RESET_BYTES)
+
+
+typedef struct {
+    uint8_t bit_patterns[256][LED_STRIP_SPI_BITS_PER_BIT];     // SPI bytes for each wire byte, MSB first
+} led_strip_spi_encoder_t;
+
+
+/*
+ * Strip encoding for an SPI MOSI line: every strip bit becomes 4 SPI bits, as many of them high as the
+ * LED_CHIP high time rounds to, so every wire byte becomes the 4 SPI bytes looked up in a 256 entry table.
+ * The encoded frame is then streamed by SPI DMA without any CPU work until it is done, which keeps interrupt
+ * latency (e.g. from Wi-Fi) off the wire timing.
+ */
+
+/**
+ * @brief Builds the expansion table.
+ */
+void led_strip_spi_encoder_init(led_strip_spi_encoder_t *encoder);
+
+/**
+ * @brief Encodes `frame` (levels and dithering applied as by the RMT encoder), followed by the reset code.
+ *
+ * @param[out] out DMA buffer of LED_STRIP_SPI_BYTES(frame->pixel_count) bytes.
+ * @return Number of bytes written.
+ */
+size_t led_strip_spi_encode(const led_strip_spi_encoder_t *encoder, const led_strip_frame_t *frame, uint8_t *out);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef LED_TRANSITION_H
+#define LED_TRANSITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "led_color.h"
+
+
+#define LED_TRANSITION_MAX_MS           60000
+#define LED_EASE_ONE                    (1u << 16)      // Progress and blend weights are 0.16 fixed point
+
+
+typedef enum {
+    LED_EASE_LINEAR,
+    LED_EASE_IN,                // Quadratic, starts slow
+    LED_EASE_OUT,               // Quadratic, ends slow
+    LED_EASE_IN_OUT,            // Smoothstep
+} led_ease_t;
+
+
+/*
+ * Crossfades from the last frame shown to whatever is rendered next.
+ *
+ * Starting a transition freezes the frame currently on the strip, and every following frame is blended from
+ * that snapshot towards the freshly rendered one. The target keeps animating, only the start point is fixed,
+ * so neither end is ever rendered twice. The blend weight is eased in 16 bit fixed point once per frame; per
+ * pixel the blend is one multiply per channel. Brightness is faded the same way, as a scalar.
+ *
+ * Frames go through led_transition_apply in RGB and in the same pixel order, so streamed frames (wiring
+ * order) bypass it and call led_transition_cut instead.
+ */
+
+/**
+ * @brief Asks for the next frame to start a transition. Safe to call from any task, the render loop picks
+ *        the request up in led_transition_apply. A later request replaces an earlier one.
+ *
+ * @param[in] duration_ms 0 switches instantly.
+ */
+void led_transition_request(uint32_t duration_ms, led_ease_t ease);
+
+/**
+ * @brief Blends a rendered frame with the running transition, in place, and records the result as shown.
+ *
+ * @param[in,out] pixels Rendered frame: RGB, or LED_COUNT palette indices if `palette` is set. May share
+ *                       storage with `palette`.
+ * @param[in] palette Colors of an indexed frame, NULL for RGB.
+ * @param[in,out] brightness Target brightness in, the brightness to show out.
+ * @return true while a transition is running; the frame is RGB then and the caller should keep rendering.
+ *         Otherwise the frame is left as it was.
+ */
+bool led_transition_apply(uint8_t *pixels, const led_rgb_t *palette, uint8_t *brightness);
+
+/**
+ * @brief Eases `progress` along `ease`: 0 gives 0 and LED_EASE_ONE gives LED_EASE_ONE, for every curve.
+ */
+uint32_t led_transition_ease(led_ease_t ease, uint32_t progress);
+
+/**
+ * @brief Stops any transition and forgets the shown frame; the next one starts without a fade.
+ */
+void led_transition_cut(void);
+
+#endif
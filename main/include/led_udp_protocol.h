@@ -0,0 +1,37 @@
+#ifndef LED_UDP_PROTOCOL_H
+#define LED_UDP_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "led_udp_receiver.h"
+#include "led_frame_buffer.h"
+
+
+#define E131_UNIVERSE_COUNT     ((LED_FRAME_BYTES + E131_CHANNELS_PER_UNIVERSE - 1) / E131_CHANNELS_PER_UNIVERSE)
+
+
+/*
+ * DDP and E1.31 packet handling behind the UDP receiver task: header checks, sequence numbers and assembling
+ * frames in the frame buffer. The task passes every datagram in as received; nothing here touches a socket.
+ * Both handlers run on the receiver task only.
+ */
+
+/**
+ * @brief Handles one DDP datagram.
+ *
+ * Data packets are written at their offset into the frame buffer and committed on the push flag. Packets
+ * carrying a timecode are assembled apart and pushed to the jitter buffer once the clock is synchronized.
+ * Packets whose sequence number isn't ahead of the last one are dropped.
+ */
+void led_udp_handle_ddp(const uint8_t *buf, size_t len);
+
+/**
+ * @brief Handles one E1.31 datagram.
+ *
+ * Each of the E131_UNIVERSE_COUNT universes from E131_START_UNIVERSE fills its part of the frame, which is
+ * committed once all of them arrived. A universe arriving again first commits the incomplete frame.
+ */
+void led_udp_handle_e131(const uint8_t *buf, size_t len);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef LED_UDP_RECEIVER_H
+#define LED_UDP_RECEIVER_H
+
+#include <stdint.h>
+
+
+#define DDP_PORT                        4048
+#define E131_PORT                       5568
+#define E131_START_UNIVERSE             1       // Universe mapped onto the first LED
+#define E131_CHANNELS_PER_UNIVERSE      510     // 170 RGB pixels, the usual pixel controller layout
+
+
+typedef struct {
+    uint32_t packets;
+    uint32_t frames;
+    uint32_t dropped_out_of_order;
+    uint32_t dropped_invalid;
+} led_udp_stats_t;
+
+
+/**
+ * @brief Task receiving real time pixel data over UDP (DDP and E1.31 sACN) into the frame buffer.
+ *
+ * Channel data is copied straight into the RGB frame buffer. DDP frames are committed on the push flag, E1.31
+ * frames once every universe covering the strip has been received. DDP frames carrying a timecode are handed
+ * to the jitter buffer instead and show up at their presentation time.
+ *
+ * @param[in] arg Unused.
+ */
+void process_udp_pixels(void *arg);
+
+led_udp_stats_t led_udp_get_stats(void);
+
+#endif
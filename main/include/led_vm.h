@@ -0,0 +1,101 @@
+#ifndef LED_VM_H
+#define LED_VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#include "led_color.h"
+
+
+#define LED_VM_REGISTERS                16
+#define LED_VM_MAX_CODE                 64      // Instructions per program, bounds the time a run can take
+#define LED_VM_ONE                      (1 << 16)
+#define LED_VM_TIME_WRAP_S              16384   // 4.5 h, whole seconds keep anything periodic in 1 / n s continuous
+
+#define LED_VM_MAGIC_0                  'L'
+#define LED_VM_MAGIC_1                  'V'
+#define LED_VM_VERSION                  1
+
+// Inputs, written before every run
+#define LED_VM_R_T                      15      // Seconds since the program started, modulo LED_VM_TIME_WRAP_S
+#define LED_VM_R_I                      14      // Pixel: index
+#define LED_VM_R_X                      13      // Pixel: column on the logical grid
+#define LED_VM_R_Y                      12      // Pixel: row
+#define LED_VM_R_U                      11      // Pixel: index / pixel count, 0 - 1
+
+
+/*
+ * Interpreter for effects uploaded as bytecode.
+ *
+ * A program is a per-frame and a per-pixel part, each a list of 4 byte instructions [op][d][a][b] working on
+ * 16 registers of signed 16.16 fixed point. The frame part runs once per frame on registers that persist
+ * across frames, so it can keep state. The pixel part runs for every pixel on a copy of them, with its
+ * position in the input registers, and leaves the pixel's color in r0 - r2 (0 - 1 per channel, clamped).
+ *
+ * Upload format:
+ *      [magic 'L' 'V'] [version] [frame instructions] [pixel instructions] [frame code ...] [pixel code ...]
+ *
+ * Jumps only go forward, so every instruction runs at most once per run and a frame costs at most
+ * LED_VM_MAX_CODE * (LED_COUNT + 1) instructions. Programs are verified when loaded (known opcodes, register
+ * numbers in range, jump targets inside the program), which lets the interpreter run without any checks.
+ */
+
+typedef enum {
+    LED_VM_LDI,         // d = signed 8.8 immediate [a][b]
+    LED_VM_MOV,         // d = a
+    LED_VM_ADD,         // d = a + b
+    LED_VM_SUB,         // d = a - b
+    LED_VM_MUL,         // d = a * b
+    LED_VM_DIV,         // d = a / b, 0 if b is 0
+    LED_VM_MIN,         // d = min(a, b)
+    LED_VM_MAX,         // d = max(a, b)
+    LED_VM_ABS,         // d = |a|
+    LED_VM_FRAC,        // d = a - floor(a)
+    LED_VM_FLOOR,       // d = floor(a)
+    LED_VM_SIN,         // d = sin(a turns)
+    LED_VM_HSV,         // d, d + 1, d + 2 = RGB of hue a (turns), full saturation, value b
+    LED_VM_JMP,         // Skip the next d instructions
+    LED_VM_JLT,         // Skip the next d instructions if a < b
+    LED_VM_JGE,         // Skip the next d instructions if a >= b
+    LED_VM_OP_COUNT,
+} led_vm_op_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t d;
+    uint8_t a;
+    uint8_t b;
+} led_vm_insn_t;
+
+typedef struct {
+    led_vm_insn_t frame[LED_VM_MAX_CODE];
+    led_vm_insn_t pixel[LED_VM_MAX_CODE];
+    uint8_t frame_len;
+    uint8_t pixel_len;
+} led_vm_program_t;
+
+
+/**
+ * @brief Verifies an uploaded program and copies it into `program`.
+ *
+ * @return
+ *      - ESP_ERR_INVALID_VERSION for a bad magic or an unknown version
+ *      - ESP_ERR_INVALID_SIZE if the payload is truncated, too long, or a part exceeds LED_VM_MAX_CODE
+ *      - ESP_ERR_INVALID_ARG for an unknown opcode, a register out of range or a jump past the end
+ *      - ESP_OK on success, `program` is untouched otherwise
+ */
+esp_err_t led_vm_load(led_vm_program_t *program, const uint8_t *data, size_t len);
+
+/**
+ * @brief Runs the frame part on the persistent registers.
+ */
+void led_vm_run_frame(const led_vm_program_t *program, int32_t *regs, int32_t time);
+
+/**
+ * @brief Runs the pixel part for one pixel on a copy of the registers the frame part left.
+ */
+led_rgb_t led_vm_run_pixel(const led_vm_program_t *program, const int32_t *regs, int x, int y, size_t index,
+                           size_t count);
+
+#endif
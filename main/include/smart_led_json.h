@@ -0,0 +1,32 @@
+#ifndef SMART_LED_JSON_H
+#define SMART_LED_JSON_H
+
+#include <stddef.h>
+#include "esp_err.h"
+
+#include "smart_led_state.h"
+
+
+/**
+ * @brief Applies a JSON light command to the device state.
+ *
+ * Accepts the common JSON light schema, e.g.
+ *      {"state":"ON","brightness":120,"color":{"r":255,"g":80,"b":0}}
+ * "color" may also be given as {"h":0-360,"s":0-100}, "effect" selects an effect by name ("none" for a
+ * plain color) and "text" sets what the "text" effect scrolls, e.g. {"effect":"text","text":"Hello"}. Text is
+ * taken as-is, escapes included. "transition" fades to the new state over whole seconds, "transition_ms"
+ * over milliseconds. Unknown keys are ignored. The state is only
+ * modified if the whole payload parsed successfully.
+ *
+ * @param[in] payload JSON payload (does not need to be NUL terminated).
+ * @param[in] len Length of the payload.
+ * @param[in,out] state Device state the command is applied to.
+ * @param[in,out] transition_ms Fade duration of the command, left as it is if the command doesn't set one.
+ * @return
+ *      - ESP_OK if the command was applied
+ *      - ESP_ERR_INVALID_ARG for malformed JSON or invalid values of known keys
+ *      - ESP_ERR_INVALID_SIZE for truncated payloads
+ */
+esp_err_t smart_led_apply_json(const char *payload, size_t len, smart_led_state_t *state, uint32_t *transition_ms);
+
+#endif
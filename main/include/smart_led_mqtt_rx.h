@@ -0,0 +1,49 @@
+#ifndef SMART_LED_MQTT_RX_H
+#define SMART_LED_MQTT_RX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define LED_TOPIC                       "home/chris/smart_led"
+#define FRAME_TOPIC                     LED_TOPIC "/frame"
+#define DELTA_TOPIC                     FRAME_TOPIC "/delta"
+#define ANIM_TOPIC                      LED_TOPIC "/anim"
+#define ANIM_STATUS_TOPIC               ANIM_TOPIC "/status"
+#define PROGRAM_TOPIC                   LED_TOPIC "/program"
+
+#define MQTT_RX_BUFF_SIZE               2048    // Must hold a complete frame publish (LED_FRAME_BYTES + topic + headers)
+
+
+/**
+ * @brief Handles one complete packet the streaming topics didn't take. Returns -1 to drop the connection.
+ */
+typedef int (*smart_led_mqtt_packet_handler_t)(uint8_t *packet, size_t len, int sock, int msg_number);
+
+
+/*
+ * Receive side of the broker connection: splits the TCP stream into MQTT packets. Publishes on the streaming
+ * topics (frames, encoded frames, clip uploads, effect programs) go from the receive buffer straight into their
+ * modules, everything else to the connection's packet handler. Packets larger than the receive buffer are read
+ * and thrown away. Used by the broker task only.
+ */
+
+/**
+ * @brief Starts on a new connection, with an empty receive buffer.
+ */
+void smart_led_mqtt_rx_init(int sock, smart_led_mqtt_packet_handler_t handler);
+
+/**
+ * @brief Free space at the end of the receive buffer, where the next read goes.
+ */
+uint8_t *smart_led_mqtt_rx_space(size_t *len);
+
+/**
+ * @brief Handles every packet completed by `bytes_read` more bytes read into the free space, and keeps the
+ *        incomplete tail for the next read.
+ *
+ * @return -1 if a packet is malformed or its handler failed and the connection should be dropped, 0 otherwise.
+ */
+int smart_led_mqtt_rx_received(size_t bytes_read);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SMART_LED_REPORTER_H
+#define SMART_LED_REPORTER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+
+#define STATE_TOPIC_SUFFIX      "/state"
+
+
+typedef struct {
+    uint32_t window_ms;             // State changes within this window are coalesced into a single publish
+    uint8_t delta_updates;          // Publish only the fields that changed since the last publish
+    uint8_t keyframe_interval;      // In delta mode, every Nth publish carries the full state and is retained
+} smart_led_reporter_config_t;
+
+typedef struct {
+    uint32_t notifications;         // State change notifications (what naive per-command publishing would send)
+    uint32_t publishes;             // Publishes actually sent
+    uint32_t suppressed;            // Coalescing windows that ended with no effective change
+    uint32_t bytes_sent;
+    uint32_t bytes_naive;           // Bytes a full publish per notification would have cost
+} smart_led_reporter_stats_t;
+
+
+/**
+ * @brief Starts reporting the device state on <base_topic>/state.
+ *
+ * Publishes the current state immediately (retained) and afterwards only when it changes.
+ *
+ * @param[in] config Reporter configuration.
+ * @param[in] base_topic Command topic the state topic is derived from.
+ * @param[in] sock Socket connected to the broker.
+ * @return
+ *      - ESP_ERR_INVALID_ARG for invalid arguments or a topic that doesn't fit
+ *      - ESP_ERR_NO_MEM if the report task or the coalescing timer could not be created
+ *      - ESP_OK on success
+ */
+esp_err_t smart_led_reporter_init(const smart_led_reporter_config_t *config, const char *base_topic, int sock);
+
+/**
+ * @brief Signals that the device state may have changed. Cheap and safe to call from any task.
+ *
+ * Opens a coalescing window if none is pending; the state is compared and published when it closes.
+ */
+void smart_led_reporter_notify(void);
+
+smart_led_reporter_stats_t smart_led_reporter_get_stats(void);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SMART_LED_STATE_H
+#define SMART_LED_STATE_H
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+
+#define LED_STATE_TEXT_LEN              32      // Longest text the "text" effect scrolls
+
+typedef enum {
+    LED_MODE_SOLID,         // Color, brightness and effect from the state below
+    LED_MODE_STREAM,        // Raw frames pushed over the network
+} smart_led_mode_t;
+
+
+/**
+ * @brief Device state shared between the command handlers, the render loop and the state reporter.
+ *
+ * Colors are stored unscaled; brightness is applied when building pixels. Changes and copies of it are made
+ * under led_state_lock, so no reader sees a half applied command.
+ */
+typedef struct {
+    uint8_t on;
+    uint8_t mode;           // smart_led_mode_t
+    uint8_t brightness;     // 0 - 255
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t effect;         // led_effect_id_t, LED_EFFECT_NONE for a plain color
+    char text[LED_STATE_TEXT_LEN + 1];
+} smart_led_state_t;
+
+
+extern smart_led_state_t led_state;
+extern portMUX_TYPE led_state_lock;
+
+
+static inline smart_led_state_t led_state_snapshot(void) {
+    portENTER_CRITICAL(&led_state_lock);
+    smart_led_state_t state = led_state;
+    portEXIT_CRITICAL(&led_state_lock);
+    return state;
+}
+
+#endif
@@ -0,0 +1,253 @@
+#include <string.h>
+#include <stdbool.h>
+
+#include "json_sax.h"
+
+
+// What the parser accepts next
+enum {
+    EXPECT_VALUE,
+    EXPECT_VALUE_OR_END,    // Right after '['
+    EXPECT_KEY,             // After ',' inside an object
+    EXPECT_KEY_OR_END,      // Right after '{'
+    EXPECT_COLON,
+    EXPECT_COMMA_OR_END,
+    EXPECT_DONE,
+};
+
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+
+/* Scans a string starting at the opening quote. On success *p points past the closing quote. */
+static esp_err_t scan_string(const char **p, const char *end, json_event *ev) {
+    const char *s = *p + 1;
+    ev->str = s;
+
+    while (s < end && *s != '"') {
+        if ((unsigned char)*s < 0x20) return ESP_ERR_INVALID_ARG;   // Control characters must be escaped
+        if (*s == '\\') {
+            ++s;
+            if (s >= end) return ESP_ERR_INVALID_SIZE;
+            if (*s == 'u') {
+                if (end - s < 5) return ESP_ERR_INVALID_SIZE;
+                for (int i = 1; i <= 4; ++i) {
+                    if (!is_hex(s[i])) return ESP_ERR_INVALID_ARG;
+                }
+                s += 4;
+            } else if (*s == '\0' || !strchr("\"\\/bfnrt", *s)) {     // strchr would match the terminator
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+        ++s;
+    }
+    if (s >= end) return ESP_ERR_INVALID_SIZE;
+
+    ev->str_len = s - ev->str;
+    *p = s + 1;
+    return ESP_OK;
+}
+
+
+int32_t json_number_scaled(const json_event *ev, int decimals) {
+    int64_t mantissa = ev->mantissa < 0 ? -ev->mantissa : ev->mantissa;
+    int exponent = ev->exponent + decimals;
+
+    for (; exponent > 0 && mantissa && mantissa <= INT32_MAX; --exponent) mantissa *= 10;
+    for (; exponent < 0 && mantissa; ++exponent) mantissa /= 10;
+    if (mantissa > INT32_MAX) mantissa = INT32_MAX;
+    return ev->mantissa < 0 ? -(int32_t)mantissa : (int32_t)mantissa;
+}
+
+
+/*
+ * Scans a number following the JSON grammar. The value is kept as mantissa * 10^exponent
+ * and only scaled down to an integer at the end so that e.g. "1.5e1" yields 15.
+ */
+static esp_err_t scan_number(const char **p, const char *end, json_event *ev) {
+    const char *s = *p;
+    bool negative = false;
+    int64_t mantissa = 0;
+    int exponent = 0;
+
+    ev->str = s;
+    if (*s == '-') {
+        negative = true;
+        ++s;
+    }
+    if (s >= end) return ESP_ERR_INVALID_SIZE;
+    if (!is_digit(*s)) return ESP_ERR_INVALID_ARG;
+
+    // Integer part (no leading zeros)
+    if (*s == '0') {
+        ++s;
+    } else {
+        while (s < end && is_digit(*s)) {
+            if (mantissa < INT32_MAX) mantissa = mantissa * 10 + (*s - '0');
+            else ++exponent;
+            ++s;
+        }
+    }
+    // Fraction
+    if (s < end && *s == '.') {
+        ++s;
+        if (s >= end) return ESP_ERR_INVALID_SIZE;
+        if (!is_digit(*s)) return ESP_ERR_INVALID_ARG;
+        while (s < end && is_digit(*s)) {
+            if (mantissa < INT32_MAX) {
+                mantissa = mantissa * 10 + (*s - '0');
+                --exponent;
+            }
+            ++s;
+        }
+    }
+    // Exponent
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        int exp_sign = 1;
+        int exp_value = 0;
+        ++s;
+        if (s < end && (*s == '+' || *s == '-')) {
+            if (*s == '-') exp_sign = -1;
+            ++s;
+        }
+        if (s >= end) return ESP_ERR_INVALID_SIZE;
+        if (!is_digit(*s)) return ESP_ERR_INVALID_ARG;
+        while (s < end && is_digit(*s)) {
+            if (exp_value < 1000) exp_value = exp_value * 10 + (*s - '0');
+            ++s;
+        }
+        exponent += exp_sign * exp_value;
+    }
+
+    ev->mantissa = negative ? -mantissa : mantissa;
+    ev->exponent = exponent;
+    ev->number = json_number_scaled(ev, 0);
+    ev->str_len = s - ev->str;
+    *p = s;
+    return ESP_OK;
+}
+
+
+static esp_err_t scan_literal(const char **p, const char *end, const char *literal) {
+    size_t len = strlen(literal);
+    if ((size_t)(end - *p) < len) return ESP_ERR_INVALID_SIZE;
+    if (memcmp(*p, literal, len)) return ESP_ERR_INVALID_ARG;
+    *p += len;
+    return ESP_OK;
+}
+
+
+esp_err_t json_sax_parse(const char *buf, size_t len, json_event_cb cb, void *ctx) {
+    if (!buf || !cb) return ESP_ERR_INVALID_ARG;
+
+    const char *p = buf;
+    const char *end = buf + len;
+    uint32_t array_stack = 0;   // Bit n set -> container at depth n + 1 is an array
+    int depth = 0;
+    int expect = EXPECT_VALUE;
+    esp_err_t ret;
+
+    while (1) {
+        while (p < end && is_whitespace(*p)) ++p;
+        if (p >= end) break;
+
+        json_event ev = { .depth = depth };
+        char c = *p;
+        bool in_array = depth && (array_stack & (1u << (depth - 1)));
+
+        switch (expect) {
+            case EXPECT_DONE:
+                return ESP_ERR_INVALID_ARG;   // Trailing garbage
+
+            case EXPECT_COLON:
+                if (c != ':') return ESP_ERR_INVALID_ARG;
+                ++p;
+                expect = EXPECT_VALUE;
+                continue;
+
+            case EXPECT_COMMA_OR_END:
+                if (c == ',') {
+                    ++p;
+                    expect = in_array ? EXPECT_VALUE : EXPECT_KEY;
+                    continue;
+                }
+                if ((c == ']' && in_array) || (c == '}' && !in_array)) break;   // Close container below
+                return ESP_ERR_INVALID_ARG;
+
+            case EXPECT_KEY_OR_END:
+                if (c == '}') break;
+                // fall-through
+            case EXPECT_KEY:
+                if (c != '"') return ESP_ERR_INVALID_ARG;
+                ret = scan_string(&p, end, &ev);
+                if (ret) return ret;
+                ev.type = JSON_KEY;
+                ret = cb(&ev, ctx);
+                if (ret) return ret;
+                expect = EXPECT_COLON;
+                continue;
+
+            case EXPECT_VALUE_OR_END:
+                if (c == ']') break;
+                // fall-through
+            case EXPECT_VALUE:
+                if (c == '{' || c == '[') {
+                    if (depth >= JSON_MAX_DEPTH) return ESP_ERR_INVALID_SIZE;
+                    ev.type = (c == '{') ? JSON_OBJECT_START : JSON_ARRAY_START;
+                    ret = cb(&ev, ctx);
+                    if (ret) return ret;
+                    if (c == '[') array_stack |= (1u << depth);
+                    else array_stack &= ~(1u << depth);
+                    ++depth;
+                    ++p;
+                    expect = (c == '{') ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+                    continue;
+                }
+
+                if (c == '"') {
+                    ev.type = JSON_STRING;
+                    ret = scan_string(&p, end, &ev);
+                } else if (c == '-' || is_digit(c)) {
+                    ev.type = JSON_NUMBER;
+                    ret = scan_number(&p, end, &ev);
+                } else if (c == 't') {
+                    ev.type = JSON_TRUE;
+                    ret = scan_literal(&p, end, "true");
+                } else if (c == 'f') {
+                    ev.type = JSON_FALSE;
+                    ret = scan_literal(&p, end, "false");
+                } else if (c == 'n') {
+                    ev.type = JSON_NULL;
+                    ret = scan_literal(&p, end, "null");
+                } else {
+                    return ESP_ERR_INVALID_ARG;
+                }
+                if (ret) return ret;
+                ret = cb(&ev, ctx);
+                if (ret) return ret;
+                expect = depth ? EXPECT_COMMA_OR_END : EXPECT_DONE;
+                continue;
+        }
+
+        // Close the current container
+        --depth;
+        ev.depth = depth;
+        ev.type = (c == '}') ? JSON_OBJECT_END : JSON_ARRAY_END;
+        ret = cb(&ev, ctx);
+        if (ret) return ret;
+        ++p;
+        expect = depth ? EXPECT_COMMA_OR_END : EXPECT_DONE;
+    }
+
+    return (expect == EXPECT_DONE) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
@@ -0,0 +1,336 @@
+#include <string.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "led_anim_cache.h"
+#include "led_frame_buffer.h"
+#include "led_frame_codec.h"
+#include "led_render_parallel.h"
+
+
+#define ANIM_TAG                "ANIM"
+#define ANIM_CLIP_MAGIC         0x4D494E41      // "ANIM"
+#define ANIM_SECTOR_SIZE        4096
+#define ANIM_FRAME_LEN_BYTES    2
+#define PLAY_TASK_PRIORITY      19      // With the jitter buffer release: a frame is due at its interval
+
+
+/* Stored at the start of each slot, written last so only complete clips carry the magic */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t crc32;
+    uint16_t frame_count;
+    uint16_t interval_ms;
+} anim_clip_header_t;
+
+
+// Played frames switch the render loop over to streamed frames
+extern void stream_frame_received(void);
+
+static const esp_partition_t *anim_partition = NULL;
+static size_t slot_size = 0;
+// Guards everything below. Taken by the MQTT task, which may hold it through a slot erase, and the play task,
+// which never waits for it.
+static SemaphoreHandle_t anim_lock = NULL;
+static esp_timer_handle_t frame_timer = NULL;
+static TaskHandle_t play_task = NULL;
+
+static struct {
+    bool active;
+    uint8_t slot;
+    anim_clip_header_t header;
+    uint32_t written;
+} upload;
+
+static struct {
+    bool playing;
+    bool loop;
+    int slot;                       // Slot currently mapped, -1 if none
+    const uint8_t *clip;
+    uint32_t size;
+    size_t cursor;
+    esp_partition_mmap_handle_t mmap_handle;
+} player = { .slot = -1 };
+
+
+static uint16_t read_be16(const uint8_t *buf) {
+    return (buf[0] << 8) | buf[1];
+}
+
+static uint32_t read_be32(const uint8_t *buf) {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+static size_t slot_offset(uint8_t slot) {
+    return slot * slot_size;
+}
+
+
+static void unmap_clip(void) {
+    esp_timer_stop(frame_timer);
+    player.playing = false;
+    if (player.slot >= 0) {
+        esp_partition_munmap(player.mmap_handle);
+        player.slot = -1;
+        player.clip = NULL;
+    }
+}
+
+
+/* Runs in the esp_timer task, which all timers share. Decoding is left to the play task. */
+static void frame_tick(void *arg) {
+    xTaskNotifyGive(play_task);
+}
+
+
+/* While an upload holds the lock the frame is skipped */
+static void play_next_frame(void) {
+    esp_err_t ret = ESP_FAIL;
+
+    if (xSemaphoreTake(anim_lock, 0) != pdTRUE) return;
+    if (player.playing) {
+        if (player.cursor + ANIM_FRAME_LEN_BYTES > player.size) {
+            player.cursor = 0;      // Starts over on the keyframe
+            if (!player.loop) {
+                player.playing = false;
+                esp_timer_stop(frame_timer);
+            }
+        }
+    }
+    if (player.playing) {
+        const uint8_t *frame_data = player.clip + player.cursor + ANIM_FRAME_LEN_BYTES;
+        uint16_t frame_len = read_be16(player.clip + player.cursor);
+        player.cursor += ANIM_FRAME_LEN_BYTES + frame_len;
+
+        // Decodes straight out of flash, nothing but the frame buffer is ever written
+        uint8_t *back = led_fb_begin_update();
+        ret = led_frame_decode(frame_data, frame_len, back, LED_FRAME_BYTES);
+        led_fb_end_write(ret == ESP_OK);
+    }
+    xSemaphoreGive(anim_lock);
+
+    if (ret == ESP_OK) stream_frame_received();
+}
+
+
+static void play_frames(void *arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        play_next_frame();
+    }
+}
+
+
+/* Checks that the frame lengths tile the clip exactly and the clip starts on a keyframe */
+static esp_err_t check_frames(const uint8_t *clip, uint32_t size, uint16_t frame_count) {
+    size_t cursor = 0;
+    uint32_t frames = 0;
+
+    while (cursor + ANIM_FRAME_LEN_BYTES <= size) {
+        uint16_t frame_len = read_be16(clip + cursor);
+        if (frame_len < 1 || frame_len > size - cursor - ANIM_FRAME_LEN_BYTES) return ESP_ERR_INVALID_SIZE;
+        if (frames == 0 && !(clip[cursor + ANIM_FRAME_LEN_BYTES] & FRAME_CODEC_KEYFRAME)) return ESP_ERR_INVALID_ARG;
+        cursor += ANIM_FRAME_LEN_BYTES + frame_len;
+        ++frames;
+    }
+    if (cursor != size || frames != frame_count) return ESP_ERR_INVALID_SIZE;
+    return ESP_OK;
+}
+
+
+static esp_err_t begin_upload(uint8_t slot, const uint8_t *args, size_t len) {
+    if (len < 8) return ESP_ERR_INVALID_ARG;
+    anim_clip_header_t header = {
+        .magic = ANIM_CLIP_MAGIC,
+        .size = read_be32(args),
+        .frame_count = read_be16(args + 4),
+        .interval_ms = read_be16(args + 6),
+    };
+    if (header.size == 0 || header.size > slot_size - sizeof(header)) return ESP_ERR_INVALID_SIZE;
+    if (header.interval_ms < LED_ANIM_MIN_INTERVAL_MS) return ESP_ERR_INVALID_ARG;
+
+    if (player.slot == slot) unmap_clip();
+    upload.active = false;
+
+    size_t erase_size = (sizeof(header) + header.size + ANIM_SECTOR_SIZE - 1) / ANIM_SECTOR_SIZE * ANIM_SECTOR_SIZE;
+    esp_err_t ret = esp_partition_erase_range(anim_partition, slot_offset(slot), erase_size);
+    if (ret != ESP_OK) return ret;
+
+    upload.active = true;
+    upload.slot = slot;
+    upload.header = header;
+    upload.written = 0;
+    ESP_LOGI(ANIM_TAG, "Receiving clip of %" PRIu32 " bytes into slot %d", header.size, slot);
+    return ESP_OK;
+}
+
+
+static esp_err_t write_chunk(uint8_t slot, const uint8_t *args, size_t len) {
+    if (len < 4) return ESP_ERR_INVALID_ARG;
+    if (!upload.active || upload.slot != slot) return ESP_ERR_INVALID_STATE;
+
+    uint32_t offset = read_be32(args);
+    const uint8_t *data = args + 4;
+    size_t data_len = len - 4;
+    // A redelivered chunk (QoS 1 duplicate) has been written already
+    if (offset < upload.written && data_len <= upload.written - offset) return ESP_OK;
+    if (offset != upload.written || data_len > upload.header.size - upload.written) return ESP_ERR_INVALID_SIZE;
+
+    esp_err_t ret = esp_partition_write(anim_partition, slot_offset(slot) + sizeof(anim_clip_header_t) + offset,
+                                        data, data_len);
+    if (ret != ESP_OK) return ret;
+    upload.written += data_len;
+    return ESP_OK;
+}
+
+
+static esp_err_t end_upload(uint8_t slot, const uint8_t *args, size_t len) {
+    if (len < 4) return ESP_ERR_INVALID_ARG;
+    if (!upload.active || upload.slot != slot) return ESP_ERR_INVALID_STATE;
+    upload.active = false;
+    if (upload.written != upload.header.size) return ESP_ERR_INVALID_SIZE;
+
+    const void *clip;
+    esp_partition_mmap_handle_t mmap_handle;
+    esp_err_t ret = esp_partition_mmap(anim_partition, slot_offset(slot) + sizeof(anim_clip_header_t),
+                                       upload.header.size, ESP_PARTITION_MMAP_DATA, &clip, &mmap_handle);
+    if (ret != ESP_OK) return ret;
+
+    upload.header.crc32 = esp_rom_crc32_le(0, clip, upload.header.size);
+    if (upload.header.crc32 != read_be32(args)) {
+        ret = ESP_ERR_INVALID_CRC;
+    } else {
+        ret = check_frames(clip, upload.header.size, upload.header.frame_count);
+    }
+    esp_partition_munmap(mmap_handle);
+    if (ret != ESP_OK) return ret;
+
+    ret = esp_partition_write(anim_partition, slot_offset(slot), &upload.header, sizeof(upload.header));
+    if (ret == ESP_OK) {
+        ESP_LOGI(ANIM_TAG, "Stored clip of %d frames in slot %d", upload.header.frame_count, slot);
+    }
+    return ret;
+}
+
+
+static esp_err_t play_locked(uint8_t slot, bool loop) {
+    if (slot >= LED_ANIM_SLOTS) return ESP_ERR_INVALID_ARG;
+
+    anim_clip_header_t header;
+    esp_err_t ret = esp_partition_read(anim_partition, slot_offset(slot), &header, sizeof(header));
+    if (ret != ESP_OK) return ret;
+    if (header.magic != ANIM_CLIP_MAGIC) return ESP_ERR_INVALID_STATE;
+
+    unmap_clip();
+    const void *clip;
+    ret = esp_partition_mmap(anim_partition, slot_offset(slot) + sizeof(header), header.size,
+                             ESP_PARTITION_MMAP_DATA, &clip, &player.mmap_handle);
+    if (ret != ESP_OK) return ret;
+
+    player.slot = slot;
+    player.clip = clip;
+    player.size = header.size;
+    player.cursor = 0;
+    player.loop = loop;
+    player.playing = true;
+    return esp_timer_start_periodic(frame_timer, header.interval_ms * 1000);
+}
+
+
+esp_err_t led_anim_init(void) {
+    if (anim_lock) return ESP_OK;
+
+    anim_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, LED_ANIM_PARTITION_SUBTYPE,
+                                              LED_ANIM_PARTITION_LABEL);
+    if (!anim_partition) return ESP_ERR_NOT_FOUND;
+    slot_size = anim_partition->size / LED_ANIM_SLOTS / ANIM_SECTOR_SIZE * ANIM_SECTOR_SIZE;
+
+    anim_lock = xSemaphoreCreateMutex();
+    if (!anim_lock) return ESP_ERR_NO_MEM;
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = frame_tick,
+        .name = "anim_frame",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &frame_timer);
+    if (ret != ESP_OK) return ret;
+
+    if (xTaskCreatePinnedToCore(play_frames, "Animation playback", 2048, NULL, PLAY_TASK_PRIORITY, &play_task,
+                                LED_NET_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+
+esp_err_t led_anim_handle_message(const uint8_t *payload, size_t len) {
+    if (!anim_lock) return ESP_ERR_INVALID_STATE;
+    if (len < 1) return ESP_ERR_INVALID_ARG;
+    if (payload[0] == ANIM_OP_STOP) {
+        led_anim_stop();
+        return ESP_OK;
+    }
+    if (len < 2 || payload[1] >= LED_ANIM_SLOTS) return ESP_ERR_INVALID_ARG;
+
+    uint8_t slot = payload[1];
+    const uint8_t *args = payload + 2;
+    size_t args_len = len - 2;
+    esp_err_t ret = ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(anim_lock, portMAX_DELAY);
+    switch (payload[0]) {
+        case ANIM_OP_BEGIN:
+            ret = begin_upload(slot, args, args_len);
+            break;
+        case ANIM_OP_DATA:
+            ret = write_chunk(slot, args, args_len);
+            break;
+        case ANIM_OP_END:
+            ret = end_upload(slot, args, args_len);
+            break;
+        case ANIM_OP_PLAY:
+            if (args_len < 1) break;
+            ret = play_locked(slot, args[0] & ANIM_PLAY_LOOP);
+            break;
+    }
+    xSemaphoreGive(anim_lock);
+    return ret;
+}
+
+
+uint32_t led_anim_upload_written(void) {
+    if (!anim_lock) return 0;
+
+    xSemaphoreTake(anim_lock, portMAX_DELAY);
+    uint32_t written = upload.active ? upload.written : 0;
+    xSemaphoreGive(anim_lock);
+    return written;
+}
+
+
+esp_err_t led_anim_play(uint8_t slot, bool loop) {
+    if (!anim_lock) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(anim_lock, portMAX_DELAY);
+    esp_err_t ret = play_locked(slot, loop);
+    xSemaphoreGive(anim_lock);
+    return ret;
+}
+
+
+void led_anim_stop(void) {
+    if (!anim_lock) return;
+
+    xSemaphoreTake(anim_lock, portMAX_DELAY);
+    esp_timer_stop(frame_timer);
+    player.playing = false;
+    xSemaphoreGive(anim_lock);
+}
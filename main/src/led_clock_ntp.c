@@ -0,0 +1,89 @@
+#include <string.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+#include "led_clock_sync.h"
+
+
+#define CLOCK_TAG               "CLOCK_SYNC"
+#define NTP_PACKET_LEN          48
+#define NTP_VERSION_4_CLIENT    0x23        // LI 0, VN 4, mode 3
+#define NTP_MODE_MASK           0x07
+#define NTP_MODE_SERVER         4
+#define NTP_RX_TIMEOUT_MS       500
+#define CLOCK_SYNC_BURST_MS     100         // Interval until the filter is full the first time
+
+
+static uint32_t read_be32(const uint8_t *buf) {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+/* NTP timestamp (32.32 seconds since 1900) in microseconds */
+static int64_t ntp_to_us(const uint8_t *buf) {
+    uint64_t seconds = read_be32(buf);
+    uint64_t fraction = read_be32(buf + 4);
+    return seconds * 1000000 + ((fraction * 1000000) >> 32);
+}
+
+
+/* One request/response exchange. Returns 0 on success. */
+static int exchange(int sock) {
+    uint8_t packet[NTP_PACKET_LEN] = { NTP_VERSION_4_CLIENT };
+
+    // The transmit timestamp only has to come back as the origin timestamp, the local time makes a fine cookie
+    int64_t t0 = esp_timer_get_time();
+    memcpy(packet + 40, &t0, sizeof(t0));
+    uint8_t cookie[8];
+    memcpy(cookie, packet + 40, sizeof(cookie));
+
+    if (send(sock, packet, sizeof(packet), 0) != sizeof(packet)) return -1;
+
+    while (1) {
+        int len = recv(sock, packet, sizeof(packet), 0);
+        int64_t t3 = esp_timer_get_time();
+        if (len < 0) return -1;     // Timeout
+        // Stale replies of earlier timed out requests carry another cookie
+        if (len < NTP_PACKET_LEN || (packet[0] & NTP_MODE_MASK) != NTP_MODE_SERVER ||
+            memcmp(packet + 24, cookie, sizeof(cookie))) continue;
+        if (packet[1] == 0) return -1;      // Stratum 0, kiss-o'-death
+
+        int64_t t1 = ntp_to_us(packet + 32);    // Server receive
+        int64_t t2 = ntp_to_us(packet + 40);    // Server transmit
+        led_clock_add_exchange(t0, t1, t2, t3);
+        return 0;
+    }
+}
+
+
+void process_clock_sync(void *arg) {
+    const char *server_ip = arg;
+    struct sockaddr_in server_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CLOCK_SYNC_PORT),
+    };
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0 || inet_pton(AF_INET, server_ip, &server_addr.sin_addr) <= 0 ||
+        connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        ESP_LOGE(CLOCK_TAG, "Failed to set up clock sync with %s", server_ip);
+        if (sock >= 0) close(sock);
+        vTaskDelete(NULL);
+    }
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = NTP_RX_TIMEOUT_MS * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    while (1) {
+        bool failed = exchange(sock);
+        if (failed) led_clock_add_failure();
+        led_clock_stats_t stats = led_clock_sync_get_stats();
+        if (!failed && stats.samples == 1) {
+            ESP_LOGI(CLOCK_TAG, "Synchronized to %s, rtt %" PRIu32 " us", server_ip, stats.rtt_us);
+        }
+        bool filling = stats.samples < CLOCK_SYNC_FILTER_SIZE;
+        vTaskDelay(pdMS_TO_TICKS(filling ? CLOCK_SYNC_BURST_MS : CLOCK_SYNC_INTERVAL_MS));
+    }
+}
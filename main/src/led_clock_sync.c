@@ -0,0 +1,77 @@
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#include "led_clock_sync.h"
+
+
+static portMUX_TYPE clock_lock = portMUX_INITIALIZER_UNLOCKED;
+static led_clock_stats_t clock_stats;
+
+static struct {
+    int64_t offset_us;
+    uint32_t rtt_us;
+} samples[CLOCK_SYNC_FILTER_SIZE];
+static int sample_count = 0;
+static int sample_next = 0;
+
+
+static void add_sample(int64_t offset_us, uint32_t rtt_us) {
+    samples[sample_next].offset_us = offset_us;
+    samples[sample_next].rtt_us = rtt_us;
+    sample_next = (sample_next + 1) % CLOCK_SYNC_FILTER_SIZE;
+    if (sample_count < CLOCK_SYNC_FILTER_SIZE) ++sample_count;
+
+    int best = 0;
+    for (int i = 1; i < sample_count; ++i) {
+        if (samples[i].rtt_us < samples[best].rtt_us) best = i;
+    }
+
+    portENTER_CRITICAL(&clock_lock);
+    clock_stats.synced = true;
+    clock_stats.offset_us = samples[best].offset_us;
+    clock_stats.rtt_us = samples[best].rtt_us;
+    ++clock_stats.samples;
+    portEXIT_CRITICAL(&clock_lock);
+}
+
+
+void led_clock_add_exchange(int64_t t0_us, int64_t t1_us, int64_t t2_us, int64_t t3_us) {
+    int64_t rtt = (t3_us - t0_us) - (t2_us - t1_us);
+    if (rtt < 0) rtt = 0;
+    add_sample(((t1_us - t0_us) + (t2_us - t3_us)) / 2, rtt);
+}
+
+
+void led_clock_add_failure(void) {
+    portENTER_CRITICAL(&clock_lock);
+    ++clock_stats.failures;
+    portEXIT_CRITICAL(&clock_lock);
+}
+
+
+bool led_clock_from_timecode(uint32_t timecode, int64_t *local_us) {
+    portENTER_CRITICAL(&clock_lock);
+    bool synced = clock_stats.synced;
+    int64_t offset_us = clock_stats.offset_us;
+    portEXIT_CRITICAL(&clock_lock);
+    if (!synced) return false;
+
+    int64_t local_now = esp_timer_get_time();
+    int64_t network_now = local_now + offset_us;
+    uint32_t seconds = network_now / 1000000;
+    uint32_t fraction = ((uint64_t)(network_now % 1000000) << 16) / 1000000;
+    uint32_t timecode_now = (seconds << 16) | fraction;
+
+    // Signed difference picks the closest instance of the wrapping timecode
+    int32_t diff = (int32_t)(timecode - timecode_now);
+    *local_us = local_now + (int64_t)diff * 1000000 / 65536;
+    return true;
+}
+
+
+led_clock_stats_t led_clock_sync_get_stats(void) {
+    portENTER_CRITICAL(&clock_lock);
+    led_clock_stats_t stats = clock_stats;
+    portEXIT_CRITICAL(&clock_lock);
+    return stats;
+}
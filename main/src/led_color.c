@@ -0,0 +1,54 @@
+#include <string.h>
+
+#include "led_color.h"
+#include "led_pixel_format.h"
+
+
+led_rgb_t led_hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val) {
+    // Six 60 degree sectors with an 8 bit position inside each
+    uint32_t scaled = (uint32_t)hue * 6;
+    uint8_t sector = scaled >> 16;
+    uint8_t position = scaled >> 8;
+
+    uint8_t low = led_scale8(val, 255 - sat);
+    uint8_t span = val - low;
+    uint8_t rising = low + led_scale8(span, position);
+    uint8_t falling = val - led_scale8(span, position);
+
+    switch (sector) {
+        case 0:  return (led_rgb_t){ val, rising, low };
+        case 1:  return (led_rgb_t){ falling, val, low };
+        case 2:  return (led_rgb_t){ low, val, rising };
+        case 3:  return (led_rgb_t){ low, falling, val };
+        case 4:  return (led_rgb_t){ rising, low, val };
+        default: return (led_rgb_t){ val, low, falling };
+    }
+}
+
+
+void led_fill_solid(uint8_t *frame, size_t first, size_t count, led_rgb_t color) {
+    if (count == 0) return;
+
+    uint8_t *dst = frame + first * LED_PIXEL_BYTES;
+    led_pixel_store(dst, color);
+
+    // Doubles the filled span with each memcpy instead of storing pixel by pixel
+    size_t filled = LED_PIXEL_BYTES;
+    size_t total = count * LED_PIXEL_BYTES;
+    while (filled < total) {
+        size_t chunk = (filled < total - filled) ? filled : total - filled;
+        memcpy(dst + filled, dst, chunk);
+        filled += chunk;
+    }
+}
+
+
+void led_fill_gradient(uint8_t *frame, size_t first, size_t count, uint16_t hue, int32_t hue_step,
+                       uint8_t sat, uint8_t val) {
+    uint8_t *dst = frame + first * LED_PIXEL_BYTES;
+    for (size_t i = 0; i < count; ++i) {
+        led_pixel_store(dst, led_hsv_to_rgb(hue, sat, val));
+        dst += LED_PIXEL_BYTES;
+        hue += hue_step;
+    }
+}
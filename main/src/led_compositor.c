@@ -0,0 +1,208 @@
+#include <string.h>
+
+#include "led_compositor.h"
+#include "led_frame_buffer.h"
+#include "led_math.h"
+
+
+#define MAX_FRAME_SPANS         (LED_LAYER_COUNT * LED_LAYER_MAX_SPANS)
+
+
+typedef struct {
+    uint16_t first;
+    uint16_t end;               // Exclusive
+} span_t;
+
+typedef struct {
+    uint8_t pixels[LED_FRAME_BYTES];
+    uint8_t alpha[LED_COUNT];
+    led_blend_t blend;
+    uint8_t opacity;
+    bool visible;
+    span_t spans[LED_LAYER_MAX_SPANS];
+    uint8_t span_count;
+} layer_t;
+
+
+static layer_t layers[LED_LAYER_COUNT] = {
+    [LED_LAYER_BASE] = { .opacity = 255, .visible = true },
+    [LED_LAYER_OVERLAY] = { .opacity = 255 },
+    [LED_LAYER_NOTIFY] = { .opacity = 255 },
+};
+static uint8_t composite[LED_FRAME_BYTES];
+
+
+static void blend_pixel(uint8_t *dst, const uint8_t *src, uint8_t alpha, led_blend_t blend) {
+    for (int c = 0; c < LED_PIXEL_BYTES; ++c) {
+        switch (blend) {
+            case LED_BLEND_ADD: {
+                uint16_t sum = dst[c] + led_scale8(src[c], alpha);
+                dst[c] = sum > 255 ? 255 : sum;
+                break;
+            }
+            case LED_BLEND_MULTIPLY:
+                dst[c] = led_lerp8(dst[c], led_scale8(dst[c], src[c]), alpha);
+                break;
+            default:
+                dst[c] = led_lerp8(dst[c], src[c], alpha);
+                break;
+        }
+    }
+}
+
+
+static void add_span(layer_t *layer, size_t first, size_t end) {
+    // Absorb every span this one touches
+    for (int i = 0; i < layer->span_count; ++i) {
+        span_t *span = &layer->spans[i];
+        if (first > span->end || end < span->first) continue;
+        if (span->first < first) first = span->first;
+        if (span->end > end) end = span->end;
+        *span = layer->spans[--layer->span_count];
+        --i;
+    }
+    if (layer->span_count == LED_LAYER_MAX_SPANS) {
+        // Out of spans: grow the one with the smallest gap, recompositing the gap is cheaper than tracking it
+        int closest = 0;
+        size_t closest_gap = SIZE_MAX;
+        for (int i = 0; i < layer->span_count; ++i) {
+            const span_t *span = &layer->spans[i];
+            size_t gap = span->first > end ? span->first - end : first - span->end;
+            if (gap < closest_gap) {
+                closest_gap = gap;
+                closest = i;
+            }
+        }
+        span_t *span = &layer->spans[closest];
+        if (span->first < first) first = span->first;
+        if (span->end > end) end = span->end;
+        *span = (span_t){ first, end };
+        return;
+    }
+    layer->spans[layer->span_count++] = (span_t){ first, end };
+}
+
+static void mark_all(layer_t *layer) {
+    layer->spans[0] = (span_t){ 0, LED_COUNT };
+    layer->span_count = 1;
+}
+
+
+void led_layer_set_blend(led_layer_id_t layer, led_blend_t blend, uint8_t opacity) {
+    if (layer == LED_LAYER_BASE || layer >= LED_LAYER_COUNT) return;
+    if (layers[layer].blend == blend && layers[layer].opacity == opacity) return;
+    layers[layer].blend = blend;
+    layers[layer].opacity = opacity;
+    mark_all(&layers[layer]);
+}
+
+
+bool led_layer_show(led_layer_id_t layer, bool visible) {
+    if (layer == LED_LAYER_BASE || layer >= LED_LAYER_COUNT || layers[layer].visible == visible) return false;
+    layers[layer].visible = visible;
+    mark_all(&layers[layer]);
+    return true;
+}
+
+
+void led_layer_fill(led_layer_id_t layer, size_t first, size_t count, led_rgb_t color, uint8_t alpha) {
+    if (layer >= LED_LAYER_COUNT || first >= LED_COUNT || count == 0) return;
+    if (count > LED_COUNT - first) count = LED_COUNT - first;
+    led_fill_solid(layers[layer].pixels, first, count, color);
+    memset(layers[layer].alpha + first, alpha, count);
+    add_span(&layers[layer], first, first + count);
+}
+
+
+void led_layer_update(led_layer_id_t layer, const uint8_t *pixels, const led_rgb_t *palette) {
+    if (layer >= LED_LAYER_COUNT) return;
+    layer_t *target = &layers[layer];
+
+    // Diffing is a compare per pixel, far cheaper than recompositing pixels that didn't change
+    size_t run_start = 0;
+    bool in_run = false;
+    for (size_t i = 0; i < LED_COUNT; ++i) {
+        const uint8_t *src = palette ? &palette[pixels[i]].r : pixels + i * LED_PIXEL_BYTES;
+        uint8_t *dst = target->pixels + i * LED_PIXEL_BYTES;
+        bool changed = memcmp(dst, src, LED_PIXEL_BYTES) || target->alpha[i] != 255;
+        if (changed) {
+            memcpy(dst, src, LED_PIXEL_BYTES);
+            target->alpha[i] = 255;
+            if (!in_run) run_start = i;
+        } else if (in_run) {
+            add_span(target, run_start, i);
+        }
+        in_run = changed;
+    }
+    if (in_run) add_span(target, run_start, LED_COUNT);
+}
+
+
+uint8_t *led_layer_pixels(led_layer_id_t layer) {
+    return layers[layer].pixels;
+}
+
+
+uint8_t *led_layer_alpha(led_layer_id_t layer) {
+    return layers[layer].alpha;
+}
+
+
+void led_layer_mark(led_layer_id_t layer, size_t first, size_t count) {
+    if (layer >= LED_LAYER_COUNT || first >= LED_COUNT || count == 0) return;
+    if (count > LED_COUNT - first) count = LED_COUNT - first;
+    add_span(&layers[layer], first, first + count);
+}
+
+
+bool led_compositor_active(void) {
+    for (int l = LED_LAYER_BASE + 1; l < LED_LAYER_COUNT; ++l) {
+        if (layers[l].visible) return true;
+    }
+    return false;
+}
+
+
+static void compose_span(size_t first, size_t end) {
+    memcpy(composite + first * LED_PIXEL_BYTES, layers[LED_LAYER_BASE].pixels + first * LED_PIXEL_BYTES,
+           (end - first) * LED_PIXEL_BYTES);
+    for (int l = LED_LAYER_BASE + 1; l < LED_LAYER_COUNT; ++l) {
+        const layer_t *layer = &layers[l];
+        if (!layer->visible || layer->opacity == 0) continue;
+        for (size_t i = first; i < end; ++i) {
+            uint8_t alpha = led_scale8(layer->alpha[i], layer->opacity);
+            if (alpha == 0) continue;
+            blend_pixel(composite + i * LED_PIXEL_BYTES, layer->pixels + i * LED_PIXEL_BYTES, alpha, layer->blend);
+        }
+    }
+}
+
+
+size_t led_compositor_compose(uint8_t *out) {
+    // Union of the dirty spans of all layers, sorted by first pixel. A layer that was just hidden has
+    // marked itself whole, so its last spans are covered.
+    span_t spans[MAX_FRAME_SPANS];
+    int span_count = 0;
+    for (int l = 0; l < LED_LAYER_COUNT; ++l) {
+        layer_t *layer = &layers[l];
+        for (int s = 0; s < layer->span_count; ++s) {
+            int i = span_count++;
+            for (; i > 0 && spans[i - 1].first > layer->spans[s].first; --i) spans[i] = spans[i - 1];
+            spans[i] = layer->spans[s];
+        }
+        layer->span_count = 0;
+    }
+
+    size_t composited = 0;
+    for (int s = 0; s < span_count; ) {
+        size_t first = spans[s].first;
+        size_t end = spans[s].end;
+        for (++s; s < span_count && spans[s].first <= end; ++s) {
+            if (spans[s].end > end) end = spans[s].end;
+        }
+        compose_span(first, end);
+        composited += end - first;
+    }
+    memcpy(out, composite, LED_FRAME_BYTES);
+    return composited;
+}
@@ -0,0 +1,88 @@
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "led_effect.h"
+#include "led_frame_buffer.h"
+#include "led_render_parallel.h"
+
+
+extern const led_effect_t led_effect_chase;
+extern const led_effect_t led_effect_rainbow;
+extern const led_effect_t led_effect_breathe;
+extern const led_effect_t led_effect_fire;
+extern const led_effect_t led_effect_plasma;
+extern const led_effect_t led_effect_text;
+extern const led_effect_t led_effect_program;
+
+static const led_effect_t *const effects[LED_EFFECT_COUNT] = {
+    [LED_EFFECT_CHASE] = &led_effect_chase,
+    [LED_EFFECT_RAINBOW] = &led_effect_rainbow,
+    [LED_EFFECT_BREATHE] = &led_effect_breathe,
+    [LED_EFFECT_FIRE] = &led_effect_fire,
+    [LED_EFFECT_PLASMA] = &led_effect_plasma,
+    [LED_EFFECT_TEXT] = &led_effect_text,
+    [LED_EFFECT_PROGRAM] = &led_effect_program,
+};
+
+// Only touched by the render loop
+static uint8_t canvas[LED_FRAME_BYTES];       // Only the first LED_COUNT bytes for indexed effects
+static led_rgb_t palette_colors[LED_EFFECT_PALETTE_SIZE];
+static uint32_t effect_state[LED_EFFECT_STATE_BYTES / sizeof(uint32_t)];
+static int active_effect = LED_EFFECT_NONE;
+static int64_t last_step_us = 0;
+
+
+int led_effect_find(const char *name, size_t len) {
+    if (len == strlen("none") && !memcmp(name, "none", len)) return LED_EFFECT_NONE;
+    for (int id = 0; id < LED_EFFECT_COUNT; ++id) {
+        if (effects[id] && len == strlen(effects[id]->name) && !memcmp(name, effects[id]->name, len)) return id;
+    }
+    return -1;
+}
+
+
+const char *led_effect_name(uint8_t id) {
+    if (id >= LED_EFFECT_COUNT || !effects[id]) return "none";
+    return effects[id]->name;
+}
+
+
+bool led_effect_render_frame(uint8_t id, const led_effect_params_t *params, uint8_t *out, led_rgb_t *palette) {
+    if (id >= LED_EFFECT_COUNT || !effects[id] || effects[id]->state_size > sizeof(effect_state)) {
+        memset(out, 0, LED_FRAME_BYTES);
+        return false;
+    }
+    const led_effect_t *effect = effects[id];
+    int64_t now = esp_timer_get_time();
+
+    bool changed = true;
+    if (id != active_effect) {
+        memset(canvas, 0, sizeof(canvas));
+        effect->init(effect_state, params);
+        active_effect = id;
+        last_step_us = now;
+    } else {
+        // Only whole milliseconds are consumed, the rest carries over into the next frame
+        uint32_t elapsed_ms = (now - last_step_us) / 1000;
+        last_step_us += (int64_t)elapsed_ms * 1000;
+        changed = effect->step(effect_state, params, elapsed_ms);
+    }
+
+    if (changed) {
+        if (effect->parallel && LED_COUNT >= LED_EFFECT_SPLIT_MIN_PIXELS) {
+            led_render_split(effect->render, canvas, LED_COUNT, effect_state);
+        } else {
+            effect->render(canvas, 0, LED_COUNT, effect_state);
+        }
+        if (effect->palette) effect->palette(palette_colors, effect_state);
+    }
+
+    if (!effect->palette) {
+        memcpy(out, canvas, LED_FRAME_BYTES);
+        return false;
+    }
+    memcpy(out, canvas, LED_COUNT);
+    memcpy(palette, palette_colors, sizeof(palette_colors));
+    return true;
+}
@@ -0,0 +1,89 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "led_effect.h"
+#include "led_vm.h"
+#include "led_pixel_map.h"
+#include "led_frame_buffer.h"
+
+
+/* The "program" effect: runs the bytecode uploaded with led_effect_load_program */
+typedef struct {
+    led_vm_program_t program;
+    uint32_t generation;
+    uint32_t elapsed_ms;
+    int32_t regs[LED_VM_REGISTERS];
+} program_state_t;
+
+_Static_assert(sizeof(program_state_t) <= LED_EFFECT_STATE_BYTES, "program state outgrew the effect state buffer");
+
+
+static portMUX_TYPE program_lock = portMUX_INITIALIZER_UNLOCKED;
+static led_vm_program_t uploaded;
+static uint32_t uploaded_generation = 0;       // 0 until the first upload
+static led_vm_program_t staging;                // Only touched by the uploading task
+
+
+esp_err_t led_effect_load_program(const uint8_t *data, size_t len) {
+    esp_err_t ret = led_vm_load(&staging, data, len);
+    if (ret != ESP_OK) return ret;
+
+    portENTER_CRITICAL(&program_lock);
+    uploaded = staging;
+    ++uploaded_generation;
+    portEXIT_CRITICAL(&program_lock);
+    return ESP_OK;
+}
+
+
+static void program_fetch(program_state_t *state) {
+    portENTER_CRITICAL(&program_lock);
+    state->program = uploaded;
+    state->generation = uploaded_generation;
+    portEXIT_CRITICAL(&program_lock);
+    state->elapsed_ms = 0;
+    memset(state->regs, 0, sizeof(state->regs));
+}
+
+static void program_init(void *state, const led_effect_params_t *params) {
+    (void)params;
+    program_fetch(state);
+}
+
+static bool program_step(void *state, const led_effect_params_t *params, uint32_t elapsed_ms) {
+    (void)params;
+    program_state_t *program = state;
+
+    portENTER_CRITICAL(&program_lock);
+    uint32_t generation = uploaded_generation;
+    portEXIT_CRITICAL(&program_lock);
+    if (program->generation != generation) {
+        program_fetch(program);
+    } else {
+        // 16.16 seconds would overflow after 9.1 h
+        program->elapsed_ms = (program->elapsed_ms + elapsed_ms) % (LED_VM_TIME_WRAP_S * 1000u);
+    }
+    int32_t time = (uint64_t)program->elapsed_ms * LED_VM_ONE / 1000;
+    led_vm_run_frame(&program->program, program->regs, time);
+    return true;
+}
+
+static void program_render(uint8_t *canvas, size_t first, size_t count, void *state) {
+    const program_state_t *program = state;
+    uint16_t width = led_map_width();
+
+    for (size_t i = first; i < first + count; ++i) {
+        led_rgb_t color = led_vm_run_pixel(&program->program, program->regs, i % width, i / width, i, LED_COUNT);
+        led_pixel_store(canvas + i * LED_PIXEL_BYTES, color);
+    }
+}
+
+const led_effect_t led_effect_program = {
+    .name = "program",
+    .state_size = sizeof(program_state_t),
+    .parallel = true,
+    .init = program_init,
+    .step = program_step,
+    .render = program_render,
+};
@@ -0,0 +1,396 @@
+#include <string.h>
+
+#include "led_effect.h"
+#include "led_color.h"
+#include "led_math.h"
+#include "led_frame_buffer.h"
+#include "led_pixel_map.h"
+#include "led_sprite.h"
+#include "smart_led_state.h"
+
+
+#define CHASE_SPEED_MS          10      // One pixel per step
+#define CHASE_LENGTH            10
+#define RAINBOW_PERIOD_MS       5000    // One full hue rotation
+#define RAINBOW_SPREAD          1       // Full hue circles across the strip
+#define BREATHE_PERIOD_MS       4000
+#define BREATHE_MIN_LEVEL       16
+#define FIRE_STEP_MS            15
+#define FIRE_MAX_STEPS          4       // Catching up after a gap doesn't need more than a few
+#define FIRE_COOLING            55
+#define FIRE_SPARKING           120
+#define PLASMA_SCALE            48      // Noise units (1/256 cell) per pixel, smaller is smoother
+#define PLASMA_DRIFT_MS         8       // One noise unit of drift per step
+#define TEXT_SCROLL_MS          60      // One column per step
+
+
+static void set_pixel(uint8_t *canvas, size_t index, led_rgb_t color) {
+    led_pixel_store(canvas + index * LED_PIXEL_BYTES, color);
+}
+
+static bool same_color(led_rgb_t a, led_rgb_t b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+
+/* ------------------------------ Chase ------------------------------ */
+
+typedef struct {
+    led_rgb_t color;
+    uint32_t elapsed_ms;
+    size_t head;                // First pixel of the segment
+    size_t prev_head;
+    bool redraw;                // Everything changed, not just the segment ends
+} chase_state_t;
+
+
+static void chase_init(void *state, const led_effect_params_t *params) {
+    chase_state_t *chase = state;
+    *chase = (chase_state_t){ .color = params->color, .redraw = true };
+}
+
+static bool chase_step(void *state, const led_effect_params_t *params, uint32_t elapsed_ms) {
+    chase_state_t *chase = state;
+
+    chase->prev_head = chase->head;
+    chase->redraw = !same_color(chase->color, params->color);
+    chase->color = params->color;
+
+    chase->elapsed_ms += elapsed_ms;
+    uint32_t advance = chase->elapsed_ms / CHASE_SPEED_MS;
+    chase->elapsed_ms %= CHASE_SPEED_MS;
+    if (advance >= LED_COUNT) chase->redraw = true;
+    chase->head = (chase->head + advance) % LED_COUNT;
+
+    return chase->redraw || advance;
+}
+
+static bool in_segment(size_t index, size_t head) {
+    return (index + LED_COUNT - head) % LED_COUNT < CHASE_LENGTH;
+}
+
+static void chase_render(uint8_t *canvas, size_t first, size_t count, void *state) {
+    const chase_state_t *chase = state;
+    static const led_rgb_t black = {0};
+
+    if (chase->redraw) {
+        for (size_t i = first; i < first + count; ++i) {
+            set_pixel(canvas, i, in_segment(i, chase->head) ? chase->color : black);
+        }
+        return;
+    }
+    // Only the pixels the segment left or entered
+    for (size_t n = 0; n < CHASE_LENGTH; ++n) {
+        size_t old_index = (chase->prev_head + n) % LED_COUNT;
+        size_t new_index = (chase->head + n) % LED_COUNT;
+        if (old_index >= first && old_index < first + count && !in_segment(old_index, chase->head)) {
+            set_pixel(canvas, old_index, black);
+        }
+        if (new_index >= first && new_index < first + count && !in_segment(new_index, chase->prev_head)) {
+            set_pixel(canvas, new_index, chase->color);
+        }
+    }
+}
+
+const led_effect_t led_effect_chase = {
+    .name = "chase",
+    .state_size = sizeof(chase_state_t),
+    .init = chase_init,
+    .step = chase_step,
+    .render = chase_render,
+};
+
+
+/* ----------------------------- Rainbow ----------------------------- */
+
+/* Indexed: the pixels hold fixed positions on the hue circle and the animation only rotates the palette */
+typedef struct {
+    uint32_t elapsed_ms;
+    uint8_t rotation;
+    bool redraw;
+    led_rgb_t wheel[LED_EFFECT_PALETTE_SIZE];   // One full hue circle
+} rainbow_state_t;
+
+_Static_assert(sizeof(rainbow_state_t) <= LED_EFFECT_STATE_BYTES, "rainbow state outgrew the effect state buffer");
+
+
+static void rainbow_init(void *state, const led_effect_params_t *params) {
+    rainbow_state_t *rainbow = state;
+    *rainbow = (rainbow_state_t){ .redraw = true };
+    for (int i = 0; i < LED_EFFECT_PALETTE_SIZE; ++i) {
+        rainbow->wheel[i] = led_hsv_to_rgb(i << 8, 255, 255);
+    }
+}
+
+static bool rainbow_step(void *state, const led_effect_params_t *params, uint32_t elapsed_ms) {
+    rainbow_state_t *rainbow = state;
+
+    rainbow->redraw = false;
+    rainbow->elapsed_ms = (rainbow->elapsed_ms + elapsed_ms) % RAINBOW_PERIOD_MS;
+    uint8_t rotation = rainbow->elapsed_ms * LED_EFFECT_PALETTE_SIZE / RAINBOW_PERIOD_MS;
+    bool changed = rotation != rainbow->rotation;
+    rainbow->rotation = rotation;
+    return changed;
+}
+
+static void rainbow_render(uint8_t *canvas, size_t first, size_t count, void *state) {
+    const rainbow_state_t *rainbow = state;
+    if (!rainbow->redraw) return;
+    for (size_t i = first; i < first + count; ++i) {
+        canvas[i] = i * LED_EFFECT_PALETTE_SIZE * RAINBOW_SPREAD / LED_COUNT;
+    }
+}
+
+static void rainbow_palette(led_rgb_t *palette, const void *state) {
+    const rainbow_state_t *rainbow = state;
+    size_t head = LED_EFFECT_PALETTE_SIZE - rainbow->rotation;
+    memcpy(palette, rainbow->wheel + rainbow->rotation, head * sizeof(led_rgb_t));
+    memcpy(palette + head, rainbow->wheel, rainbow->rotation * sizeof(led_rgb_t));
+}
+
+const led_effect_t led_effect_rainbow = {
+    .name = "rainbow",
+    .state_size = sizeof(rainbow_state_t),
+    .init = rainbow_init,
+    .step = rainbow_step,
+    .render = rainbow_render,
+    .palette = rainbow_palette,
+};
+
+
+/* ----------------------------- Breathe ----------------------------- */
+
+typedef struct {
+    uint32_t elapsed_ms;
+    led_rgb_t color;
+    led_rgb_t shown;
+} breathe_state_t;
+
+
+static led_rgb_t breathe_color(const breathe_state_t *breathe) {
+    // Sine wave squared, starting at the bottom: slow near the bottom, where the eye is most sensitive
+    uint8_t phase = breathe->elapsed_ms * 256 / BREATHE_PERIOD_MS;
+    uint8_t wave = led_sin8(phase - 64);
+    uint8_t level = BREATHE_MIN_LEVEL + led_scale8(led_scale8(wave, wave), 255 - BREATHE_MIN_LEVEL);
+    return (led_rgb_t){
+        led_scale8(breathe->color.r, level),
+        led_scale8(breathe->color.g, level),
+        led_scale8(breathe->color.b, level),
+    };
+}
+
+static void breathe_init(void *state, const led_effect_params_t *params) {
+    breathe_state_t *breathe = state;
+    *breathe = (breathe_state_t){ .color = params->color };
+    breathe->shown = breathe_color(breathe);
+}
+
+static bool breathe_step(void *state, const led_effect_params_t *params, uint32_t elapsed_ms) {
+    breathe_state_t *breathe = state;
+
+    breathe->elapsed_ms = (breathe->elapsed_ms + elapsed_ms) % BREATHE_PERIOD_MS;
+    breathe->color = params->color;
+    led_rgb_t color = breathe_color(breathe);
+    bool changed = !same_color(color, breathe->shown);
+    breathe->shown = color;
+    return changed;
+}
+
+static void breathe_render(uint8_t *canvas, size_t first, size_t count, void *state) {
+    const breathe_state_t *breathe = state;
+    led_fill_solid(canvas, first, count, breathe->shown);
+}
+
+const led_effect_t led_effect_breathe = {
+    .name = "breathe",
+    .state_size = sizeof(breathe_state_t),
+    .init = breathe_init,
+    .step = breathe_step,
+    .render = breathe_render,
+};
+
+
+/* ------------------------------- Fire ------------------------------ */
+
+/* Heat diffusion along the strip (after Fire2012), base at pixel 0 */
+typedef struct {
+    uint32_t elapsed_ms;
+    led_rng_t rng;
+    uint8_t heat[LED_COUNT];
+    uint8_t shown[LED_COUNT];       // Heat the canvas currently shows
+    bool redraw;
+} fire_state_t;
+
+_Static_assert(sizeof(fire_state_t) <= LED_EFFECT_STATE_BYTES, "fire state outgrew the effect state buffer");
+
+
+static uint8_t sub_clamp(uint8_t a, uint8_t b) {
+    return a > b ? a - b : 0;
+}
+
+static led_rgb_t heat_color(uint8_t heat) {
+    uint8_t t192 = led_scale8(heat, 191);
+    uint8_t ramp = (t192 & 0x3F) << 2;
+    if (t192 & 0x80) return (led_rgb_t){ 255, 255, ramp };
+    if (t192 & 0x40) return (led_rgb_t){ 255, ramp, 0 };
+    return (led_rgb_t){ ramp, 0, 0 };
+}
+
+static void fire_init(void *state, const led_effect_params_t *params) {
+    fire_state_t *fire = state;
+    memset(fire, 0, sizeof(*fire));
+    led_rng_seed(&fire->rng, 0);
+    fire->redraw = true;
+}
+
+static bool fire_step(void *state, const led_effect_params_t *params, uint32_t elapsed_ms) {
+    fire_state_t *fire = state;
+
+    fire->redraw = false;
+    fire->elapsed_ms += elapsed_ms;
+    uint32_t steps = fire->elapsed_ms / FIRE_STEP_MS;
+    fire->elapsed_ms %= FIRE_STEP_MS;
+    if (steps > FIRE_MAX_STEPS) steps = FIRE_MAX_STEPS;
+
+    for (uint32_t s = 0; s < steps; ++s) {
+        uint8_t max_cooling = FIRE_COOLING * 10 / LED_COUNT + 2;
+        for (size_t i = 0; i < LED_COUNT; ++i) {
+            fire->heat[i] = sub_clamp(fire->heat[i], led_random_below(&fire->rng, max_cooling));
+        }
+        for (size_t i = LED_COUNT - 1; i >= 2; --i) {
+            fire->heat[i] = (fire->heat[i - 1] + 2 * fire->heat[i - 2]) / 3;
+        }
+        if (led_random8(&fire->rng) < FIRE_SPARKING) {
+            size_t spark = led_random_below(&fire->rng, 7);
+            uint16_t heat = fire->heat[spark] + 160 + led_random_below(&fire->rng, 96);
+            fire->heat[spark] = heat > 255 ? 255 : heat;
+        }
+    }
+    return steps > 0;
+}
+
+static void fire_render(uint8_t *canvas, size_t first, size_t count, void *state) {
+    fire_state_t *fire = state;
+
+    for (size_t i = first; i < first + count; ++i) {
+        if (!fire->redraw && fire->heat[i] == fire->shown[i]) continue;
+        set_pixel(canvas, i, heat_color(fire->heat[i]));
+        fire->shown[i] = fire->heat[i];
+    }
+}
+
+const led_effect_t led_effect_fire = {
+    .name = "fire",
+    .state_size = sizeof(fire_state_t),
+    .init = fire_init,
+    .step = fire_step,
+    .render = fire_render,
+};
+
+
+/* ------------------------------- Text ------------------------------ */
+
+/* Scrolls the text right to left across the grid, vertically centred, entering again once it has left */
+typedef struct {
+    uint32_t elapsed_ms;
+    led_rgb_t color;
+    char text[LED_STATE_TEXT_LEN + 1];
+    int text_width;
+    int offset;                 // Columns scrolled since the text entered at the right edge
+} text_state_t;
+
+
+static void text_set(text_state_t *text, const led_effect_params_t *params) {
+    // The last byte stays 0 from init
+    strncpy(text->text, params->text ? params->text : "", sizeof(text->text) - 1);
+    text->text_width = led_text_width(text->text);
+    text->offset = 0;
+}
+
+static void text_init(void *state, const led_effect_params_t *params) {
+    text_state_t *text = state;
+    *text = (text_state_t){ .color = params->color };
+    text_set(text, params);
+}
+
+static bool text_step(void *state, const led_effect_params_t *params, uint32_t elapsed_ms) {
+    text_state_t *text = state;
+
+    bool changed = !same_color(text->color, params->color);
+    text->color = params->color;
+    if (strcmp(text->text, params->text ? params->text : "")) {
+        text_set(text, params);
+        text->elapsed_ms = 0;
+        return true;
+    }
+
+    text->elapsed_ms += elapsed_ms;
+    uint32_t advance = text->elapsed_ms / TEXT_SCROLL_MS;
+    text->elapsed_ms %= TEXT_SCROLL_MS;
+    if (advance == 0 || text->text_width == 0) return changed;
+    text->offset = (text->offset + advance) % (led_map_width() + text->text_width);
+    return true;
+}
+
+static void text_render(uint8_t *canvas, size_t first, size_t count, void *state) {
+    const text_state_t *text = state;
+    int y = (led_map_height() - LED_SPRITE_HEIGHT) / 2;
+
+    memset(canvas + first * LED_PIXEL_BYTES, 0, count * LED_PIXEL_BYTES);
+    led_blit_text(canvas, text->text, led_map_width() - text->offset, y, text->color, 255);
+}
+
+const led_effect_t led_effect_text = {
+    .name = "text",
+    .state_size = sizeof(text_state_t),
+    .init = text_init,
+    .step = text_step,
+    .render = text_render,
+};
+
+
+/* ------------------------------ Plasma ----------------------------- */
+
+/* Hue from 2D noise drifting across the grid, brightness from a second, slower noise layer */
+typedef struct {
+    uint32_t elapsed_ms;
+    uint16_t drift;
+} plasma_state_t;
+
+
+static void plasma_init(void *state, const led_effect_params_t *params) {
+    plasma_state_t *plasma = state;
+    *plasma = (plasma_state_t){0};
+}
+
+static bool plasma_step(void *state, const led_effect_params_t *params, uint32_t elapsed_ms) {
+    plasma_state_t *plasma = state;
+
+    plasma->elapsed_ms += elapsed_ms;
+    uint32_t advance = plasma->elapsed_ms / PLASMA_DRIFT_MS;
+    plasma->elapsed_ms %= PLASMA_DRIFT_MS;
+    plasma->drift += advance;
+    return advance > 0;
+}
+
+static void plasma_render(uint8_t *canvas, size_t first, size_t count, void *state) {
+    const plasma_state_t *plasma = state;
+    uint16_t width = led_map_width();
+
+    for (size_t i = first; i < first + count; ++i) {
+        uint16_t x = i % width * PLASMA_SCALE;
+        uint16_t y = i / width * PLASMA_SCALE;
+        uint8_t hue = led_noise8_2d(x + plasma->drift, y - plasma->drift / 2);
+        uint8_t level = led_noise8_2d(y + plasma->drift / 4, x);
+        set_pixel(canvas, i, led_hsv_to_rgb(hue << 8, 255, 64 + led_scale8(level, 191)));
+    }
+}
+
+const led_effect_t led_effect_plasma = {
+    .name = "plasma",
+    .state_size = sizeof(plasma_state_t),
+    .parallel = true,
+    .init = plasma_init,
+    .step = plasma_step,
+    .render = plasma_render,
+};
@@ -0,0 +1,82 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "led_frame_buffer.h"
+
+
+static uint8_t frame_buffers[3][LED_FRAME_BYTES];
+
+static uint8_t back_index = 0;
+static uint8_t pending_index = 1;
+static uint8_t front_index = 2;
+static bool frame_pending = false;
+static bool back_is_stale = true;   // The back buffer doesn't hold the newest committed frame
+
+// Guards the index swaps only, never the pixel copies
+static portMUX_TYPE swap_lock = portMUX_INITIALIZER_UNLOCKED;
+// Serializes producers (MQTT frame topic, UDP receiver) on the back buffer
+static SemaphoreHandle_t write_lock = NULL;
+
+
+esp_err_t led_fb_init(void) {
+    if (write_lock) return ESP_OK;
+
+    write_lock = xSemaphoreCreateMutex();
+    if (!write_lock) return ESP_ERR_NO_MEM;
+    return ESP_OK;
+}
+
+
+uint8_t *led_fb_begin_write(void) {
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+    back_is_stale = true;   // About to be overwritten with something other than the newest frame
+    return frame_buffers[back_index];
+}
+
+
+uint8_t *led_fb_begin_update(void) {
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+    if (back_is_stale) {
+        // The newest frame is pending, or already on the front if the render loop took it. Either way the
+        // render loop only reads it and a swap can't hand it to a producer while we hold the write lock.
+        portENTER_CRITICAL(&swap_lock);
+        uint8_t latest_index = frame_pending ? pending_index : front_index;
+        portEXIT_CRITICAL(&swap_lock);
+        memcpy(frame_buffers[back_index], frame_buffers[latest_index], LED_FRAME_BYTES);
+        back_is_stale = false;
+    }
+    return frame_buffers[back_index];
+}
+
+
+void led_fb_end_write(bool commit) {
+    if (commit) {
+        portENTER_CRITICAL(&swap_lock);
+        uint8_t tmp = pending_index;
+        pending_index = back_index;
+        back_index = tmp;
+        frame_pending = true;
+        portEXIT_CRITICAL(&swap_lock);
+        back_is_stale = true;
+    }
+    xSemaphoreGive(write_lock);
+}
+
+
+const uint8_t *led_fb_take_latest(void) {
+    const uint8_t *frame = NULL;
+
+    portENTER_CRITICAL(&swap_lock);
+    if (frame_pending) {
+        uint8_t tmp = front_index;
+        front_index = pending_index;
+        pending_index = tmp;
+        frame_pending = false;
+        frame = frame_buffers[front_index];
+    }
+    portEXIT_CRITICAL(&swap_lock);
+
+    return frame;
+}
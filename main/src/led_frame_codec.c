@@ -0,0 +1,142 @@
+#include <string.h>
+#include <stdbool.h>
+
+#include "led_frame_codec.h"
+#include "led_pixel_format.h"
+
+
+static bool same_pixel(const uint8_t *a, const uint8_t *b) {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+
+/* Walks the ops once. With apply == false it only validates, so frame may be NULL. */
+static esp_err_t walk_ops(const uint8_t *data, size_t len, uint8_t *frame, size_t pixel_count, bool apply) {
+    size_t pos = 1;     // Skip flags
+    size_t pixel = 0;
+
+    while (pos < len) {
+        uint8_t op = data[pos++];
+        size_t count = (op & FRAME_OP_COUNT_MASK) + 1;
+        if ((op & FRAME_OP_COUNT_MASK) == FRAME_OP_COUNT_MASK) {
+            if (pos >= len) return ESP_ERR_INVALID_SIZE;
+            count = 64 + data[pos++];
+        }
+        if (count > pixel_count - pixel) return ESP_ERR_INVALID_SIZE;
+
+        uint8_t *dst = apply ? frame + pixel * LED_PIXEL_BYTES : NULL;
+        size_t bytes = count * LED_PIXEL_BYTES;
+        switch (op & FRAME_OP_MASK) {
+            case FRAME_OP_SKIP:
+                break;
+            case FRAME_OP_COPY:
+                if (bytes > len - pos) return ESP_ERR_INVALID_SIZE;
+                if (apply) memcpy(dst, data + pos, bytes);
+                pos += bytes;
+                break;
+            case FRAME_OP_FILL:
+                if (LED_PIXEL_BYTES > len - pos) return ESP_ERR_INVALID_SIZE;
+                if (apply) {
+                    for (size_t i = 0; i < bytes; i += LED_PIXEL_BYTES) {
+                        dst[i + 0] = data[pos + 0];
+                        dst[i + 1] = data[pos + 1];
+                        dst[i + 2] = data[pos + 2];
+                    }
+                }
+                pos += LED_PIXEL_BYTES;
+                break;
+            case FRAME_OP_XOR:
+                if (bytes > len - pos) return ESP_ERR_INVALID_SIZE;
+                if (apply) {
+                    for (size_t i = 0; i < bytes; ++i) dst[i] ^= data[pos + i];
+                }
+                pos += bytes;
+                break;
+        }
+        pixel += count;
+    }
+    return ESP_OK;
+}
+
+
+esp_err_t led_frame_decode(const uint8_t *data, size_t len, uint8_t *frame, size_t frame_bytes) {
+    if (!data || !frame) return ESP_ERR_INVALID_ARG;
+    if (len < 1) return ESP_ERR_INVALID_SIZE;
+
+    size_t pixel_count = frame_bytes / LED_PIXEL_BYTES;
+    esp_err_t ret = walk_ops(data, len, NULL, pixel_count, false);
+    if (ret != ESP_OK) return ret;
+
+    if (data[0] & FRAME_CODEC_KEYFRAME) memset(frame, 0, frame_bytes);
+    return walk_ops(data, len, frame, pixel_count, true);
+}
+
+
+static bool emit_op(uint8_t *out, size_t out_len, size_t *pos, uint8_t op, size_t count,
+                    const uint8_t *payload, size_t payload_len) {
+    size_t header_len = (count >= 64) ? 2 : 1;
+    if (header_len + payload_len > out_len - *pos) return false;
+
+    if (count >= 64) {
+        out[(*pos)++] = op | FRAME_OP_COUNT_MASK;
+        out[(*pos)++] = count - 64;
+    } else {
+        out[(*pos)++] = op | (count - 1);
+    }
+    if (payload_len) memcpy(out + *pos, payload, payload_len);
+    *pos += payload_len;
+    return true;
+}
+
+
+size_t led_frame_encode(const uint8_t *frame, const uint8_t *prev, size_t frame_bytes, uint8_t *out, size_t out_len) {
+    static const uint8_t black[LED_PIXEL_BYTES] = {0};
+    size_t pixel_count = frame_bytes / LED_PIXEL_BYTES;
+    size_t pos = 0;
+    size_t i = 0;
+
+    if (out_len < 1) return 0;
+    out[pos++] = prev ? 0 : FRAME_CODEC_KEYFRAME;
+
+// Keyframes apply onto black
+#define BASE(p)     (prev ? prev + (p) * LED_PIXEL_BYTES : black)
+#define PIXEL(p)    (frame + (p) * LED_PIXEL_BYTES)
+
+    while (i < pixel_count) {
+        size_t run = 0;
+
+        // Unchanged pixels
+        while (i + run < pixel_count && run < FRAME_OP_MAX_COUNT && same_pixel(PIXEL(i + run), BASE(i + run))) ++run;
+        if (run) {
+            if (i + run == pixel_count) break;      // Trailing pixels stay unchanged anyway
+            if (!emit_op(out, out_len, &pos, FRAME_OP_SKIP, run, NULL, 0)) return 0;
+            i += run;
+            continue;
+        }
+
+        // Runs of a single color
+        run = 1;
+        while (i + run < pixel_count && run < FRAME_OP_MAX_COUNT && same_pixel(PIXEL(i + run), PIXEL(i))) ++run;
+        if (run >= 2) {
+            if (!emit_op(out, out_len, &pos, FRAME_OP_FILL, run, PIXEL(i), LED_PIXEL_BYTES)) return 0;
+            i += run;
+            continue;
+        }
+
+        // Literal span up to the next unchanged pixel or color run
+        run = 1;
+        while (i + run < pixel_count && run < FRAME_OP_MAX_COUNT) {
+            size_t p = i + run;
+            if (same_pixel(PIXEL(p), BASE(p))) break;
+            if (p + 1 < pixel_count && same_pixel(PIXEL(p), PIXEL(p + 1))) break;
+            ++run;
+        }
+        if (!emit_op(out, out_len, &pos, FRAME_OP_COPY, run, PIXEL(i), run * LED_PIXEL_BYTES)) return 0;
+        i += run;
+    }
+
+#undef BASE
+#undef PIXEL
+
+    return pos;
+}
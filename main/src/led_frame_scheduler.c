@@ -0,0 +1,86 @@
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "led_frame_scheduler.h"
+
+
+static TaskHandle_t render_task = NULL;
+static esp_timer_handle_t frame_clock = NULL;
+static atomic_bool frame_dirty = true;     // The first tick always renders
+
+// Written by the render task only, the lock keeps readers on the other core from seeing torn 64 bit values
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static led_sched_stats_t sched_stats;
+static int64_t busy_since = 0;
+
+
+static void frame_tick(void *arg) {
+    xTaskNotifyGive(render_task);
+}
+
+
+esp_err_t led_sched_init(const led_sched_config_t *config) {
+    if (!config || config->target_fps == 0) return ESP_ERR_INVALID_ARG;
+    if (frame_clock) return ESP_OK;
+
+    render_task = xTaskGetCurrentTaskHandle();
+    const esp_timer_create_args_t timer_args = {
+        .callback = frame_tick,
+        .name = "frame_clock",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &frame_clock);
+    if (ret != ESP_OK) return ret;
+
+    busy_since = esp_timer_get_time();
+    return esp_timer_start_periodic(frame_clock, 1000000 / config->target_fps);
+}
+
+
+void led_sched_mark_dirty(void) {
+    atomic_store(&frame_dirty, true);
+}
+
+
+void led_sched_render_now(void) {
+    atomic_store(&frame_dirty, true);
+    if (render_task) xTaskNotifyGive(render_task);
+}
+
+
+bool led_sched_wait_frame(void) {
+    int64_t idle_since = esp_timer_get_time();
+
+    // Ticks that piled up while rendering collapse into one
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&stats_lock);
+    sched_stats.busy_us += idle_since - busy_since;
+    sched_stats.idle_us += now - idle_since;
+    ++sched_stats.ticks;
+    portEXIT_CRITICAL(&stats_lock);
+    busy_since = now;
+    return atomic_exchange(&frame_dirty, false);
+}
+
+
+void led_sched_end_frame(bool rendered) {
+    portENTER_CRITICAL(&stats_lock);
+    if (rendered) {
+        ++sched_stats.frames_rendered;
+    } else {
+        ++sched_stats.frames_skipped;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+
+led_sched_stats_t led_sched_get_stats(void) {
+    portENTER_CRITICAL(&stats_lock);
+    led_sched_stats_t stats = sched_stats;
+    portEXIT_CRITICAL(&stats_lock);
+    return stats;
+}
@@ -0,0 +1,59 @@
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "led_gamma.h"
+#include "led_gamma_tables.h"     // Generated
+
+
+#define GAMMA_TAG               "GAMMA"
+#define DITHER_PIXEL_STRIDE     97      // Odd, so neighbouring pixels get unrelated offsets
+
+
+static uint16_t output_lut[256];        // Curve x brightness, 8.8 fixed point
+static bool lut_has_fraction = false;
+static int lut_curve = -1;
+static uint8_t lut_brightness = 0;
+static uint8_t dither_frame = 0;
+
+
+static uint8_t reverse_bits(uint8_t value) {
+    value = (value & 0xF0) >> 4 | (value & 0x0F) << 4;
+    value = (value & 0xCC) >> 2 | (value & 0x33) << 2;
+    value = (value & 0xAA) >> 1 | (value & 0x55) << 1;
+    return value;
+}
+
+
+esp_err_t led_gamma_set(uint8_t curve, uint8_t brightness) {
+    if (curve >= LED_GAMMA_CURVE_COUNT) return ESP_ERR_INVALID_ARG;
+    if (curve == lut_curve && brightness == lut_brightness) return ESP_OK;
+
+    lut_has_fraction = false;
+    for (int i = 0; i < 256; ++i) {
+        output_lut[i] = (uint32_t)led_gamma_tables[curve][i] * (brightness + 1) >> 8;
+        if (output_lut[i] & 0xFF) lut_has_fraction = true;
+    }
+    if (curve != lut_curve) ESP_LOGI(GAMMA_TAG, "Gamma curve %s", led_gamma_names[curve]);
+    lut_curve = curve;
+    lut_brightness = brightness;
+    return ESP_OK;
+}
+
+
+bool led_gamma_prepare(led_gamma_lut_t *lut, bool dither) {
+    if (lut_curve < 0) led_gamma_set(LED_GAMMA_DEFAULT, 255);
+
+    memcpy(lut->levels, output_lut, sizeof(lut->levels));
+    if (!dither || !lut_has_fraction) {
+        lut->dither_offset = 0;
+        lut->dither_stride = 0;
+        return false;
+    }
+
+    // Bit reversed frame counter: every run of 2^n frames samples the fraction at 2^n evenly spaced offsets.
+    // Levels max out at 0xFF00, so adding the offset never overflows.
+    lut->dither_offset = reverse_bits(dither_frame++);
+    lut->dither_stride = DITHER_PIXEL_STRIDE;
+    return true;
+}
@@ -0,0 +1,159 @@
+#include <string.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "led_jitter_buffer.h"
+#include "led_frame_buffer.h"
+#include "led_frame_scheduler.h"
+#include "led_render_parallel.h"
+
+
+#define RELEASE_TASK_PRIORITY           19      // Above lwIP (18) like the render workers, a presentation time is a deadline
+
+// Released frames switch the render loop over to streamed frames
+extern void stream_frame_received(void);
+
+static struct {
+    bool used;
+    int64_t pts_us;
+    uint8_t pixels[LED_FRAME_BYTES];
+} slots[LED_JB_SLOTS];
+
+static led_jb_stats_t jb_stats;
+// Guards the slots and the release timer. Taken by producers and the release task, never by the render loop.
+static SemaphoreHandle_t jb_lock = NULL;
+static esp_timer_handle_t release_timer = NULL;
+static TaskHandle_t release_task = NULL;
+
+
+/* Arms the release timer for the earliest queued frame. Called with jb_lock held. */
+static void arm_release_timer(int64_t now) {
+    int next = -1;
+    for (int i = 0; i < LED_JB_SLOTS; ++i) {
+        if (slots[i].used && (next < 0 || slots[i].pts_us < slots[next].pts_us)) next = i;
+    }
+
+    esp_timer_stop(release_timer);      // Fails harmlessly if it isn't running
+    if (next < 0) return;
+    int64_t wait_us = slots[next].pts_us - now;
+    esp_timer_start_once(release_timer, wait_us > 0 ? wait_us : 0);
+}
+
+
+/* Runs in the esp_timer task, which all timers share. The blocking work is left to the release task. */
+static void release_tick(void *arg) {
+    xTaskNotifyGive(release_task);
+}
+
+
+static void release_due_frame(void) {
+    bool released = false;
+
+    xSemaphoreTake(jb_lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+
+    // Only the newest due frame is worth showing
+    int due = -1;
+    for (int i = 0; i < LED_JB_SLOTS; ++i) {
+        if (!slots[i].used || slots[i].pts_us > now) continue;
+        if (due >= 0 && slots[due].pts_us > slots[i].pts_us) {
+            slots[i].used = false;
+            ++jb_stats.superseded;
+            continue;
+        }
+        if (due >= 0) {
+            slots[due].used = false;
+            ++jb_stats.superseded;
+        }
+        due = i;
+    }
+
+    if (due >= 0) {
+        uint8_t *back = led_fb_begin_write();
+        memcpy(back, slots[due].pixels, LED_FRAME_BYTES);
+        led_fb_end_write(true);
+        slots[due].used = false;
+
+        int32_t error_us = now - slots[due].pts_us;
+        if (error_us > jb_stats.max_release_error_us) jb_stats.max_release_error_us = error_us;
+        ++jb_stats.presented;
+        released = true;
+    }
+    arm_release_timer(now);
+    xSemaphoreGive(jb_lock);
+
+    if (released) {
+        stream_frame_received();
+        led_sched_render_now();     // Presentation times are finer than the frame clock
+    }
+}
+
+
+static void release_frames(void *arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        release_due_frame();
+    }
+}
+
+
+esp_err_t led_jb_init(void) {
+    if (jb_lock) return ESP_OK;
+
+    jb_lock = xSemaphoreCreateMutex();
+    if (!jb_lock) return ESP_ERR_NO_MEM;
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = release_tick,
+        .name = "jb_release",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &release_timer);
+    if (ret != ESP_OK) return ret;
+
+    if (xTaskCreatePinnedToCore(release_frames, "Jitter buffer release", 2048, NULL, RELEASE_TASK_PRIORITY,
+                                &release_task, LED_NET_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+
+esp_err_t led_jb_push(const uint8_t *frame, int64_t pts_us) {
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(jb_lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    int slot = -1;
+    for (int i = 0; i < LED_JB_SLOTS && slot < 0; ++i) {
+        if (!slots[i].used) slot = i;
+    }
+
+    if (pts_us - now > LED_JB_MAX_LEAD_US) {
+        ++jb_stats.rejected;
+        ret = ESP_ERR_INVALID_ARG;
+    } else if (slot < 0) {
+        ++jb_stats.overflow;
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        if (pts_us < now) ++jb_stats.late;
+        memcpy(slots[slot].pixels, frame, LED_FRAME_BYTES);
+        slots[slot].pts_us = pts_us;
+        slots[slot].used = true;
+        ++jb_stats.scheduled;
+        arm_release_timer(now);
+    }
+    xSemaphoreGive(jb_lock);
+    return ret;
+}
+
+
+led_jb_stats_t led_jb_get_stats(void) {
+    xSemaphoreTake(jb_lock, portMAX_DELAY);
+    led_jb_stats_t stats = jb_stats;
+    xSemaphoreGive(jb_lock);
+    return stats;
+}
@@ -0,0 +1,61 @@
+#include "led_math.h"
+
+
+#define QUARTER_STEPS           64
+
+
+// sin(i / 64 * 90 degrees) * 32767, one extra entry so interpolation never reads past the end
+static const int16_t quarter_sine[QUARTER_STEPS + 1] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767,
+};
+
+
+int16_t led_sin16(uint16_t angle) {
+    uint16_t offset = angle & 0x3FFF;
+    if (angle & 0x4000) offset = 0x4000 - offset;      // Falling quarters mirror the rising ones
+
+    uint16_t step = offset >> 8;
+    int32_t value = quarter_sine[step];
+    if (step < QUARTER_STEPS) value += ((quarter_sine[step + 1] - value) * (offset & 0xFF)) >> 8;
+    return angle & 0x8000 ? -value : value;
+}
+
+
+/* Pseudo random value of a lattice point. The lattice repeats every 256 cells, so coordinates that wrap
+ * around 16 bits continue without a seam. */
+static uint8_t lattice(uint32_t x, uint32_t y) {
+    uint32_t h = (x & 0xFF) * 0x8DA6B343u ^ (y & 0xFF) * 0xD8163841u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h >> 24;
+}
+
+/* 3t^2 - 2t^3, so the noise has no kinks at the lattice points */
+static uint8_t smooth(uint8_t t) {
+    return ((uint32_t)t * t * (3 * 256 - 2 * t)) >> 16;
+}
+
+
+uint8_t led_noise8(uint16_t x) {
+    uint32_t cell = x >> 8;
+    return led_lerp8(lattice(cell, 0), lattice(cell + 1, 0), smooth(x & 0xFF));
+}
+
+
+uint8_t led_noise8_2d(uint16_t x, uint16_t y) {
+    uint32_t cell_x = x >> 8;
+    uint32_t cell_y = y >> 8;
+    uint8_t fx = smooth(x & 0xFF);
+    uint8_t top = led_lerp8(lattice(cell_x, cell_y), lattice(cell_x + 1, cell_y), fx);
+    uint8_t bottom = led_lerp8(lattice(cell_x, cell_y + 1), lattice(cell_x + 1, cell_y + 1), fx);
+    return led_lerp8(top, bottom, smooth(y & 0xFF));
+}
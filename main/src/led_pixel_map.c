@@ -0,0 +1,121 @@
+#include "esp_log.h"
+
+#include "led_pixel_map.h"
+#include "led_frame_buffer.h"
+#include "led_pixel_map_custom.h"     // Generated
+
+
+#define MAP_TAG                 "PIXEL_MAP"
+
+
+static uint16_t physical_to_logical[LED_COUNT];
+static bool mapped = false;
+static uint16_t map_width = LED_COUNT;
+static uint16_t map_height = 1;
+
+
+/* Position of wired LED (column, row) on the logical grid, after `rotation` quarter turns clockwise */
+static void rotate(const led_map_config_t *config, uint16_t column, uint16_t row, uint16_t *x, uint16_t *y) {
+    switch (config->rotation) {
+        case 0:  *x = column;                      *y = row;                       break;
+        case 1:  *x = config->height - 1 - row;    *y = column;                    break;
+        case 2:  *x = config->width - 1 - column;  *y = config->height - 1 - row;  break;
+        default: *x = row;                         *y = config->width - 1 - column; break;
+    }
+}
+
+
+static esp_err_t build_matrix(const led_map_config_t *config) {
+    if (config->width == 0 || config->height == 0 || config->rotation > 3) return ESP_ERR_INVALID_ARG;
+    if ((size_t)config->width * config->height > LED_COUNT) return ESP_ERR_INVALID_SIZE;
+
+    bool quarter_turn = config->rotation & 1;
+    map_width = quarter_turn ? config->height : config->width;
+    map_height = quarter_turn ? config->width : config->height;
+
+    for (size_t led = 0; led < LED_COUNT; ++led) {
+        uint16_t row = led / config->width;
+        uint16_t column = led % config->width;
+        if (row >= config->height) {
+            // Past the matrix; beyond the grid in the logical frame as well
+            physical_to_logical[led] = led;
+            continue;
+        }
+        if (config->serpentine && (row & 1)) column = config->width - 1 - column;
+
+        uint16_t x, y;
+        rotate(config, column, row, &x, &y);
+        physical_to_logical[led] = y * map_width + x;
+    }
+    return ESP_OK;
+}
+
+
+static esp_err_t build_custom(void) {
+#if LED_PIXEL_MAP_CUSTOM_COUNT != LED_COUNT
+    // No pixel_map.csv, or one that doesn't give every LED a position
+    return ESP_ERR_INVALID_SIZE;
+#else
+
+    uint16_t width = 0, height = 0;
+    for (size_t led = 0; led < LED_PIXEL_MAP_CUSTOM_COUNT; ++led) {
+        if (led_pixel_map_custom[led][0] >= width) width = led_pixel_map_custom[led][0] + 1;
+        if (led_pixel_map_custom[led][1] >= height) height = led_pixel_map_custom[led][1] + 1;
+    }
+    if ((size_t)width * height > LED_COUNT) return ESP_ERR_INVALID_SIZE;
+
+    map_width = width;
+    map_height = height;
+    for (size_t led = 0; led < LED_COUNT; ++led) {
+        physical_to_logical[led] = led_pixel_map_custom[led][1] * width + led_pixel_map_custom[led][0];
+    }
+    return ESP_OK;
+#endif
+}
+
+
+esp_err_t led_map_init(const led_map_config_t *config) {
+    esp_err_t ret;
+
+    switch (config->layout) {
+        case LED_MAP_LINEAR:
+            map_width = LED_COUNT;
+            map_height = 1;
+            mapped = false;
+            return ESP_OK;
+        case LED_MAP_MATRIX:
+            ret = build_matrix(config);
+            break;
+        case LED_MAP_CUSTOM:
+            ret = build_custom();
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+    if (ret != ESP_OK) return ret;
+
+    mapped = true;
+    ESP_LOGI(MAP_TAG, "Logical grid %ux%u", map_width, map_height);
+    return ESP_OK;
+}
+
+
+const uint16_t *led_map_table(void) {
+    return mapped ? physical_to_logical : NULL;
+}
+
+
+uint16_t led_map_width(void) {
+    return map_width;
+}
+
+
+uint16_t led_map_height(void) {
+    return map_height;
+}
+
+
+uint16_t led_map_index(int x, int y) {
+    if (x < 0 || y < 0 || x >= map_width || y >= map_height) return LED_MAP_NONE;
+    return y * map_width + x;
+}
@@ -0,0 +1,104 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#include "led_render_parallel.h"
+
+
+static TaskHandle_t worker_task = NULL;
+static SemaphoreHandle_t job_ready = NULL;
+static SemaphoreHandle_t job_done = NULL;
+
+static struct {
+    led_span_render_fn fn;
+    uint8_t *frame;
+    size_t count;
+    void *ctx;
+} job;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static led_render_stats_t render_stats;
+// Only touched by led_render_get_stats, which is meant for a single monitoring caller
+static uint32_t last_idle[LED_CORE_COUNT];
+static uint32_t last_sample = 0;
+
+
+static void render_span(led_span_render_fn fn, uint8_t *frame, size_t first, size_t count, void *ctx) {
+    int64_t start = esp_timer_get_time();
+    fn(frame, first, count, ctx);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    portENTER_CRITICAL(&stats_lock);
+    render_stats.span_us[xPortGetCoreID()] += elapsed;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+
+static void render_worker(void *arg) {
+    while (1) {
+        xSemaphoreTake(job_ready, portMAX_DELAY);
+        render_span(job.fn, job.frame, 0, job.count, job.ctx);
+        xSemaphoreGive(job_done);
+    }
+}
+
+
+esp_err_t led_render_parallel_init(void) {
+    if (worker_task) return ESP_OK;
+
+    job_ready = xSemaphoreCreateBinary();
+    job_done = xSemaphoreCreateBinary();
+    if (!job_ready || !job_done) return ESP_ERR_NO_MEM;
+
+    if (xTaskCreatePinnedToCore(render_worker, "Render worker", 2048, NULL, LED_RENDER_WORKER_PRIORITY,
+                                &worker_task, LED_NET_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+
+void led_render_split(led_span_render_fn fn, uint8_t *frame, size_t count, void *ctx) {
+    if (!worker_task || count < 2) {
+        render_span(fn, frame, 0, count, ctx);
+        return;
+    }
+
+    size_t half = count / 2;
+    job.fn = fn;
+    job.frame = frame;
+    job.count = half;
+    job.ctx = ctx;
+    xSemaphoreGive(job_ready);
+
+    render_span(fn, frame, half, count - half, ctx);
+
+    // Barrier: the frame isn't complete before the worker's half is
+    xSemaphoreTake(job_done, portMAX_DELAY);
+    portENTER_CRITICAL(&stats_lock);
+    ++render_stats.split_frames;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+
+led_render_stats_t led_render_get_stats(void) {
+    // Idle task run time is counted in esp_timer microseconds (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+    uint32_t now = esp_timer_get_time();
+    uint32_t elapsed = now - last_sample;
+    last_sample = now;
+
+    uint8_t load_percent[LED_CORE_COUNT] = {0};
+    for (int core = 0; core < LED_CORE_COUNT; ++core) {
+        uint32_t idle = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+        uint32_t idle_elapsed = idle - last_idle[core];
+        last_idle[core] = idle;
+        if (elapsed && idle_elapsed <= elapsed) load_percent[core] = 100 - (uint64_t)idle_elapsed * 100 / elapsed;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    for (int core = 0; core < LED_CORE_COUNT; ++core) render_stats.load_percent[core] = load_percent[core];
+    led_render_stats_t stats = render_stats;
+    portEXIT_CRITICAL(&stats_lock);
+    return stats;
+}
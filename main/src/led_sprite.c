@@ -0,0 +1,101 @@
+#include <string.h>
+
+#include "led_sprite.h"
+#include "led_pixel_format.h"
+#include "led_pixel_map.h"
+#include "led_math.h"
+#include "led_glyph_atlas.h"      // Generated
+
+
+static void blend(uint8_t *pixel, led_rgb_t color, uint8_t alpha) {
+    if (alpha == 255) {
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+        return;
+    }
+    pixel[0] = led_lerp8(pixel[0], color.r, alpha);
+    pixel[1] = led_lerp8(pixel[1], color.g, alpha);
+    pixel[2] = led_lerp8(pixel[2], color.b, alpha);
+}
+
+
+bool led_sprite_find(const char *name, size_t len, led_sprite_t *sprite) {
+    for (int i = 0; i < LED_ATLAS_SPRITE_COUNT; ++i) {
+        if (len == strlen(led_atlas_sprites[i].name) && !memcmp(name, led_atlas_sprites[i].name, len)) {
+            sprite->columns = led_atlas_columns + led_atlas_sprites[i].offset;
+            sprite->width = led_atlas_sprites[i].width;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+led_sprite_t led_sprite_glyph(char c) {
+    unsigned code = (unsigned char)c - LED_ATLAS_GLYPH_FIRST;
+    if (code >= LED_ATLAS_GLYPH_COUNT) code = '?' - LED_ATLAS_GLYPH_FIRST;
+    return (led_sprite_t){
+        .columns = led_atlas_columns + led_atlas_glyph_offsets[code],
+        .width = led_atlas_glyph_widths[code],
+    };
+}
+
+
+void led_blit(uint8_t *frame, const led_sprite_t *sprite, int x, int y, led_rgb_t color, uint8_t alpha) {
+    int width = led_map_width();
+    int height = led_map_height();
+    if (alpha == 0 || x >= width || y >= height || x + sprite->width <= 0 || y + LED_SPRITE_HEIGHT <= 0) return;
+
+    // Clip once: columns by range, rows by masking them out of every column
+    int first = x < 0 ? -x : 0;
+    int last = x + sprite->width > width ? width - x : sprite->width;
+    uint8_t rows = 0xFF;
+    if (y < 0) rows &= 0xFF << -y;
+    if (y + LED_SPRITE_HEIGHT > height) rows &= 0xFF >> (y + LED_SPRITE_HEIGHT - height);
+
+    for (int c = first; c < last; ++c) {
+        uint32_t bits = sprite->columns[c] & rows;
+        while (bits) {
+            int row = __builtin_ctz(bits);
+            bits &= bits - 1;
+            blend(frame + ((size_t)(y + row) * width + x + c) * LED_PIXEL_BYTES, color, alpha);
+        }
+    }
+}
+
+
+/* Sprite of the glyph or {icon} at *text, advancing past it */
+static led_sprite_t next_sprite(const char **text) {
+    const char *start = *text;
+    if (*start == '{') {
+        const char *end = strchr(start + 1, '}');
+        led_sprite_t icon;
+        if (end && led_sprite_find(start + 1, end - start - 1, &icon)) {
+            *text = end + 1;
+            return icon;
+        }
+    }
+    *text = start + 1;
+    return led_sprite_glyph(*start);
+}
+
+
+int led_text_width(const char *text) {
+    int width = 0;
+    while (*text) {
+        width += next_sprite(&text).width + LED_TEXT_SPACING;
+    }
+    return width ? width - LED_TEXT_SPACING : 0;
+}
+
+
+int led_blit_text(uint8_t *frame, const char *text, int x, int y, led_rgb_t color, uint8_t alpha) {
+    int width = led_map_width();
+    while (*text && x < width) {
+        led_sprite_t sprite = next_sprite(&text);
+        if (x + sprite.width > 0) led_blit(frame, &sprite, x, y, color, alpha);
+        x += sprite.width + LED_TEXT_SPACING;
+    }
+    return x;
+}
@@ -4,60 +4,79 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include "esp_check.h"
 #include "led_strip_encoder.h"
 
+#define SYMBOLS_PER_BYTE 8
+#define MIN_CHUNK_SYMBOLS (4 * SYMBOLS_PER_BYTE) // the interrupt refills at least this many symbols at once
+
 static const char *TAG = "led_encoder";
 
+_Static_assert(sizeof(led_rgb_t) == 3, "palette entries are read as RGB bytes");
+
 typedef struct {
     rmt_encoder_t base;
-    rmt_encoder_t *bytes_encoder;
-    rmt_encoder_t *copy_encoder;
-    int state;
+    rmt_encoder_t *pixel_encoder;
     rmt_symbol_word_t reset_code;
 } rmt_led_strip_encoder_t;
 
-static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+// Shared by every encoder (one per RMT segment), built by the first one for its resolution
+static rmt_symbol_word_t byte_symbols[256][SYMBOLS_PER_BYTE]; // WS2812 transfer bit order: MSB first
+static uint32_t byte_symbols_resolution = 0;
+
+/*
+ * Simple encoder callback, runs in the RMT interrupt. `symbols_written` is the position in the transaction,
+ * so the pixel data is resumed at byte symbols_written / 8 and followed by a single reset symbol.
+ */
+static size_t encode_pixels(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free,
+                            rmt_symbol_word_t *symbols, bool *done, void *arg)
 {
-    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
-    rmt_encoder_handle_t copy_encoder = led_encoder->copy_encoder;
-    rmt_encode_state_t session_state = RMT_ENCODING_RESET;
-    rmt_encode_state_t state = RMT_ENCODING_RESET;
-    size_t encoded_symbols = 0;
-    switch (led_encoder->state) {
-    case 0: // send RGB data
-        encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
-        if (session_state & RMT_ENCODING_COMPLETE) {
-            led_encoder->state = 1; // switch to next state when current encoding session finished
-        }
-        if (session_state & RMT_ENCODING_MEM_FULL) {
-            state |= RMT_ENCODING_MEM_FULL;
-            goto out; // yield if there's no free space for encoding artifacts
-        }
-    // fall-through
-    case 1: // send reset code
-        encoded_symbols += copy_encoder->encode(copy_encoder, channel, &led_encoder->reset_code,
-                                                sizeof(led_encoder->reset_code), &session_state);
-        if (session_state & RMT_ENCODING_COMPLETE) {
-            led_encoder->state = RMT_ENCODING_RESET; // back to the initial encoding session
-            state |= RMT_ENCODING_COMPLETE;
+    rmt_led_strip_encoder_t *led_encoder = arg;
+    const led_strip_frame_t *frame = data;
+    size_t total_bytes = frame->pixel_count * LED_WIRE_BYTES;
+    size_t byte = symbols_written / SYMBOLS_PER_BYTE;
+
+    if (byte >= total_bytes) {
+        if (symbols_free < 1) {
+            return 0;
         }
-        if (session_state & RMT_ENCODING_MEM_FULL) {
-            state |= RMT_ENCODING_MEM_FULL;
-            goto out; // yield if there's no free space for encoding artifacts
+        symbols[0] = led_encoder->reset_code;
+        *done = true;
+        return 1;
+    }
+
+    size_t pixel = byte / LED_WIRE_BYTES;
+    int wire_byte = byte % LED_WIRE_BYTES;
+    uint8_t offset = frame->dither_offset + pixel * frame->dither_stride;
+    uint8_t wire[LED_WIRE_BYTES];
+    led_wire_pixel(led_strip_frame_pixel(frame, pixel), frame->levels, offset, wire);
+    size_t written = 0;
+    while (byte < total_bytes && symbols_free - written >= SYMBOLS_PER_BYTE) {
+        memcpy(symbols + written, byte_symbols[wire[wire_byte]], sizeof(byte_symbols[0]));
+        written += SYMBOLS_PER_BYTE;
+        ++byte;
+        if (++wire_byte == LED_WIRE_BYTES && byte < total_bytes) {
+            wire_byte = 0;
+            offset += frame->dither_stride;
+            led_wire_pixel(led_strip_frame_pixel(frame, ++pixel), frame->levels, offset, wire);
         }
     }
-out:
-    *ret_state = state;
-    return encoded_symbols;
+    return written;
+}
+
+static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_handle_t pixel_encoder = led_encoder->pixel_encoder;
+    return pixel_encoder->encode(pixel_encoder, channel, primary_data, data_size, ret_state);
 }
 
 static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
 {
     rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_del_encoder(led_encoder->bytes_encoder);
-    rmt_del_encoder(led_encoder->copy_encoder);
+    rmt_del_encoder(led_encoder->pixel_encoder);
     free(led_encoder);
     return ESP_OK;
 }
@@ -65,10 +84,7 @@ static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
 static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
 {
     rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
-    rmt_encoder_reset(led_encoder->bytes_encoder);
-    rmt_encoder_reset(led_encoder->copy_encoder);
-    led_encoder->state = RMT_ENCODING_RESET;
-    return ESP_OK;
+    return rmt_encoder_reset(led_encoder->pixel_encoder);
 }
 
 esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
@@ -76,48 +92,55 @@ esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rm
     esp_err_t ret = ESP_OK;
     rmt_led_strip_encoder_t *led_encoder = NULL;
     ESP_GOTO_ON_FALSE(config && ret_encoder, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(!byte_symbols_resolution || config->resolution == byte_symbols_resolution, ESP_ERR_INVALID_ARG,
+                      err, TAG, "all led strip encoders must share one resolution");
     led_encoder = rmt_alloc_encoder_mem(sizeof(rmt_led_strip_encoder_t));
     ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for led strip encoder");
     led_encoder->base.encode = rmt_encode_led_strip;
     led_encoder->base.del = rmt_del_led_strip_encoder;
     led_encoder->base.reset = rmt_led_strip_encoder_reset;
-    // different led strip might have its own timing requirements, following parameter is for WS2812
-    rmt_bytes_encoder_config_t bytes_encoder_config = {
-        .bit0 = {
-            .level0 = 1,
-            .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
-            .level1 = 0,
-            .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
-        },
-        .bit1 = {
-            .level0 = 1,
-            .duration0 = 0.9 * config->resolution / 1000000, // T1H=0.9us
-            .level1 = 0,
-            .duration1 = 0.3 * config->resolution / 1000000, // T1L=0.3us
-        },
-        .flags.msb_first = 1 // WS2812 transfer bit order: G7...G0R7...R0B7...B0
+
+    // bit timing of the LED_CHIP the firmware is built for
+    rmt_symbol_word_t bit0 = {
+        .level0 = 1,
+        .duration0 = (uint64_t)LED_T0H_NS * config->resolution / 1000000000,
+        .level1 = 0,
+        .duration1 = (uint64_t)LED_T0L_NS * config->resolution / 1000000000,
+    };
+    rmt_symbol_word_t bit1 = {
+        .level0 = 1,
+        .duration0 = (uint64_t)LED_T1H_NS * config->resolution / 1000000000,
+        .level1 = 0,
+        .duration1 = (uint64_t)LED_T1L_NS * config->resolution / 1000000000,
     };
-    ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
-    rmt_copy_encoder_config_t copy_encoder_config = {};
-    ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
+    if (!byte_symbols_resolution) {
+        for (int value = 0; value < 256; value++) {
+            for (int bit = 0; bit < SYMBOLS_PER_BYTE; bit++) {
+                byte_symbols[value][bit] = (value & (0x80 >> bit)) ? bit1 : bit0;
+            }
+        }
+        byte_symbols_resolution = config->resolution;
+    }
 
-    uint32_t reset_ticks = config->resolution / 1000000 * 50 / 2; // reset code duration defaults to 50us
+    uint32_t reset_ticks = config->resolution / 1000000 * LED_RESET_US / 2;
     led_encoder->reset_code = (rmt_symbol_word_t) {
         .level0 = 0,
         .duration0 = reset_ticks,
         .level1 = 0,
         .duration1 = reset_ticks,
     };
+
+    rmt_simple_encoder_config_t simple_encoder_config = {
+        .callback = encode_pixels,
+        .arg = led_encoder,
+        .min_chunk_size = MIN_CHUNK_SYMBOLS,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_simple_encoder(&simple_encoder_config, &led_encoder->pixel_encoder), err, TAG, "create simple encoder failed");
+
     *ret_encoder = &led_encoder->base;
     return ESP_OK;
 err:
     if (led_encoder) {
-        if (led_encoder->bytes_encoder) {
-            rmt_del_encoder(led_encoder->bytes_encoder);
-        }
-        if (led_encoder->copy_encoder) {
-            rmt_del_encoder(led_encoder->copy_encoder);
-        }
         free(led_encoder);
     }
     return ret;
@@ -0,0 +1,373 @@
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "driver/rmt_tx.h"
+#include "driver/spi_master.h"
+#include "esp_lcd_panel_io.h"
+#include "soc/soc_caps.h"
+
+#include "led_strip_output.h"
+#include "led_strip_encoder.h"
+#include "led_strip_spi_encoder.h"
+#include "led_strip_parallel_encoder.h"
+#include "led_frame_buffer.h"
+
+
+#define OUTPUT_TAG              "LED_OUTPUT"
+
+
+typedef struct {
+    size_t first;                   // First pixel of the segment
+    size_t count;
+
+    // RMT backend
+    rmt_channel_handle_t chan;
+    rmt_encoder_handle_t encoder;
+    // Buffer indices handed to this channel (the parallel bus for the first segment), in transmission order.
+    // Every done event belongs to exactly one successful transmit, so the interrupt simply consumes the next
+    // entry.
+    uint8_t queued_buffers[LED_OUTPUT_BUFFERS];
+    volatile uint8_t queued_head;   // Interrupt side
+    uint8_t queued_tail;            // Render task side
+
+    // SPI backend, the transaction carries its buffer index
+    spi_device_handle_t spi_device;
+    uint8_t *spi_buffers[LED_OUTPUT_BUFFERS];
+    spi_transaction_t spi_transactions[LED_OUTPUT_BUFFERS];
+} output_segment_t;
+
+static const spi_host_device_t spi_hosts[] = { SPI2_HOST, SPI3_HOST };
+
+
+static led_output_frame_t output_frames[LED_OUTPUT_BUFFERS];
+// rmt_transmit payloads, read by the encoders until their transactions are done
+static led_strip_frame_t wire_frames[LED_OUTPUT_BUFFERS][LED_OUTPUT_MAX_SEGMENTS];
+
+static output_segment_t segments[LED_OUTPUT_MAX_SEGMENTS];
+static size_t segment_count = 0;
+static led_output_backend_t backend;
+static led_strip_spi_encoder_t spi_encoder;
+static led_strip_parallel_encoder_t parallel_encoder;
+static esp_lcd_i80_bus_handle_t parallel_bus = NULL;
+static esp_lcd_panel_io_handle_t parallel_io = NULL;
+static uint8_t *parallel_buffers[LED_OUTPUT_BUFFERS];
+static size_t parallel_lane_pixels = 0;     // Longest segment
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+static rmt_sync_manager_handle_t sync_manager = NULL;
+#endif
+// Buffer indices free for rendering
+static QueueHandle_t free_buffers = NULL;
+// Segments of each buffer still on the wire (plus one while led_output_submit is queueing them)
+static uint8_t pending_segments[LED_OUTPUT_BUFFERS];
+static portMUX_TYPE pending_lock = portMUX_INITIALIZER_UNLOCKED;
+static led_output_stats_t output_stats;
+
+
+/* Hands the buffer back once `done` more of its segments have gone out and none are left */
+static IRAM_ATTR bool release_segments(uint8_t index, uint8_t done, BaseType_t *high_task_wakeup) {
+    portENTER_CRITICAL_SAFE(&pending_lock);
+    pending_segments[index] -= done;
+    bool released = pending_segments[index] == 0;
+    portEXIT_CRITICAL_SAFE(&pending_lock);
+
+    if (!released) return false;
+    if (high_task_wakeup) return xQueueSendFromISR(free_buffers, &index, high_task_wakeup) == pdTRUE;
+    return xQueueSend(free_buffers, &index, 0) == pdTRUE;
+}
+
+
+/* Transactions on a channel complete in submission order, so its oldest queued buffer is the one that just
+ * went out */
+static bool segment_done(output_segment_t *segment) {
+    BaseType_t high_task_wakeup = pdFALSE;
+    uint8_t index = segment->queued_buffers[segment->queued_head];
+
+    segment->queued_head = (segment->queued_head + 1) % LED_OUTPUT_BUFFERS;
+    release_segments(index, 1, &high_task_wakeup);
+    return high_task_wakeup == pdTRUE;
+}
+
+static bool transmit_done(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata, void *user_ctx) {
+    return segment_done(user_ctx);
+}
+
+static bool parallel_transmit_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx) {
+    return segment_done(user_ctx);
+}
+
+
+/* SPI post transaction callback, in the SPI interrupt */
+static IRAM_ATTR void spi_transmit_done(spi_transaction_t *transaction) {
+    BaseType_t high_task_wakeup = pdFALSE;
+    release_segments((uintptr_t)transaction->user, 1, &high_task_wakeup);
+    portYIELD_FROM_ISR(high_task_wakeup);
+}
+
+
+static esp_err_t init_rmt_segment(output_segment_t *segment, gpio_num_t gpio_num, const led_output_config_t *config) {
+    rmt_tx_channel_config_t tx_chan_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT, // select source clock
+        .gpio_num = gpio_num,
+        .mem_block_symbols = 64, // increase the block size can make the LED less flickering
+        .resolution_hz = config->resolution_hz,
+        .trans_queue_depth = LED_OUTPUT_BUFFERS, // every buffer can be queued at once, rmt_transmit never blocks
+    };
+    esp_err_t ret = rmt_new_tx_channel(&tx_chan_config, &segment->chan);
+    if (ret != ESP_OK) return ret;
+
+    // Each channel encodes its own transaction, so each needs its own encoder state
+    led_strip_encoder_config_t encoder_config = {
+        .resolution = config->resolution_hz,
+    };
+    ret = rmt_new_led_strip_encoder(&encoder_config, &segment->encoder);
+    if (ret != ESP_OK) return ret;
+
+    rmt_tx_event_callbacks_t callbacks = {
+        .on_trans_done = transmit_done,
+    };
+    ret = rmt_tx_register_event_callbacks(segment->chan, &callbacks, segment);
+    if (ret != ESP_OK) return ret;
+
+    return rmt_enable(segment->chan);
+}
+
+
+static esp_err_t init_spi_segment(output_segment_t *segment, spi_host_device_t host, gpio_num_t gpio_num) {
+    size_t bytes = LED_STRIP_SPI_BYTES(segment->count);
+    spi_bus_config_t bus_config = {
+        .mosi_io_num = gpio_num,
+        .miso_io_num = -1,
+        .sclk_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = bytes,
+    };
+    esp_err_t ret = spi_bus_initialize(host, &bus_config, SPI_DMA_CH_AUTO);
+    if (ret != ESP_OK) return ret;
+
+    spi_device_interface_config_t device_config = {
+        .clock_speed_hz = LED_STRIP_SPI_CLOCK_HZ,
+        .mode = 0,
+        .spics_io_num = -1,
+        .queue_size = LED_OUTPUT_BUFFERS,
+        .post_cb = spi_transmit_done,
+    };
+    ret = spi_bus_add_device(host, &device_config, &segment->spi_device);
+    if (ret != ESP_OK) return ret;
+
+    for (uintptr_t i = 0; i < LED_OUTPUT_BUFFERS; ++i) {
+        segment->spi_buffers[i] = heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+        if (!segment->spi_buffers[i]) return ESP_ERR_NO_MEM;
+        segment->spi_transactions[i] = (spi_transaction_t){
+            .length = bytes * 8,
+            .tx_buffer = segment->spi_buffers[i],
+            .user = (void *)i,
+        };
+    }
+    return ESP_OK;
+}
+
+
+/* All segments share one I2S bus (LCD mode), one data line each; the first segment's queue tracks the frames */
+static esp_err_t init_parallel(const led_output_config_t *config) {
+    esp_err_t ret = led_strip_parallel_encoder_init(&parallel_encoder, config->segment_count);
+    if (ret != ESP_OK) return ret;
+
+    parallel_lane_pixels = led_output_segment_pixels(config->segment_count);
+    size_t bytes = LED_PARALLEL_BYTES(config->segment_count, parallel_lane_pixels);
+    esp_lcd_i80_bus_config_t bus_config = {
+        .dc_gpio_num = config->parallel_dc_gpio,
+        .wr_gpio_num = config->parallel_clock_gpio,
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .bus_width = LED_PARALLEL_BUS_WIDTH(config->segment_count),
+        .max_transfer_bytes = bytes,
+    };
+    for (size_t lane = 0; lane < LED_PARALLEL_MAX_LANES; ++lane) {
+        bus_config.data_gpio_nums[lane] = lane < config->segment_count ? config->gpio_nums[lane] : -1;
+    }
+    ret = esp_lcd_new_i80_bus(&bus_config, &parallel_bus);
+    if (ret != ESP_OK) return ret;
+
+    esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = -1,
+        .pclk_hz = LED_PARALLEL_PCLK_HZ,
+        .trans_queue_depth = LED_OUTPUT_BUFFERS,
+        .on_color_trans_done = parallel_transmit_done,
+        .user_ctx = &segments[0],
+        .lcd_cmd_bits = 8,          // Unused, frames are sent without a command phase
+        .lcd_param_bits = 8,
+    };
+    ret = esp_lcd_new_panel_io_i80(parallel_bus, &io_config, &parallel_io);
+    if (ret != ESP_OK) return ret;
+
+    for (size_t i = 0; i < LED_OUTPUT_BUFFERS; ++i) {
+        parallel_buffers[i] = heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+        if (!parallel_buffers[i]) return ESP_ERR_NO_MEM;
+        led_strip_parallel_prepare(&parallel_encoder, parallel_buffers[i], parallel_lane_pixels);
+    }
+    return ESP_OK;
+}
+
+
+static esp_err_t transmit_rmt_segment(output_segment_t *segment, uint8_t index, const led_strip_frame_t *wire_frame) {
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0, // no transfer loop
+    };
+
+    // Recorded before the transmission starts so the done interrupt always finds it. A failed transmit leaves
+    // the tail where it was and the entry is simply overwritten by the next submit.
+    segment->queued_buffers[segment->queued_tail] = index;
+    esp_err_t ret = rmt_transmit(segment->chan, segment->encoder, wire_frame, sizeof(*wire_frame), &tx_config);
+    if (ret != ESP_OK) return ret;
+    segment->queued_tail = (segment->queued_tail + 1) % LED_OUTPUT_BUFFERS;
+    return ESP_OK;
+}
+
+
+static esp_err_t transmit_spi_segment(output_segment_t *segment, uint8_t index, const led_strip_frame_t *wire_frame) {
+    spi_transaction_t *done;
+
+    // Results have to be collected for the transactions to be queued again; the buffers themselves were
+    // already released by spi_transmit_done
+    while (spi_device_get_trans_result(segment->spi_device, &done, 0) == ESP_OK) {}
+
+    // Encoded here, the DMA then streams it without further CPU work
+    led_strip_spi_encode(&spi_encoder, wire_frame, segment->spi_buffers[index]);
+    return spi_device_queue_trans(segment->spi_device, &segment->spi_transactions[index], 0);
+}
+
+
+static esp_err_t transmit_parallel(uint8_t index) {
+    output_segment_t *segment = &segments[0];
+
+    led_strip_parallel_encode(&parallel_encoder, wire_frames[index], parallel_lane_pixels, parallel_buffers[index]);
+    segment->queued_buffers[segment->queued_tail] = index;
+    esp_err_t ret = esp_lcd_panel_io_tx_color(parallel_io, -1, parallel_buffers[index],
+                                              LED_PARALLEL_BYTES(segment_count, parallel_lane_pixels));
+    if (ret != ESP_OK) return ret;
+    segment->queued_tail = (segment->queued_tail + 1) % LED_OUTPUT_BUFFERS;
+    return ESP_OK;
+}
+
+
+esp_err_t led_output_init(const led_output_config_t *config) {
+    static const size_t max_segments[] = {
+        [LED_OUTPUT_BACKEND_RMT] = LED_OUTPUT_MAX_RMT_SEGMENTS,
+        [LED_OUTPUT_BACKEND_SPI] = LED_OUTPUT_MAX_SPI_SEGMENTS,
+        [LED_OUTPUT_BACKEND_PARALLEL] = LED_OUTPUT_MAX_SEGMENTS,
+    };
+    if (config->segment_count == 0 || config->segment_count > max_segments[config->backend]) return ESP_ERR_INVALID_ARG;
+    backend = config->backend;
+    if (backend == LED_OUTPUT_BACKEND_SPI) led_strip_spi_encoder_init(&spi_encoder);
+
+    free_buffers = xQueueCreate(LED_OUTPUT_BUFFERS, sizeof(uint8_t));
+    if (!free_buffers) return ESP_ERR_NO_MEM;
+    for (uint8_t i = 0; i < LED_OUTPUT_BUFFERS; ++i) {
+        xQueueSend(free_buffers, &i, 0);
+    }
+
+    static const char *const backend_names[] = { "RMT", "SPI", "parallel" };
+    ESP_LOGI(OUTPUT_TAG, "Create %u %s outputs", (unsigned)config->segment_count, backend_names[backend]);
+    rmt_channel_handle_t channels[LED_OUTPUT_MAX_SEGMENTS];
+    for (size_t s = 0; s < config->segment_count; ++s) {
+        output_segment_t *segment = &segments[s];
+        segment->first = led_output_segment_first(s, config->segment_count);
+        segment->count = led_output_segment_first(s + 1, config->segment_count) - segment->first;
+        esp_err_t ret = ESP_OK;
+        if (backend == LED_OUTPUT_BACKEND_RMT) ret = init_rmt_segment(segment, config->gpio_nums[s], config);
+        if (backend == LED_OUTPUT_BACKEND_SPI) ret = init_spi_segment(segment, spi_hosts[s], config->gpio_nums[s]);
+        if (ret != ESP_OK) return ret;
+        channels[s] = segment->chan;
+    }
+    segment_count = config->segment_count;
+    if (backend == LED_OUTPUT_BACKEND_PARALLEL) {
+        esp_err_t ret = init_parallel(config);
+        if (ret != ESP_OK) return ret;
+    }
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    // The channels then only start once every one of them has its transaction queued
+    if (backend == LED_OUTPUT_BACKEND_RMT && segment_count > 1) {
+        rmt_sync_manager_config_t sync_config = {
+            .tx_channel_array = channels,
+            .array_size = segment_count,
+        };
+        esp_err_t ret = rmt_new_sync_manager(&sync_config, &sync_manager);
+        if (ret != ESP_OK) return ret;
+    }
+#else
+    (void)channels;     // Started back to back instead, a few microseconds apart
+#endif
+
+    ESP_LOGI(OUTPUT_TAG, "Up to %u pixels per segment, %" PRIu32 " us on the wire per frame",
+             (unsigned)led_output_segment_pixels(segment_count), led_output_wire_time_us(config));
+    return ESP_OK;
+}
+
+
+led_output_frame_t *led_output_acquire(void) {
+    uint8_t index;
+
+    if (xQueueReceive(free_buffers, &index, 0) != pdTRUE) {
+        ++output_stats.render_stalls;
+        xQueueReceive(free_buffers, &index, portMAX_DELAY);
+    }
+    return &output_frames[index];
+}
+
+
+esp_err_t led_output_submit(led_output_frame_t *frame) {
+    uint8_t index = frame - output_frames;
+
+    // The parallel bus sends all segments in one transmission
+    size_t transmissions = backend == LED_OUTPUT_BACKEND_PARALLEL ? 1 : segment_count;
+    // The extra reference keeps a segment finishing early from releasing the buffer before all are queued
+    pending_segments[index] = transmissions + 1;
+
+    for (size_t s = 0; s < segment_count; ++s) {
+        const output_segment_t *segment = &segments[s];
+        // Mapped segments gather from the whole frame, the others start at their first pixel
+        size_t first = frame->map ? 0 : segment->first;
+        wire_frames[index][s] = (led_strip_frame_t){
+            .pixels = frame->indexed ? frame->indices + first : frame->pixels + first * LED_PIXEL_BYTES,
+            .palette = frame->indexed ? frame->palette : NULL,
+            .map = frame->map ? frame->map + segment->first : NULL,
+            .pixel_count = segment->count,
+            .levels = frame->lut.levels,
+            // Continues the dither pattern across segment boundaries
+            .dither_offset = frame->lut.dither_offset + segment->first * frame->lut.dither_stride,
+            .dither_stride = frame->lut.dither_stride,
+        };
+    }
+
+    esp_err_t ret = ESP_OK;
+    size_t started = 0;
+    for (; started < transmissions; ++started) {
+        output_segment_t *segment = &segments[started];
+        const led_strip_frame_t *wire_frame = &wire_frames[index][started];
+        if (backend == LED_OUTPUT_BACKEND_RMT) ret = transmit_rmt_segment(segment, index, wire_frame);
+        if (backend == LED_OUTPUT_BACKEND_SPI) ret = transmit_spi_segment(segment, index, wire_frame);
+        if (backend == LED_OUTPUT_BACKEND_PARALLEL) ret = transmit_parallel(index);
+        if (ret != ESP_OK) break;
+    }
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    // Segments that did get queued would otherwise wait for the missing ones forever
+    if (ret != ESP_OK && sync_manager) rmt_sync_reset(sync_manager);
+#endif
+    // Drops the submit reference and the segments that never started
+    release_segments(index, transmissions - started + 1, NULL);
+    if (ret != ESP_OK) return ret;
+
+    ++output_stats.frames;
+    return ESP_OK;
+}
+
+
+led_output_stats_t led_output_get_stats(void) {
+    return output_stats;
+}
@@ -0,0 +1,89 @@
+#include <string.h>
+
+#include "led_strip_parallel_encoder.h"
+
+
+void led_transpose8x8(const uint8_t in[8], uint8_t *out, size_t stride) {
+    // Hacker's Delight transpose8rS32: two 32 bit halves and three rounds of masked swaps, 2x2 then 4x4
+    // blocks of bits. Lane 7 is loaded first so that it lands in the most significant bit.
+    uint32_t x = (uint32_t)in[7] << 24 | (uint32_t)in[6] << 16 | (uint32_t)in[5] << 8 | in[4];
+    uint32_t y = (uint32_t)in[3] << 24 | (uint32_t)in[2] << 16 | (uint32_t)in[1] << 8 | in[0];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = x >> 24;
+    out[stride] = x >> 16;
+    out[2 * stride] = x >> 8;
+    out[3 * stride] = x;
+    out[4 * stride] = y >> 24;
+    out[5 * stride] = y >> 16;
+    out[6 * stride] = y >> 8;
+    out[7 * stride] = y;
+}
+
+
+esp_err_t led_strip_parallel_encoder_init(led_strip_parallel_encoder_t *encoder, size_t lane_count) {
+    if (lane_count == 0 || lane_count > LED_PARALLEL_MAX_LANES) return ESP_ERR_INVALID_ARG;
+
+    encoder->lane_count = lane_count;
+    encoder->word_bytes = LED_PARALLEL_BUS_WIDTH(lane_count) / 8;
+    return ESP_OK;
+}
+
+
+void led_strip_parallel_prepare(const led_strip_parallel_encoder_t *encoder, uint8_t *out, size_t pixels_per_lane) {
+    size_t bit_bytes = LED_PARALLEL_SLOTS_PER_BIT * encoder->word_bytes;
+    size_t bits = pixels_per_lane * LED_WIRE_BYTES * 8;
+
+    for (size_t bit = 0; bit < bits; ++bit) {
+        uint8_t *slots = out + bit * bit_bytes;
+        memset(slots, 0xFF, encoder->word_bytes);                           // high
+        memset(slots + encoder->word_bytes, 0, 2 * encoder->word_bytes);    // data, low
+    }
+    memset(out + bits * bit_bytes, 0, LED_PARALLEL_RESET_SLOTS * encoder->word_bytes);
+}
+
+
+void led_strip_parallel_encode(const led_strip_parallel_encoder_t *encoder, const led_strip_frame_t *lanes,
+                               size_t pixels_per_lane, uint8_t *out) {
+    size_t stride = LED_PARALLEL_SLOTS_PER_BIT * encoder->word_bytes;     // Between data words
+    uint8_t offsets[LED_PARALLEL_MAX_LANES];
+    uint8_t wire[LED_PARALLEL_MAX_LANES][LED_WIRE_BYTES] = {0};           // Unused lanes stay low
+    uint8_t lane_bytes[LED_PARALLEL_MAX_LANES] = {0};
+
+    for (size_t l = 0; l < encoder->lane_count; ++l) offsets[l] = lanes[l].dither_offset;
+
+    // First data word, past the high word of the first bit
+    uint8_t *dst = out + encoder->word_bytes;
+    for (size_t pixel = 0; pixel < pixels_per_lane; ++pixel) {
+        for (size_t l = 0; l < encoder->lane_count; ++l) {
+            const led_strip_frame_t *lane = &lanes[l];
+            if (pixel >= lane->pixel_count) {
+                memset(wire[l], 0, LED_WIRE_BYTES);
+                continue;
+            }
+            led_wire_pixel(led_strip_frame_pixel(lane, pixel), lane->levels, offsets[l], wire[l]);
+            offsets[l] += lane->dither_stride;
+        }
+        for (int i = 0; i < LED_WIRE_BYTES; ++i) {
+            for (size_t l = 0; l < encoder->lane_count; ++l) lane_bytes[l] = wire[l][i];
+            // Little endian words: lanes 0-7 in the low byte, 8-15 in the high byte
+            led_transpose8x8(lane_bytes, dst, stride);
+            if (encoder->word_bytes == 2) led_transpose8x8(lane_bytes + 8, dst + 1, stride);
+            dst += 8 * stride;
+        }
+    }
+}
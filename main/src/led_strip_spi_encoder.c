@@ -0,0 +1,41 @@
+#include <string.h>
+
+#include "led_strip_spi_encoder.h"
+
+
+#define SPI_HIGH_SLOTS(ns)      (((ns) * 2 + 312) / 625)            // Rounded to 312.5 ns SPI bits
+#define SPI_BIT0                ((0xF0 >> SPI_HIGH_SLOTS(LED_T0H_NS)) & 0xF)
+#define SPI_BIT1                ((0xF0 >> SPI_HIGH_SLOTS(LED_T1H_NS)) & 0xF)
+
+_Static_assert(SPI_HIGH_SLOTS(LED_T0H_NS) >= 1 && SPI_HIGH_SLOTS(LED_T1H_NS) <= 3 &&
+               SPI_HIGH_SLOTS(LED_T0H_NS) < SPI_HIGH_SLOTS(LED_T1H_NS), "LED_CHIP timing does not fit 4 SPI bits");
+
+
+void led_strip_spi_encoder_init(led_strip_spi_encoder_t *encoder) {
+    for (int value = 0; value < 256; ++value) {
+        // Two strip bits per SPI byte, most significant first
+        for (int i = 0; i < LED_STRIP_SPI_BITS_PER_BIT; ++i) {
+            uint8_t high = (value << (2 * i)) & 0x80 ? SPI_BIT1 : SPI_BIT0;
+            uint8_t low = (value << (2 * i)) & 0x40 ? SPI_BIT1 : SPI_BIT0;
+            encoder->bit_patterns[value][i] = high << 4 | low;
+        }
+    }
+}
+
+
+size_t led_strip_spi_encode(const led_strip_spi_encoder_t *encoder, const led_strip_frame_t *frame, uint8_t *out) {
+    uint8_t *dst = out;
+    uint8_t offset = frame->dither_offset;
+    uint8_t wire[LED_WIRE_BYTES];
+
+    for (size_t pixel = 0; pixel < frame->pixel_count; ++pixel) {
+        led_wire_pixel(led_strip_frame_pixel(frame, pixel), frame->levels, offset, wire);
+        for (int i = 0; i < LED_WIRE_BYTES; ++i) {
+            memcpy(dst, encoder->bit_patterns[wire[i]], LED_STRIP_SPI_BITS_PER_BIT);
+            dst += LED_STRIP_SPI_BITS_PER_BIT;
+        }
+        offset += frame->dither_stride;
+    }
+    memset(dst, 0, LED_STRIP_SPI_RESET_BYTES);
+    return dst + LED_STRIP_SPI_RESET_BYTES - out;
+}
@@ -0,0 +1,137 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#include "led_transition.h"
+#include "led_frame_buffer.h"
+
+
+#define NO_REQUEST              UINT32_MAX
+#define PALETTE_SIZE            256
+
+
+static portMUX_TYPE request_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t requested_ms = NO_REQUEST;
+static led_ease_t requested_ease;
+
+// Only touched by the render loop
+static uint8_t from[LED_FRAME_BYTES];
+static uint8_t shown[LED_FRAME_BYTES];             // Only the first LED_COUNT bytes if indexed
+static led_rgb_t shown_palette[PALETTE_SIZE];
+static bool shown_indexed = false;
+static uint8_t from_brightness;
+static uint8_t shown_brightness;
+static bool has_shown = false;
+static bool running = false;
+static led_ease_t ease;
+static int64_t start_us;
+static uint32_t duration_us;
+static uint8_t indices[LED_COUNT];
+static led_rgb_t palette_copy[PALETTE_SIZE];
+
+
+static void expand(uint8_t *out, const uint8_t *frame_indices, const led_rgb_t *palette) {
+    for (size_t i = 0; i < LED_COUNT; ++i) {
+        memcpy(out + i * LED_PIXEL_BYTES, &palette[frame_indices[i]], LED_PIXEL_BYTES);
+    }
+}
+
+static void record(const uint8_t *pixels, const led_rgb_t *palette, uint8_t brightness) {
+    shown_indexed = palette != NULL;
+    if (palette) {
+        memcpy(shown, pixels, LED_COUNT);
+        memcpy(shown_palette, palette, sizeof(shown_palette));
+    } else {
+        memcpy(shown, pixels, sizeof(shown));
+    }
+    shown_brightness = brightness;
+    has_shown = true;
+}
+
+
+uint32_t led_transition_ease(led_ease_t curve, uint32_t t) {
+    switch (curve) {
+        case LED_EASE_IN:
+            return (uint64_t)t * t >> 16;
+        case LED_EASE_OUT: {
+            uint32_t rest = LED_EASE_ONE - t;
+            return LED_EASE_ONE - (uint32_t)((uint64_t)rest * rest >> 16);
+        }
+        case LED_EASE_IN_OUT:
+            // 3t^2 - 2t^3
+            return (uint64_t)t * t * (3 * LED_EASE_ONE - 2 * t) >> 32;
+        default:
+            return t;
+    }
+}
+
+
+void led_transition_request(uint32_t duration_ms, led_ease_t curve) {
+    if (duration_ms > LED_TRANSITION_MAX_MS) duration_ms = LED_TRANSITION_MAX_MS;
+    portENTER_CRITICAL(&request_lock);
+    requested_ms = duration_ms;
+    requested_ease = curve;
+    portEXIT_CRITICAL(&request_lock);
+}
+
+
+static void take_request(int64_t now) {
+    portENTER_CRITICAL(&request_lock);
+    uint32_t duration_ms = requested_ms;
+    led_ease_t curve = requested_ease;
+    requested_ms = NO_REQUEST;
+    portEXIT_CRITICAL(&request_lock);
+
+    if (duration_ms == NO_REQUEST) return;
+    if (duration_ms == 0 || !has_shown) {
+        running = false;
+        return;
+    }
+    // Starts from what is on the strip, which is mid-fade if a transition is being replaced
+    if (shown_indexed) {
+        expand(from, shown, shown_palette);
+    } else {
+        memcpy(from, shown, sizeof(from));
+    }
+    from_brightness = shown_brightness;
+    ease = curve;
+    start_us = now;
+    duration_us = duration_ms * 1000;
+    running = true;
+}
+
+
+bool led_transition_apply(uint8_t *pixels, const led_rgb_t *palette, uint8_t *brightness) {
+    int64_t now = esp_timer_get_time();
+    take_request(now);
+
+    if (running && now - start_us >= duration_us) running = false;
+    if (!running) {
+        // Kept as it is: an indexed frame is only expanded once a transition needs its colors
+        record(pixels, palette, *brightness);
+        return false;
+    }
+
+    if (palette) {
+        // Expanding in place would overwrite indices and colors not read yet
+        memcpy(indices, pixels, sizeof(indices));
+        memcpy(palette_copy, palette, sizeof(palette_copy));
+        expand(pixels, indices, palette_copy);
+    }
+    uint32_t progress = (uint64_t)(now - start_us) * LED_EASE_ONE / duration_us;
+    int32_t weight = led_transition_ease(ease, progress);
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) {
+        pixels[i] = from[i] + (((pixels[i] - from[i]) * weight) >> 16);
+    }
+    *brightness = from_brightness + (((*brightness - from_brightness) * weight) >> 16);
+
+    record(pixels, NULL, *brightness);
+    return true;
+}
+
+
+void led_transition_cut(void) {
+    running = false;
+    has_shown = false;
+}
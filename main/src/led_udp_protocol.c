@@ -0,0 +1,199 @@
+#include <string.h>
+#include <stdbool.h>
+
+#include "led_udp_protocol.h"
+#include "led_clock_sync.h"
+#include "led_jitter_buffer.h"
+
+
+/* DDP (http://www.3waylabs.com/ddp/) */
+#define DDP_HEADER_LEN          10
+#define DDP_TIMECODE_LEN        4
+#define DDP_VERSION_MASK        0xC0
+#define DDP_VERSION_1           0x40
+#define DDP_FLAG_TIMECODE       (1 << 4)
+#define DDP_FLAG_STORAGE        (1 << 3)
+#define DDP_FLAG_REPLY          (1 << 2)
+#define DDP_FLAG_QUERY          (1 << 1)
+#define DDP_FLAG_PUSH           (1 << 0)
+#define DDP_SEQUENCE_MASK       0x0F
+#define DDP_ID_DISPLAY          1
+#define DDP_ID_ALL              255
+
+/* E1.31 (ANSI E1.31-2018) data packet */
+#define E131_HEADER_LEN         126         // Up to and including the DMX start code
+#define E131_ROOT_VECTOR        0x00000004
+#define E131_FRAMING_VECTOR     0x00000002
+#define E131_DMP_VECTOR         0x02
+#define E131_OPT_PREVIEW        (1 << 7)
+#define E131_OPT_TERMINATED     (1 << 6)
+#define E131_SEQ_DISCARD_WINDOW 20          // Spec 6.7.2: packets up to 20 behind are out of order
+#define E131_ALL_UNIVERSES      ((uint32_t)((1ULL << E131_UNIVERSE_COUNT) - 1))
+
+_Static_assert(E131_UNIVERSE_COUNT <= 32, "universe bookkeeping uses a 32 bit mask");
+
+
+// Frame commits switch the render loop over to streamed frames
+extern void stream_frame_received(void);
+
+static const uint8_t acn_packet_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+static led_udp_stats_t udp_stats;
+
+static uint8_t ddp_last_seq = 0;
+// Timecoded DDP frames are assembled outside the frame buffer, they are shown later from the jitter buffer
+static uint8_t timed_frame[LED_FRAME_BYTES];
+static uint8_t e131_last_seq[E131_UNIVERSE_COUNT];
+static uint32_t e131_seq_valid = 0;
+static uint32_t e131_received = 0;     // Universes written into the frame being assembled
+
+
+static uint16_t read_be16(const uint8_t *buf) {
+    return (buf[0] << 8) | buf[1];
+}
+
+static uint32_t read_be32(const uint8_t *buf) {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+
+/* Copies network RGB channels, starting at channel offset `channel`, into the frame. Excess data is clipped. */
+static void map_channels(uint8_t *frame, uint32_t channel, const uint8_t *data, size_t len) {
+    if (channel >= LED_FRAME_BYTES) return;
+    if (len > LED_FRAME_BYTES - channel) len = LED_FRAME_BYTES - channel;
+    memcpy(frame + channel, data, len);
+}
+
+
+static void commit_frame(void) {
+    ++udp_stats.frames;
+    stream_frame_received();
+}
+
+
+static void handle_timed_ddp_data(uint32_t offset, const uint8_t *data, size_t len, bool push, uint32_t timecode) {
+    map_channels(timed_frame, offset, data, len);
+    if (!push) return;
+
+    int64_t pts_us;
+    if (!led_clock_from_timecode(timecode, &pts_us)) {
+        // Not synchronized yet, better to show the frame unsynchronized than not at all
+        uint8_t *frame = led_fb_begin_write();
+        memcpy(frame, timed_frame, LED_FRAME_BYTES);
+        led_fb_end_write(true);
+        commit_frame();
+        return;
+    }
+    // The jitter buffer commits the frame when it is due
+    if (led_jb_push(timed_frame, pts_us) == ESP_OK) ++udp_stats.frames;
+}
+
+
+void led_udp_handle_ddp(const uint8_t *buf, size_t len) {
+    ++udp_stats.packets;
+    if (len < DDP_HEADER_LEN || (buf[0] & DDP_VERSION_MASK) != DDP_VERSION_1) {
+        ++udp_stats.dropped_invalid;
+        return;
+    }
+    uint8_t flags = buf[0];
+    // Only plain writes to the display are supported
+    if (flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY | DDP_FLAG_STORAGE)) return;
+    if (buf[3] != DDP_ID_DISPLAY && buf[3] != DDP_ID_ALL) return;
+
+    // 4 bit sequence number, 0 = unused. Anything not up to half the sequence space ahead is stale or a duplicate.
+    uint8_t seq = buf[1] & DDP_SEQUENCE_MASK;
+    if (seq && ddp_last_seq) {
+        uint8_t ahead = (seq - ddp_last_seq) & DDP_SEQUENCE_MASK;
+        if (ahead == 0 || ahead > 8) {
+            ++udp_stats.dropped_out_of_order;
+            return;
+        }
+    }
+    if (seq) ddp_last_seq = seq;
+
+    size_t header_len = DDP_HEADER_LEN + ((flags & DDP_FLAG_TIMECODE) ? DDP_TIMECODE_LEN : 0);
+    uint32_t offset = read_be32(buf + 4);
+    uint16_t data_len = read_be16(buf + 8);
+    if (header_len + data_len > len) {
+        ++udp_stats.dropped_invalid;
+        return;
+    }
+
+    bool push = flags & DDP_FLAG_PUSH;
+    if (flags & DDP_FLAG_TIMECODE) {
+        handle_timed_ddp_data(offset, buf + header_len, data_len, push, read_be32(buf + DDP_HEADER_LEN));
+        return;
+    }
+    uint8_t *frame = led_fb_begin_update();
+    map_channels(frame, offset, buf + header_len, data_len);
+    led_fb_end_write(push);
+    if (push) commit_frame();
+}
+
+
+void led_udp_handle_e131(const uint8_t *buf, size_t len) {
+    ++udp_stats.packets;
+    if (len < E131_HEADER_LEN ||
+        memcmp(buf + 4, acn_packet_id, sizeof(acn_packet_id)) ||
+        read_be32(buf + 18) != E131_ROOT_VECTOR ||
+        read_be32(buf + 40) != E131_FRAMING_VECTOR ||
+        buf[117] != E131_DMP_VECTOR ||
+        buf[125] != 0) {    // Only DMX (null start code) data carries pixels
+        ++udp_stats.dropped_invalid;
+        return;
+    }
+
+    uint8_t options = buf[112];
+    uint16_t universe = read_be16(buf + 113);
+    if (options & E131_OPT_PREVIEW) return;
+    if (universe < E131_START_UNIVERSE || universe - E131_START_UNIVERSE >= E131_UNIVERSE_COUNT) return;
+    int index = universe - E131_START_UNIVERSE;
+
+    if (options & E131_OPT_TERMINATED) {
+        // The source went away; accept any sequence number from the next one
+        e131_seq_valid &= ~(1u << index);
+        return;
+    }
+
+    uint8_t seq = buf[111];
+    if (e131_seq_valid & (1u << index)) {
+        int8_t diff = (int8_t)(seq - e131_last_seq[index]);
+        if (diff <= 0 && diff > -E131_SEQ_DISCARD_WINDOW) {
+            ++udp_stats.dropped_out_of_order;
+            return;
+        }
+    }
+    e131_last_seq[index] = seq;
+    e131_seq_valid |= 1u << index;
+
+    uint16_t value_count = read_be16(buf + 123);    // Start code included
+    if (value_count < 1 || E131_HEADER_LEN + value_count - 1 > len) {
+        ++udp_stats.dropped_invalid;
+        return;
+    }
+    size_t channels = value_count - 1;
+    if (channels > E131_CHANNELS_PER_UNIVERSE) channels = E131_CHANNELS_PER_UNIVERSE;
+
+    uint8_t *frame = led_fb_begin_update();
+    if (e131_received & (1u << index)) {
+        // The next frame started before the current one completed (a universe was lost): show what we have
+        led_fb_end_write(true);
+        commit_frame();
+        frame = led_fb_begin_update();
+        e131_received = 0;
+    }
+    map_channels(frame, index * E131_CHANNELS_PER_UNIVERSE, buf + E131_HEADER_LEN, channels);
+    e131_received |= 1u << index;
+
+    bool complete = e131_received == E131_ALL_UNIVERSES;
+    led_fb_end_write(complete);
+    if (complete) {
+        e131_received = 0;
+        commit_frame();
+    }
+}
+
+
+led_udp_stats_t led_udp_get_stats(void) {
+    return udp_stats;
+}
@@ -0,0 +1,82 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+
+#include "led_udp_receiver.h"
+#include "led_udp_protocol.h"
+
+
+#define UDP_TAG                 "UDP_PIXELS"
+#define UDP_RX_BUFF_SIZE        1472        // Largest UDP payload on a 1500 byte MTU
+
+static uint8_t rx_buffer[UDP_RX_BUFF_SIZE];
+
+
+static int open_udp_socket(uint16_t port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) return -1;
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+
+/* sACN sources usually multicast each universe to 239.255.<universe hi>.<universe lo> */
+static void join_e131_groups(int sock) {
+    for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) {
+        uint16_t universe = E131_START_UNIVERSE + i;
+        struct ip_mreq mreq = {
+            .imr_multiaddr.s_addr = htonl(0xEFFF0000 | universe),
+            .imr_interface.s_addr = htonl(INADDR_ANY),
+        };
+        if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            ESP_LOGW(UDP_TAG, "Failed joining multicast group of universe %d, unicast only", universe);
+        }
+    }
+}
+
+
+void process_udp_pixels(void *arg) {
+    int ddp_sock = open_udp_socket(DDP_PORT);
+    int e131_sock = open_udp_socket(E131_PORT);
+    if (ddp_sock < 0 || e131_sock < 0) {
+        ESP_LOGE(UDP_TAG, "Failed to open UDP pixel sockets");
+        if (ddp_sock >= 0) close(ddp_sock);
+        if (e131_sock >= 0) close(e131_sock);
+        vTaskDelete(NULL);
+    }
+    join_e131_groups(e131_sock);
+    int max_fd = (ddp_sock > e131_sock) ? ddp_sock : e131_sock;
+    ESP_LOGI(UDP_TAG, "Listening for DDP on %d and E1.31 on %d (%d universes)", DDP_PORT, E131_PORT, E131_UNIVERSE_COUNT);
+
+    while (1) {
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(ddp_sock, &read_fds);
+        FD_SET(e131_sock, &read_fds);
+
+        if (select(max_fd + 1, &read_fds, NULL, NULL, NULL) < 0) {
+            ESP_LOGE(UDP_TAG, "select failed");
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        if (FD_ISSET(ddp_sock, &read_fds)) {
+            int len = recv(ddp_sock, rx_buffer, sizeof(rx_buffer), 0);
+            if (len > 0) led_udp_handle_ddp(rx_buffer, len);
+        }
+        if (FD_ISSET(e131_sock, &read_fds)) {
+            int len = recv(e131_sock, rx_buffer, sizeof(rx_buffer), 0);
+            if (len > 0) led_udp_handle_e131(rx_buffer, len);
+        }
+    }
+}
+
@@ -0,0 +1,128 @@
+#include <string.h>
+#include <stdbool.h>
+
+#include "led_vm.h"
+#include "led_math.h"
+
+
+#define HEADER_BYTES            5
+#define INSN_BYTES              4
+
+static int32_t clamp32(int64_t value) {
+    if (value > INT32_MAX) return INT32_MAX;
+    if (value < INT32_MIN) return INT32_MIN;
+    return value;
+}
+
+static uint8_t to_channel(int32_t value) {
+    if (value <= 0) return 0;
+    if (value >= LED_VM_ONE) return 255;
+    return (value * 255 + LED_VM_ONE / 2) >> 16;
+}
+
+
+static bool verify_insn(const led_vm_insn_t *insn, size_t pc, size_t len) {
+    switch (insn->op) {
+        case LED_VM_LDI:
+            return insn->d < LED_VM_REGISTERS;
+        case LED_VM_HSV:
+            return insn->d + 2 < LED_VM_REGISTERS && insn->a < LED_VM_REGISTERS && insn->b < LED_VM_REGISTERS;
+        case LED_VM_JMP:
+            return pc + 1 + insn->d <= len;
+        case LED_VM_JLT:
+        case LED_VM_JGE:
+            return pc + 1 + insn->d <= len && insn->a < LED_VM_REGISTERS && insn->b < LED_VM_REGISTERS;
+        default:
+            return insn->op < LED_VM_OP_COUNT && insn->d < LED_VM_REGISTERS && insn->a < LED_VM_REGISTERS &&
+                   insn->b < LED_VM_REGISTERS;
+    }
+}
+
+static esp_err_t verify_code(led_vm_insn_t *code, const uint8_t *data, size_t len) {
+    for (size_t pc = 0; pc < len; ++pc) {
+        const uint8_t *raw = data + pc * INSN_BYTES;
+        code[pc] = (led_vm_insn_t){ raw[0], raw[1], raw[2], raw[3] };
+        if (!verify_insn(&code[pc], pc, len)) return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+
+esp_err_t led_vm_load(led_vm_program_t *program, const uint8_t *data, size_t len) {
+    if (len < HEADER_BYTES) return ESP_ERR_INVALID_SIZE;
+    if (data[0] != LED_VM_MAGIC_0 || data[1] != LED_VM_MAGIC_1 || data[2] != LED_VM_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    size_t frame_len = data[3];
+    size_t pixel_len = data[4];
+    if (frame_len > LED_VM_MAX_CODE || pixel_len > LED_VM_MAX_CODE) return ESP_ERR_INVALID_SIZE;
+    if (len != HEADER_BYTES + (frame_len + pixel_len) * INSN_BYTES) return ESP_ERR_INVALID_SIZE;
+
+    // Verified into a scratch copy so a rejected upload leaves the running program alone
+    led_vm_program_t verified = { .frame_len = frame_len, .pixel_len = pixel_len };
+    esp_err_t ret = verify_code(verified.frame, data + HEADER_BYTES, frame_len);
+    if (ret != ESP_OK) return ret;
+    ret = verify_code(verified.pixel, data + HEADER_BYTES + frame_len * INSN_BYTES, pixel_len);
+    if (ret != ESP_OK) return ret;
+
+    *program = verified;
+    return ESP_OK;
+}
+
+
+/* Runs verified code: registers and jump targets are known to be in range. Operands are only read by the
+ * instructions that have them, LDI and the jumps use the fields for other things. */
+static void run(const led_vm_insn_t *code, size_t len, int32_t *r) {
+#define D r[insn->d]
+#define A r[insn->a]
+#define B r[insn->b]
+    for (size_t pc = 0; pc < len; ++pc) {
+        const led_vm_insn_t *insn = &code[pc];
+        switch (insn->op) {
+            case LED_VM_LDI:    D = (int32_t)(int16_t)(insn->a << 8 | insn->b) * 256;  break;
+            case LED_VM_MOV:    D = A;                                                 break;
+            case LED_VM_ADD:    D = clamp32((int64_t)A + B);                           break;
+            case LED_VM_SUB:    D = clamp32((int64_t)A - B);                           break;
+            case LED_VM_MUL:    D = clamp32((int64_t)A * B >> 16);                     break;
+            case LED_VM_DIV:    D = B ? clamp32(((int64_t)A << 16) / B) : 0;           break;
+            case LED_VM_MIN:    D = A < B ? A : B;                                     break;
+            case LED_VM_MAX:    D = A > B ? A : B;                                     break;
+            case LED_VM_ABS:    D = A < 0 ? clamp32(-(int64_t)A) : A;                  break;
+            case LED_VM_FRAC:   D = A & (LED_VM_ONE - 1);                              break;
+            case LED_VM_FLOOR:  D = A & ~(LED_VM_ONE - 1);                             break;
+            case LED_VM_SIN:    D = led_sin16(A) * 2;                                  break;
+            case LED_VM_HSV: {
+                led_rgb_t color = led_hsv_to_rgb(A & (LED_VM_ONE - 1), 255, to_channel(B));
+                r[insn->d] = color.r * LED_VM_ONE / 255;
+                r[insn->d + 1] = color.g * LED_VM_ONE / 255;
+                r[insn->d + 2] = color.b * LED_VM_ONE / 255;
+                break;
+            }
+            case LED_VM_JMP:    pc += insn->d;                                         break;
+            case LED_VM_JLT:    if (A < B) pc += insn->d;                              break;
+            case LED_VM_JGE:    if (A >= B) pc += insn->d;                             break;
+        }
+    }
+#undef D
+#undef A
+#undef B
+}
+
+
+void led_vm_run_frame(const led_vm_program_t *program, int32_t *regs, int32_t time) {
+    regs[LED_VM_R_T] = time;
+    run(program->frame, program->frame_len, regs);
+}
+
+
+led_rgb_t led_vm_run_pixel(const led_vm_program_t *program, const int32_t *regs, int x, int y, size_t index,
+                           size_t count) {
+    int32_t r[LED_VM_REGISTERS];
+    memcpy(r, regs, sizeof(r));
+    r[LED_VM_R_I] = index * LED_VM_ONE;
+    r[LED_VM_R_X] = x * LED_VM_ONE;
+    r[LED_VM_R_Y] = y * LED_VM_ONE;
+    r[LED_VM_R_U] = (int64_t)index * LED_VM_ONE / count;
+    run(program->pixel, program->pixel_len, r);
+    return (led_rgb_t){ to_channel(r[0]), to_channel(r[1]), to_channel(r[2]) };
+}
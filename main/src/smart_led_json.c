@@ -0,0 +1,153 @@
+#include <string.h>
+#include <stdbool.h>
+
+#include "smart_led_json.h"
+#include "json_sax.h"
+#include "led_color.h"
+#include "led_effect.h"
+#include "led_transition.h"
+
+
+typedef struct {
+    smart_led_state_t staged;   // Committed to the device state only if parsing succeeds
+    int32_t transition_ms;      // -1 if the command has none
+    const char *key;            // Last key seen at depth 1
+    size_t key_len;
+    const char *color_key;      // Last key seen inside "color"
+    size_t color_key_len;
+    bool in_color;
+    bool has_hs;
+    int32_t hue;
+    int32_t saturation;
+} json_cmd_ctx;
+
+
+static bool key_is(const char *key, size_t key_len, const char *literal) {
+    return key && key_len == strlen(literal) && !memcmp(key, literal, key_len);
+}
+
+static uint8_t clamp_u8(int32_t value) {
+    if (value < 0) return 0;
+    if (value > 255) return 255;
+    return (uint8_t)value;
+}
+
+
+static esp_err_t bind_top_level(const json_event *ev, json_cmd_ctx *cmd) {
+    // A fade given as anything but a number is a mistake, not a value to skip
+    if ((key_is(cmd->key, cmd->key_len, "transition") || key_is(cmd->key, cmd->key_len, "transition_ms")) &&
+        ev->type != JSON_KEY && ev->type != JSON_NUMBER) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    switch (ev->type) {
+        case JSON_KEY:
+            cmd->key = ev->str;
+            cmd->key_len = ev->str_len;
+            break;
+        case JSON_OBJECT_START:
+            if (key_is(cmd->key, cmd->key_len, "color")) {
+                cmd->in_color = true;
+                cmd->color_key = NULL;
+            }
+            break;
+        case JSON_STRING:
+            if (key_is(cmd->key, cmd->key_len, "state")) {
+                if (key_is(ev->str, ev->str_len, "ON")) cmd->staged.on = 1;
+                else if (key_is(ev->str, ev->str_len, "OFF")) cmd->staged.on = 0;
+                else if (key_is(ev->str, ev->str_len, "TOGGLE")) cmd->staged.on ^= 1;
+                else return ESP_ERR_INVALID_ARG;
+            } else if (key_is(cmd->key, cmd->key_len, "effect")) {
+                int effect = led_effect_find(ev->str, ev->str_len);
+                if (effect < 0) return ESP_ERR_INVALID_ARG;
+                cmd->staged.effect = effect;
+            } else if (key_is(cmd->key, cmd->key_len, "text")) {
+                if (ev->str_len > LED_STATE_TEXT_LEN) return ESP_ERR_INVALID_ARG;
+                // Zero padded, the reporter compares whole states
+                memset(cmd->staged.text, 0, sizeof(cmd->staged.text));
+                memcpy(cmd->staged.text, ev->str, ev->str_len);
+            }
+            break;
+        case JSON_NUMBER:
+            if (key_is(cmd->key, cmd->key_len, "brightness")) {
+                cmd->staged.brightness = clamp_u8(ev->number);
+            } else if (key_is(cmd->key, cmd->key_len, "transition")) {
+                int32_t transition_ms = json_number_scaled(ev, 3);   // Fractional seconds, e.g. 0.4
+                if (transition_ms < 0 || transition_ms > LED_TRANSITION_MAX_MS) return ESP_ERR_INVALID_ARG;
+                cmd->transition_ms = transition_ms;
+            } else if (key_is(cmd->key, cmd->key_len, "transition_ms")) {
+                if (ev->number < 0 || ev->number > LED_TRANSITION_MAX_MS) return ESP_ERR_INVALID_ARG;
+                cmd->transition_ms = ev->number;
+            }
+            break;
+        default:
+            break;
+    }
+    return ESP_OK;
+}
+
+
+static esp_err_t bind_color(const json_event *ev, json_cmd_ctx *cmd) {
+    if (ev->type == JSON_KEY) {
+        cmd->color_key = ev->str;
+        cmd->color_key_len = ev->str_len;
+        return ESP_OK;
+    }
+    if (ev->type != JSON_NUMBER) return ESP_OK;
+
+    if (key_is(cmd->color_key, cmd->color_key_len, "r")) cmd->staged.red = clamp_u8(ev->number);
+    else if (key_is(cmd->color_key, cmd->color_key_len, "g")) cmd->staged.green = clamp_u8(ev->number);
+    else if (key_is(cmd->color_key, cmd->color_key_len, "b")) cmd->staged.blue = clamp_u8(ev->number);
+    else if (key_is(cmd->color_key, cmd->color_key_len, "h")) {
+        if (ev->number < 0 || ev->number > 360) return ESP_ERR_INVALID_ARG;
+        cmd->hue = ev->number;
+        cmd->has_hs = true;
+    } else if (key_is(cmd->color_key, cmd->color_key_len, "s")) {
+        if (ev->number < 0 || ev->number > 100) return ESP_ERR_INVALID_ARG;
+        cmd->saturation = ev->number;
+        cmd->has_hs = true;
+    }
+    return ESP_OK;
+}
+
+
+static esp_err_t bind_event(const json_event *ev, void *ctx) {
+    json_cmd_ctx *cmd = ctx;
+
+    switch (ev->depth) {
+        case 0:
+            // The command must be a single object
+            if (ev->type != JSON_OBJECT_START && ev->type != JSON_OBJECT_END) return ESP_ERR_INVALID_ARG;
+            return ESP_OK;
+        case 1:
+            if (ev->type == JSON_OBJECT_END) cmd->in_color = false;
+            return bind_top_level(ev, cmd);
+        case 2:
+            if (cmd->in_color) return bind_color(ev, cmd);
+            return ESP_OK;
+        default:
+            return ESP_OK;      // Nested values of unknown keys are skipped
+    }
+}
+
+
+esp_err_t smart_led_apply_json(const char *payload, size_t len, smart_led_state_t *state, uint32_t *transition_ms) {
+    json_cmd_ctx cmd = {
+        .staged = *state,
+        .transition_ms = -1,
+        .saturation = 100,
+    };
+
+    esp_err_t ret = json_sax_parse(payload, len, bind_event, &cmd);
+    if (ret != ESP_OK) return ret;
+
+    if (cmd.has_hs) {
+        led_rgb_t color = led_hsv_to_rgb(LED_HUE_DEGREES(cmd.hue), cmd.saturation * 255 / 100, 255);
+        cmd.staged.red = color.r;
+        cmd.staged.green = color.g;
+        cmd.staged.blue = color.b;
+    }
+    *state = cmd.staged;
+    if (cmd.transition_ms >= 0) *transition_ms = cmd.transition_ms;
+    return ESP_OK;
+}
@@ -8,99 +8,266 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
-#include "driver/rmt_tx.h"
 
-#include "led_strip_encoder.h"
 #include "smart_led_mqtt.h"
+#include "smart_led_state.h"
+#include "smart_led_json.h"
+#include "smart_led_reporter.h"
+#include "led_frame_buffer.h"
+#include "led_udp_receiver.h"
+#include "led_clock_sync.h"
+#include "led_jitter_buffer.h"
+#include "led_anim_cache.h"
+#include "led_frame_scheduler.h"
+#include "led_strip_output.h"
+#include "led_color.h"
+#include "led_render_parallel.h"
+#include "led_gamma.h"
+#include "led_effect.h"
+#include "led_pixel_map.h"
+#include "led_compositor.h"
+#include "led_transition.h"
 #include "env_config.h"
 
 
 
 #define RMT_LED_STRIP_RESOLUTION_HZ     10000000        // 10MHz resolution, 1\tick = 0.1us (led strip needs a high resolution)
-#define RMT_LED_STRIP_GPIO_NUM          GPIO_NUM_26
+#define LED_OUTPUT_BACKEND              LED_OUTPUT_BACKEND_RMT  // _SPI / _PARALLEL stream frames by DMA
+#define RMT_LED_STRIP_GPIO_NUMS         { GPIO_NUM_26 }         // One segment per GPIO, LED_COUNT split evenly
+#define LED_PARALLEL_CLOCK_GPIO         GPIO_NUM_18     // Driven by the parallel backend, left unconnected
+#define LED_PARALLEL_DC_GPIO            GPIO_NUM_19
 #define BUTTON_TOGGLE_GPIO              GPIO_NUM_27
 #define MOSFET_GATE_GPIO                GPIO_NUM_12
 #define PIR_GPIO                        GPIO_NUM_14
 
-#define LED_COUNT                       300
-#define CHASE_SPEED_MS                  10
+#define LED_MAP_LAYOUT                  LED_MAP_LINEAR  // _MATRIX for strips folded into rows, _CUSTOM for pixel_map.csv
+#define LED_MAP_WIDTH                   20              // Matrix: LEDs per wired row
+#define LED_MAP_HEIGHT                  15
+#define LED_MAP_SERPENTINE              true
+#define LED_MAP_ROTATION                0               // Quarter turns clockwise
+#define PIR_HIGHLIGHT_COLOR             { 255, 255, 255 }
+#define PIR_HIGHLIGHT_OPACITY           64      // Added on top of the effect while there is motion
+#define LED_TRANSITION_DEFAULT_MS       400     // Fade for commands without a "transition", buttons and motion
+#define LED_TRANSITION_EASE             LED_EASE_IN_OUT
+#define LED_TEMPORAL_DITHER             false   // true recovers the low levels but renders static scenes at full fps
+#define RENDER_TASK_PRIORITY            10
+#define LED_TARGET_FPS                  100     // 300 LEDs per segment take ~9 ms on the wire, ~110 fps at most
 
 #define WIFI_SSID                       "Deco Wi-Fi"
 
+#ifndef TIME_SERVER_IP
+#define TIME_SERVER_IP                  SERVER_IP       // The show controller usually runs the broker and NTP
+#endif
+
+
+smart_led_state_t led_state = {
+    .on = 0,
+    .mode = LED_MODE_SOLID,
+    .brightness = 255,
+    .red = 0,
+    .green = 0,
+    .blue = 127,
+    .effect = LED_EFFECT_NONE,
+};
+portMUX_TYPE led_state_lock = portMUX_INITIALIZER_UNLOCKED;
 
-static int toggle_mosfet_gate = 0;
 static bool pir_timer_active = false;
+static volatile bool pir_highlight = false;     // Motion while the strip was already on
 static const char *TAG = "LED_STRIP";
 
-static uint8_t led_strip_pixels[LED_COUNT * 3];     // * 3 = RGB
+static int broker_sock = -1;
+static const uint8_t *stream_frame = NULL;     // Newest streamed frame, owned by the render loop until the next take
+
+
+/* Every state change is reported, and rendered fading over `transition_ms` */
+static void state_changed(uint32_t transition_ms) {
+    led_transition_request(transition_ms, LED_TRANSITION_EASE);
+    smart_led_reporter_notify();
+    led_sched_mark_dirty();
+}
+
+
+static void set_on(uint8_t on) {
+    portENTER_CRITICAL(&led_state_lock);
+    led_state.on = on;
+    portEXIT_CRITICAL(&led_state_lock);
+}
 
 
 void turn_on_led(void *arg) {
-    toggle_mosfet_gate = 1;
+    set_on(1);
+    state_changed(LED_TRANSITION_DEFAULT_MS);
     ESP_LOGI("MQTT_PUBLISH", "LED_ON");
 }
 
 void turn_off_led(void *arg) {
-    toggle_mosfet_gate = 0;
+    set_on(0);
+    state_changed(LED_TRANSITION_DEFAULT_MS);
     ESP_LOGI("MQTT_PUBLISH", "LED_OFF");
 }
 
+void apply_json_command(char *payload, uint32_t payload_len) {
+    uint32_t transition_ms = LED_TRANSITION_DEFAULT_MS;
+    smart_led_state_t state = led_state_snapshot();
+    esp_err_t ret = smart_led_apply_json(payload, payload_len, &state, &transition_ms);
+    if (ret != ESP_OK) {
+        ESP_LOGE("MQTT_PUBLISH", "Rejected JSON command: %s", esp_err_to_name(ret));
+        return;
+    }
+    led_anim_stop();
+    state.mode = LED_MODE_SOLID;    // A command takes the strip back from a frame stream
+    portENTER_CRITICAL(&led_state_lock);
+    led_state = state;
+    portEXIT_CRITICAL(&led_state_lock);
+    state_changed(transition_ms);
+    ESP_LOGI("MQTT_PUBLISH", "JSON command applied (on=%d brightness=%d)", state.on, state.brightness);
+}
+
+void stream_frame_received(void) {
+    portENTER_CRITICAL(&led_state_lock);
+    bool entered = led_state.mode != LED_MODE_STREAM;
+    led_state.mode = LED_MODE_STREAM;
+    portEXIT_CRITICAL(&led_state_lock);
+    if (entered) state_changed(0);
+}
+
 void disable_timer(TimerHandle_t xTimer) {
     pir_timer_active = false;
-    toggle_mosfet_gate = 0;
+    if (pir_highlight) {
+        pir_highlight = false;
+        led_transition_request(LED_TRANSITION_DEFAULT_MS, LED_TRANSITION_EASE);
+        led_sched_mark_dirty();
+    } else {
+        set_on(0);
+        state_changed(LED_TRANSITION_DEFAULT_MS);
+    }
 
     ESP_LOGI("PIR", "TIMER OFF");
 }
 
 
-/**
- * @brief Simple helper function, converting HSV color space to RGB color space
- *
- * Wiki: https://en.wikipedia.org/wiki/HSL_and_HSV
- *
- */
-void led_strip_hsv2rgb(uint32_t h, uint32_t s, uint32_t v, uint32_t *r, uint32_t *g, uint32_t *b) {
-    h %= 360; // h -> [0,360]
-    uint32_t rgb_max = v * 2.55f;
-    uint32_t rgb_min = rgb_max * (100 - s) / 100.0f;
-
-    uint32_t i = h / 60;
-    uint32_t diff = h % 60;
-
-    // RGB adjustment amount by hue
-    uint32_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
-
-    switch (i) {
-    case 0:
-        *r = rgb_max;
-        *g = rgb_min + rgb_adj;
-        *b = rgb_min;
-        break;
-    case 1:
-        *r = rgb_max - rgb_adj;
-        *g = rgb_max;
-        *b = rgb_min;
-        break;
-    case 2:
-        *r = rgb_min;
-        *g = rgb_max;
-        *b = rgb_min + rgb_adj;
-        break;
-    case 3:
-        *r = rgb_min;
-        *g = rgb_max - rgb_adj;
-        *b = rgb_max;
-        break;
-    case 4:
-        *r = rgb_min + rgb_adj;
-        *g = rgb_min;
-        *b = rgb_max;
-        break;
-    default:
-        *r = rgb_max;
-        *g = rgb_min;
-        *b = rgb_max - rgb_adj;
-        break;
+/* Render loop, pinned to the render core. The RMT channel is created here so its interrupt lands there too. */
+static void render_strip(void *arg) {
+    static const gpio_num_t strip_gpios[] = RMT_LED_STRIP_GPIO_NUMS;
+    led_output_config_t output_config = {
+        .backend = LED_OUTPUT_BACKEND,
+        .gpio_nums = strip_gpios,
+        .segment_count = sizeof(strip_gpios) / sizeof(strip_gpios[0]),
+        .resolution_hz = RMT_LED_STRIP_RESOLUTION_HZ,
+        .parallel_clock_gpio = LED_PARALLEL_CLOCK_GPIO,
+        .parallel_dc_gpio = LED_PARALLEL_DC_GPIO,
+    };
+    ESP_ERROR_CHECK(led_output_init(&output_config));
+
+    led_layer_fill(LED_LAYER_OVERLAY, 0, LED_COUNT, (led_rgb_t)PIR_HIGHLIGHT_COLOR, 255);
+    led_layer_set_blend(LED_LAYER_OVERLAY, LED_BLEND_ADD, PIR_HIGHLIGHT_OPACITY);
+
+    TimerHandle_t pir_off = xTimerCreate("pir_off", pdMS_TO_TICKS(4000), pdFALSE, NULL, disable_timer);  // 20 seconds cd
+    led_sched_config_t sched_config = {
+        .target_fps = LED_TARGET_FPS,
+    };
+    ESP_ERROR_CHECK(led_sched_init(&sched_config));
+    while (1) {
+        // Sleeps until the next tick; inputs are polled at the frame rate
+        bool dirty = led_sched_wait_frame();
+
+        if (!gpio_get_level(BUTTON_TOGGLE_GPIO)) {
+            portENTER_CRITICAL(&led_state_lock);
+            led_state.on ^= 1;
+            portEXIT_CRITICAL(&led_state_lock);
+            state_changed(LED_TRANSITION_DEFAULT_MS);
+            vTaskDelay(200 / portTICK_PERIOD_MS);
+        }
+
+        if (gpio_get_level(PIR_GPIO) && !pir_timer_active) {
+            vTaskDelay(50 / portTICK_PERIOD_MS);  // debounce delay
+            // Motion lights a dark strip for the cooldown, and highlights one that is already on
+            portENTER_CRITICAL(&led_state_lock);
+            bool was_on = led_state.on;
+            led_state.on = 1;
+            portEXIT_CRITICAL(&led_state_lock);
+            if (was_on) {
+                pir_highlight = true;
+                led_transition_request(LED_TRANSITION_DEFAULT_MS, LED_TRANSITION_EASE);
+                led_sched_mark_dirty();
+            } else {
+                state_changed(LED_TRANSITION_DEFAULT_MS);
+            }
+            // Start a cooldown timer. The pir gpio will be ignored while this timer is active.
+            pir_timer_active = true;
+            xTimerStart(pir_off, 0);
+        }
+
+        // Snapshot the state so a command landing mid-frame can't tear it
+        smart_led_state_t state = led_state_snapshot();
+        if (state.on && state.mode == LED_MODE_STREAM) {
+            // Flip the newest streamed frame in; a new frame is what makes a stream dirty
+            const uint8_t *frame = led_fb_take_latest();
+            if (frame) {
+                stream_frame = frame;
+                dirty = true;
+            }
+        }
+        if (led_layer_show(LED_LAYER_OVERLAY, pir_highlight)) dirty = true;
+        if (!dirty) {
+            led_sched_end_frame(false);
+            continue;
+        }
+
+        // Rendered while the previous frame is still on the wire
+        led_output_frame_t *frame = led_output_acquire();
+        uint8_t *pixels = frame->pixels;
+        frame->indexed = false;
+        frame->map = NULL;
+        if (state.on) {
+            if (state.mode == LED_MODE_STREAM && stream_frame) {
+                memcpy(pixels, stream_frame, LED_FRAME_BYTES);
+            } else if (state.mode == LED_MODE_STREAM) {
+                memset(pixels, 0, LED_FRAME_BYTES);
+            } else if (state.effect != LED_EFFECT_NONE) {
+                led_effect_params_t params = {
+                    .color = { .r = state.red, .g = state.green, .b = state.blue },
+                    .text = state.text,
+                };
+                frame->indexed = led_effect_render_frame(state.effect, &params, pixels, frame->palette);
+                frame->map = led_map_table();   // Effects render on the logical grid
+                led_sched_mark_dirty();     // Animations keep the frame clock busy
+            } else {
+                led_rgb_t color = { .r = state.red, .g = state.green, .b = state.blue };
+                led_fill_solid(pixels, 0, LED_COUNT, color);
+            }
+            if (led_compositor_active() && state.mode != LED_MODE_STREAM) {
+                // Overlays are blended over the base in RGB, only where either changed
+                led_layer_update(LED_LAYER_BASE, pixels, frame->indexed ? frame->palette : NULL);
+                led_compositor_compose(pixels);
+                frame->indexed = false;
+                frame->map = led_map_table();
+            }
+        } else {
+            memset(pixels, 0, LED_FRAME_BYTES);
+        }
+
+        bool streaming = state.on && state.mode == LED_MODE_STREAM;
+        uint8_t brightness = state.brightness;
+        bool fading = false;
+        if (streaming) {
+            led_transition_cut();   // Wiring order, and timed by the sender
+        } else if (led_transition_apply(pixels, frame->indexed ? frame->palette : NULL, &brightness)) {
+            fading = true;
+            frame->indexed = false;
+            frame->map = led_map_table();   // Uniform frames read the same in either order
+            led_sched_mark_dirty();
+        }
+        // Power stays on until a fade to off has finished
+        gpio_set_level(MOSFET_GATE_GPIO, state.on || fading);
+
+        // Streamed frames are gamma corrected by their sender, they only get the brightness
+        led_gamma_set(streaming ? LED_GAMMA_LINEAR : LED_GAMMA_DEFAULT, brightness);
+        bool dither = LED_TEMPORAL_DITHER && (state.on || fading);
+        // Gamma and brightness are applied by the encoder as the frame goes out
+        if (led_gamma_prepare(&frame->lut, dither)) led_sched_mark_dirty();
+        ESP_ERROR_CHECK(led_output_submit(frame));
+        led_sched_end_frame(true);
     }
 }
 
@@ -157,85 +324,34 @@ void app_main(void) {
         vTaskDelay(pdMS_TO_TICKS(5000));
     }
 
+    // Real time pixel streams bypass MQTT entirely
+    led_map_config_t map_config = {
+        .layout = LED_MAP_LAYOUT,
+        .width = LED_MAP_WIDTH,
+        .height = LED_MAP_HEIGHT,
+        .serpentine = LED_MAP_SERPENTINE,
+        .rotation = LED_MAP_ROTATION,
+    };
+    ESP_ERROR_CHECK(led_map_init(&map_config));
+    ESP_ERROR_CHECK(led_fb_init());
+    ESP_ERROR_CHECK(led_jb_init());
+    if (led_anim_init() != ESP_OK) {
+        ESP_LOGW(TAG, "No animation partition, cached clips unavailable");
+    }
+    xTaskCreatePinnedToCore(process_clock_sync, "Clock sync", 4096, TIME_SERVER_IP, 17, NULL, LED_NET_CORE);
+    xTaskCreatePinnedToCore(process_udp_pixels, "UDP pixel receiver", 4096, NULL, 16, NULL, LED_NET_CORE);
+
     // Establish tcp connection to mqtt broker and start a thread to handle server messages
-    int sock = setup_mqtt_connection();
-    if (sock < 0) {
-        ESP_LOGE("MQTT", "Failed setting up mqtt connection. Err code: %d", sock);
+    broker_sock = setup_mqtt_connection();
+    if (broker_sock < 0) {
+        ESP_LOGE("MQTT", "Failed setting up mqtt connection. Err code: %d", broker_sock);
         return;
     }
-    xTaskCreate(process_broker_messages, "Process broker messages", 4096, &sock, 15, NULL);
+    xTaskCreatePinnedToCore(process_broker_messages, "Process broker messages", 4096, &broker_sock, 15, NULL,
+                            LED_NET_CORE);
     /* ------------------------------------------------------- */
 
-    /* ------------------ LED strip config ------------------- */
-    uint32_t red = 0;
-    uint32_t green = 0;
-    uint32_t blue = 0;
-    // uint16_t hue = 0;
-    // uint16_t start_rgb = 0;
-
-    ESP_LOGI(TAG, "Create RMT TX channel");
-    rmt_channel_handle_t led_chan = NULL;
-    rmt_tx_channel_config_t tx_chan_config = {
-        .clk_src = RMT_CLK_SRC_DEFAULT, // select source clock
-        .gpio_num = RMT_LED_STRIP_GPIO_NUM,
-        .mem_block_symbols = 64, // increase the block size can make the LED less flickering
-        .resolution_hz = RMT_LED_STRIP_RESOLUTION_HZ,
-        .trans_queue_depth = 4, // set the number of transactions that can be pending in the background
-    };
-    ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_chan_config, &led_chan));
-
-    ESP_LOGI(TAG, "Install led strip encoder");
-    rmt_encoder_handle_t led_encoder = NULL;
-    led_strip_encoder_config_t encoder_config = {
-        .resolution = RMT_LED_STRIP_RESOLUTION_HZ,
-    };
-    ESP_ERROR_CHECK(rmt_new_led_strip_encoder(&encoder_config, &led_encoder));
-
-    ESP_LOGI(TAG, "Enable RMT TX channel");
-    ESP_ERROR_CHECK(rmt_enable(led_chan));
-
-    ESP_LOGI(TAG, "Start LED rainbow chase");
-    rmt_transmit_config_t tx_config = {
-        .loop_count = 0, // no transfer loop
-    };
-
-    TimerHandle_t pir_off = xTimerCreate("pir_off", pdMS_TO_TICKS(4000), pdFALSE, NULL, disable_timer);  // 20 seconds cd
-    while (1) {
-        if (!gpio_get_level(BUTTON_TOGGLE_GPIO)) {
-            toggle_mosfet_gate ^= 1;
-            vTaskDelay(200 / portTICK_PERIOD_MS);
-        }
-
-        if (gpio_get_level(PIR_GPIO) && !pir_timer_active) {
-            vTaskDelay(50 / portTICK_PERIOD_MS);  // debounce delay
-            toggle_mosfet_gate = 1;
-            // Start a cooldown timer. The pir gpio will be ignored while this timer is active.
-            pir_timer_active = true;
-            xTimerStart(pir_off, 0);
-        }
-
-        if (toggle_mosfet_gate) {
-            gpio_set_level(MOSFET_GATE_GPIO, 1);
-            for (int i = 0; i < 3; ++i) {
-                for (int j = i; j < LED_COUNT; j += 3) {
-                    // Build RGB pixels
-                    // hue = j * 360 / LED_COUNT + start_rgb;
-                    led_strip_hsv2rgb(100, 50, 100, &red, &green, &blue);
-                    led_strip_pixels[j * 3 + 0] = 0;    // green
-                    led_strip_pixels[j * 3 + 1] = 0;    // red
-                    led_strip_pixels[j * 3 + 2] = blue; // blue
-                }
-            }
-            // Flush RGB values to LEDs
-            ESP_ERROR_CHECK(rmt_transmit(led_chan, led_encoder, led_strip_pixels, sizeof(led_strip_pixels), &tx_config));
-            ESP_ERROR_CHECK(rmt_tx_wait_all_done(led_chan, portMAX_DELAY));
-        } else {
-            // Turn off led
-            gpio_set_level(MOSFET_GATE_GPIO, 0);
-            memset(led_strip_pixels, 0, sizeof(led_strip_pixels));
-            ESP_ERROR_CHECK(rmt_transmit(led_chan, led_encoder, led_strip_pixels, sizeof(led_strip_pixels), &tx_config));
-            ESP_ERROR_CHECK(rmt_tx_wait_all_done(led_chan, portMAX_DELAY));
-        }
-    }
-    
+    // The network core lends a hand with expensive frames, the render core does nothing but render
+    ESP_ERROR_CHECK(led_render_parallel_init());
+    xTaskCreatePinnedToCore(render_strip, "Render strip", 4096, NULL, RENDER_TASK_PRIORITY, NULL, LED_RENDER_CORE);
 }
@@ -19,6 +19,8 @@
 #include <arpa/inet.h>
 
 #include "smart_led_mqtt.h"
+#include "smart_led_mqtt_rx.h"
+#include "smart_led_reporter.h"
 #include "../../components/mqtt_protocl_lib/include/mqtt_parser.h"
 #include "../../components/mqtt_protocl_lib/include/mqtt_protocol.h"
 #include "../../components/mqtt_protocl_lib/include/mqtt_util.h"
@@ -27,6 +29,8 @@
 
 
 #define SERVER_PORT     1883
+
+#define STATE_REPORT_WINDOW_MS      250     // Rapid changes (e.g. dragging a slider) within this window produce one publish
 #define MQTT_TAG        "MQTT"
 #define TCP_TAG         "TCP"
 #define TAG             "Wi-fi"
@@ -38,6 +42,7 @@
 
 
 static vector subscription_list = { .item_size = sizeof(app_subscription_entry) };
+static uint16_t packet_id = 1;      // Packet ID 0 is not allowed
 
 static const int WIFI_RETRY_ATTEMPT = 3;
 static int wifi_retry_count = 0;
@@ -51,6 +56,7 @@ static EventGroupHandle_t s_wifi_event_group = NULL;
 // ------ Subsciption actions ------
 extern void turn_on_led(void *arg);
 extern void turn_off_led(void *arg);
+extern void apply_json_command(char *payload, uint32_t payload_len);
 // ---------------------------------
 
 
@@ -238,97 +244,151 @@ esp_err_t smart_led_wifi_deinit(void) {
 
 
 
+static int subscribe_to_topics(int sock) {
+    // Pack and send subscribe request
+    char *topic_name = LED_TOPIC;
+    subscribe_tuples sub_properties = {
+        .topic = topic_name,
+        .qos = 1,
+        .topic_len = strlen(topic_name),
+    };
+    // Store app actions associated with the subscription
+    app_subscription_entry sub_entry = {
+        .sub_properties = sub_properties,
+        .commands = {
+            { .command_name = "on", .callback = turn_on_led },
+            { .command_name = "off", .callback = turn_off_led },
+        },
+        .command_count = 2,
+        .payload_handler = apply_json_command,
+    };
+    int ret = mqtt_client_subscribe_to_topic(sub_properties, &packet_id, sock);
+    if (ret) return ret;
+    push(&subscription_list, &sub_entry);
+
+    // Frames are handled before subscription matching, and a late frame is worthless so QoS 0 is enough
+    subscribe_tuples frame_properties = {
+        .topic = FRAME_TOPIC,
+        .qos = 0,
+        .topic_len = strlen(FRAME_TOPIC),
+    };
+    ret = mqtt_client_subscribe_to_topic(frame_properties, &packet_id, sock);
+    if (ret) return ret;
+
+    subscribe_tuples delta_properties = {
+        .topic = DELTA_TOPIC,
+        .qos = 0,
+        .topic_len = strlen(DELTA_TOPIC),
+    };
+    ret = mqtt_client_subscribe_to_topic(delta_properties, &packet_id, sock);
+    if (ret) return ret;
+
+    // Clip uploads must arrive complete, they take the same fast path but at QoS 1
+    subscribe_tuples anim_properties = {
+        .topic = ANIM_TOPIC,
+        .qos = 1,
+        .topic_len = strlen(ANIM_TOPIC),
+    };
+    ret = mqtt_client_subscribe_to_topic(anim_properties, &packet_id, sock);
+    if (ret) return ret;
+
+    subscribe_tuples program_properties = {
+        .topic = PROGRAM_TOPIC,
+        .qos = 1,
+        .topic_len = strlen(PROGRAM_TOPIC),
+    };
+    ret = mqtt_client_subscribe_to_topic(program_properties, &packet_id, sock);
+    if (ret) return ret;
+
+    smart_led_reporter_config_t reporter_config = {
+        .window_ms = STATE_REPORT_WINDOW_MS,
+        .delta_updates = 0,
+        .keyframe_interval = 1,
+    };
+    if (smart_led_reporter_init(&reporter_config, topic_name, sock) != ESP_OK) {
+        ESP_LOGE(MQTT_TAG, "Failed to start the state reporter");
+    }
+    return 0;
+}
+
+
+/* Handles one complete packet that isn't on a streaming topic. Returns -1 if the connection should be dropped. */
+static int handle_broker_packet(uint8_t *buffer, size_t len, int sock, int msg_number) {
+    mqtt_packet packet = {0};
+    int ret = 0;
+
+    ESP_LOG_BUFFER_HEX_LEVEL(MQTT_TAG, buffer, len, ESP_LOG_DEBUG);
+
+    // Parse the message received from the client.
+    int packet_type = unpack(&packet, &buffer, len);  // Reconstruct bytestream as mqtt_packet and store in packet
+    if (msg_number == 0 && packet_type != MQTT_CONNACK) {
+        ESP_LOGE(MQTT_TAG, "Unexpected MQTT packet type. First packet from server MUST be MQTT_CONNACK, dropping connection...\n");
+        return -1;
+    }
+    if (msg_number > 0 && packet_type == MQTT_CONNACK) {
+        ESP_LOGE(MQTT_TAG, "Duplicate MQTT_CONNACK packet detected, dropping connection...\n");
+        return -1;
+    }
+
+    switch(packet_type) {
+        case MQTT_CONNACK: {
+            mqtt_connack connack = packet.type.connack;
+            if (connack.return_code != 0) {
+                ESP_LOGI(MQTT_TAG, "Connection rejected by the broker, return code = %d\n", connack.return_code);
+                return -1;
+            }
+            ESP_LOGI(MQTT_TAG, "Received CONNACK correctly, connection with broker validated.\n");
+            ret = subscribe_to_topics(sock);
+            break;
+        }
+        case MQTT_PUBLISH: {
+            mqtt_publish pub = packet.type.publish;
+            ret = mqtt_client_handle_publish(pub, subscription_list, sock);
+            break;
+        }
+        case MQTT_PUBACK: {
+            mqtt_puback puback = packet.type.puback;
+            ESP_LOGI(MQTT_TAG, "Puback packet ID: %d", puback.pkt_id);
+            break;
+        }
+        case MQTT_SUBACK: {
+            mqtt_suback suback = packet.type.suback;
+            for (int i = 0; i < suback.rc_len; ++i) {
+                ESP_LOGI(MQTT_TAG, "Suback%d return code = %02X\n", i, suback.return_codes[i]);
+            }
+            free(suback.return_codes);
+            break;
+        }
+        case MQTT_PINGRESP: {
+            break;
+        }
+        default:
+            ESP_LOGE(MQTT_TAG, "Encountered error while parsing server message!\n");
+            break;
+    }
+    free_packet(&packet);
+    return ret ? -1 : 0;
+}
+
+
 void process_broker_messages(void *arg) {
     int sock = *(int *)arg;
-    int msg_number = 0;
-    uint16_t packet_id = 1;     // Packet ID 0 is not allowed
+    smart_led_mqtt_rx_init(sock, handle_broker_packet);
 
     while (1) {
-        mqtt_packet packet = {0};
-        uint8_t *original_buffer = malloc(DEFAULT_BUFF_SIZE);
-        if (!original_buffer) vTaskDelete(NULL);;
-        uint8_t *buffer = original_buffer;
-
-        int bytes_read = read(sock, buffer, DEFAULT_BUFF_SIZE);
+        size_t space;
+        uint8_t *rx_space = smart_led_mqtt_rx_space(&space);
+        int bytes_read = read(sock, rx_space, space);
         if (bytes_read <= 0) {
             ESP_LOGE(MQTT_TAG, "bytes read = %d\n", bytes_read);
             ESP_LOGE(MQTT_TAG, "Server communication channel closed!");
-            free(original_buffer);
             vTaskDelete(NULL);;
         }
-        ESP_LOGI(MQTT_TAG, "Buffer Size = %d\n", bytes_read);
-        for (int i = 0; i < bytes_read; ++i) {
-            ESP_LOGI(MQTT_TAG, "%02X\n", buffer[i]);
-        }
+        ESP_LOGD(MQTT_TAG, "Buffer Size = %d\n", bytes_read);
 
-        // Parse the message received from the client.
-        int packet_type = unpack(&packet, &buffer, bytes_read);  // Reconstruct bytestream as mqtt_packet and store in packet
-        if (msg_number == 0 && packet_type != MQTT_CONNACK) {
-            ESP_LOGE(MQTT_TAG, "Unexpected MQTT packet type. First packet from server MUST be MQTT_CONNACK, dropping connection...\n");
-            vTaskDelete(NULL);;
-        }
-        if (msg_number > 0 && packet_type == MQTT_CONNACK) {
-            ESP_LOGE(MQTT_TAG, "Duplicate MQTT_CONNACK packet detected, dropping connection...\n");
+        if (smart_led_mqtt_rx_received(bytes_read)) {
             vTaskDelete(NULL);;
         }
-
-        switch(packet_type) {
-            case MQTT_CONNACK: {
-                mqtt_connack connack = packet.type.connack;
-                if (connack.return_code != 0) {
-                    ESP_LOGI(MQTT_TAG, "Connection rejected by the broker, return code = %d\n", connack.return_code);
-                    vTaskDelete(NULL);;
-                }
-                ESP_LOGI(MQTT_TAG, "Received CONNACK correctly, connection with broker validated.\n");
-                
-                // Pack and send subscribe request
-                char *topic_name = "home/chris/smart_led";
-                subscribe_tuples sub_properties = {
-                    .topic = topic_name,
-                    .qos = 1,
-                    .topic_len = strlen(topic_name),
-                };
-                // Store app actions associated with the subscription
-                app_subscription_entry sub_entry = {
-                    .sub_properties = sub_properties,
-                    .commands = {
-                        { .command_name = "on", .callback = turn_on_led },
-                        { .command_name = "off", .callback = turn_off_led },
-                    },
-                    .command_count = 2,
-                };
-                int ret = mqtt_client_subscribe_to_topic(sub_properties, &packet_id, sock);
-                if (ret) vTaskDelete(NULL);;
-                push(&subscription_list, &sub_entry);
-                break;
-            }
-            case MQTT_PUBLISH: {
-                mqtt_publish pub = packet.type.publish;
-                int err = mqtt_client_handle_publish(pub, subscription_list, sock);
-                if (err) vTaskDelete(NULL);;
-                break;
-            }
-            case MQTT_PUBACK: {
-                mqtt_puback puback = packet.type.puback;
-                ESP_LOGI(MQTT_TAG, "Puback packet ID: %d", puback.pkt_id);
-                break;
-            }
-            case MQTT_SUBACK: {
-                mqtt_suback suback = packet.type.suback;
-                for (int i = 0; i < suback.rc_len; ++i) {
-                    ESP_LOGI(MQTT_TAG, "Suback%d return code = %02X\n", i, suback.return_codes[i]);
-                }
-                break;
-            }
-            case MQTT_PINGRESP: {
-                break;
-            }
-            default:
-                ESP_LOGE(MQTT_TAG, "Encountered error while parsing server message!\n");
-                break;
-        }
-        ++msg_number;
-        free(original_buffer);
     }
 }
 
@@ -0,0 +1,199 @@
+#include <string.h>
+#include <inttypes.h>
+
+#include "esp_log.h"
+
+#include "smart_led_mqtt_rx.h"
+#include "led_frame_buffer.h"
+#include "led_frame_codec.h"
+#include "led_anim_cache.h"
+#include "led_effect.h"
+#include "../../components/mqtt_protocl_lib/include/mqtt_parser.h"
+#include "../../components/mqtt_protocl_lib/include/mqtt_protocol.h"
+#include "../../components/mqtt_protocl_lib/include/mqtt_client_api.h"
+
+
+#define MQTT_TAG        "MQTT"
+
+
+// Frame commits switch the render loop over to streamed frames
+extern void stream_frame_received(void);
+
+static uint8_t rx_buffer[MQTT_RX_BUFF_SIZE];
+static size_t rx_len = 0;
+static size_t skip_len = 0;     // Rest of an oversized packet, read and thrown away
+static int msg_number = 0;
+static int rx_sock = -1;
+static smart_led_mqtt_packet_handler_t packet_handler = NULL;
+
+
+/* Writes a raw RGB frame straight from the receive buffer into the render back buffer */
+static int handle_frame_publish(mqtt_publish *pub, int sock) {
+    if (pub->payload_len > LED_FRAME_BYTES) {
+        ESP_LOGE(MQTT_TAG, "Dropping frame of %" PRIu32 " bytes, strip holds %d", pub->payload_len, LED_FRAME_BYTES);
+    } else {
+        uint8_t *back = led_fb_begin_write();
+        memcpy(back, pub->payload, pub->payload_len);
+        memset(back + pub->payload_len, 0, LED_FRAME_BYTES - pub->payload_len);   // Short frames blank the tail
+        led_fb_end_write(true);
+        stream_frame_received();
+    }
+
+    if (pub->pkt_id == 0) return 0;
+    return mqtt_client_send_puback(pub->pkt_id, sock);
+}
+
+
+/* Applies an encoded (led_frame_codec) frame onto the newest frame */
+static int handle_delta_publish(mqtt_publish *pub, int sock) {
+    uint8_t *back = led_fb_begin_update();
+    esp_err_t ret = led_frame_decode((const uint8_t *)pub->payload, pub->payload_len, back, LED_FRAME_BYTES);
+    led_fb_end_write(ret == ESP_OK);
+    if (ret == ESP_OK) {
+        stream_frame_received();
+    } else {
+        ESP_LOGE(MQTT_TAG, "Dropping malformed encoded frame of %" PRIu32 " bytes", pub->payload_len);
+    }
+
+    if (pub->pkt_id == 0) return 0;
+    return mqtt_client_send_puback(pub->pkt_id, sock);
+}
+
+
+/* Stores a chunk of an animation clip or controls playback */
+static int handle_anim_publish(mqtt_publish *pub, int sock) {
+    esp_err_t ret = led_anim_handle_message((const uint8_t *)pub->payload, pub->payload_len);
+    if (ret != ESP_OK) {
+        ESP_LOGE(MQTT_TAG, "Animation message rejected: %s", esp_err_to_name(ret));
+
+        // Tells the uploader which message failed and where to resume (see led_anim_cache.h)
+        uint32_t written = led_anim_upload_written();
+        char status[ANIM_STATUS_LEN] = {
+            pub->payload_len > 0 ? pub->payload[0] : 0, pub->payload_len > 1 ? pub->payload[1] : 0,
+            (uint32_t)ret >> 24, (uint32_t)ret >> 16, (uint32_t)ret >> 8, (uint32_t)ret,
+            written >> 24, written >> 16, written >> 8, written,
+        };
+        mqtt_publish status_pub = {
+            .topic = ANIM_STATUS_TOPIC,
+            .topic_len = strlen(ANIM_STATUS_TOPIC),
+            .payload = status,
+            .payload_len = sizeof(status),
+        };
+        if (publish(status_pub, PUBLISH_QOS_0, sock) < 0) return -1;
+    }
+
+    if (pub->pkt_id == 0) return 0;
+    return mqtt_client_send_puback(pub->pkt_id, sock);
+}
+
+
+/* Loads an effect program (led_vm) */
+static int handle_program_publish(mqtt_publish *pub, int sock) {
+    esp_err_t ret = led_effect_load_program((const uint8_t *)pub->payload, pub->payload_len);
+    if (ret != ESP_OK) {
+        ESP_LOGE(MQTT_TAG, "Effect program rejected: %s", esp_err_to_name(ret));
+    }
+
+    if (pub->pkt_id == 0) return 0;
+    return mqtt_client_send_puback(pub->pkt_id, sock);
+}
+
+
+/* Returns 1 if the packet was a frame and has been consumed, 0 if it needs the generic path, -1 on error */
+static int try_handle_frame(uint8_t *buffer, size_t len, int sock) {
+    mqtt_header header = { .fixed_header = buffer[0] };
+    mqtt_publish pub = {0};
+    int accumulated_size = 1;
+    uint8_t *cursor = buffer + 1;
+
+    if ((header.fixed_header & TYPE_MASK) != PUBLISH_TYPE) return 0;
+    header.remaining_length = decode_remaining_length(&cursor, &accumulated_size);
+    if (peek_publish(&pub, header, &cursor, len, accumulated_size) != MQTT_PUBLISH) return 0;
+    if (pub.topic_len == strlen(FRAME_TOPIC) && !memcmp(pub.topic, FRAME_TOPIC, pub.topic_len)) {
+        return handle_frame_publish(&pub, sock) ? -1 : 1;
+    }
+    if (pub.topic_len == strlen(DELTA_TOPIC) && !memcmp(pub.topic, DELTA_TOPIC, pub.topic_len)) {
+        return handle_delta_publish(&pub, sock) ? -1 : 1;
+    }
+    if (pub.topic_len == strlen(ANIM_TOPIC) && !memcmp(pub.topic, ANIM_TOPIC, pub.topic_len)) {
+        return handle_anim_publish(&pub, sock) ? -1 : 1;
+    }
+    if (pub.topic_len == strlen(PROGRAM_TOPIC) && !memcmp(pub.topic, PROGRAM_TOPIC, pub.topic_len)) {
+        return handle_program_publish(&pub, sock) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+/* Acknowledges a QoS 1 publish that is skipped for its size, so that the broker doesn't redeliver it forever.
+ * Only the start of the packet is in `buffer`: peek_publish fails on the payload, after reading the packet ID. */
+static void acknowledge_skipped(uint8_t *buffer, size_t len, int sock) {
+    mqtt_header header = { .fixed_header = buffer[0] };
+    mqtt_publish pub = {0};
+    int accumulated_size = 1;
+    uint8_t *cursor = buffer + 1;
+
+    if ((header.fixed_header & TYPE_MASK) != PUBLISH_TYPE) return;
+    header.remaining_length = decode_remaining_length(&cursor, &accumulated_size);
+    peek_publish(&pub, header, &cursor, len, accumulated_size);
+    if (pub.pkt_id) mqtt_client_send_puback(pub.pkt_id, sock);
+}
+
+
+void smart_led_mqtt_rx_init(int sock, smart_led_mqtt_packet_handler_t handler) {
+    rx_sock = sock;
+    packet_handler = handler;
+    rx_len = 0;
+    skip_len = 0;
+    msg_number = 0;
+}
+
+
+uint8_t *smart_led_mqtt_rx_space(size_t *len) {
+    *len = MQTT_RX_BUFF_SIZE - rx_len;
+    return rx_buffer + rx_len;
+}
+
+
+int smart_led_mqtt_rx_received(size_t bytes_read) {
+    rx_len += bytes_read;
+
+    if (skip_len) {
+        size_t skipped = skip_len < rx_len ? skip_len : rx_len;
+        memmove(rx_buffer, rx_buffer + skipped, rx_len - skipped);
+        rx_len -= skipped;
+        skip_len -= skipped;
+    }
+
+    // TCP is a stream: a single read may hold several packets, or only part of one
+    size_t offset = 0;
+    while (offset < rx_len) {
+        int packet_len = peek_packet_length(rx_buffer + offset, rx_len - offset);
+        if (packet_len < 0) {
+            ESP_LOGE(MQTT_TAG, "Malformed packet, dropping connection...");
+            return -1;
+        }
+        if (packet_len > MQTT_RX_BUFF_SIZE) {
+            // E.g. a large retained message on a subscribed topic: not ours to handle, but no reason to disconnect
+            ESP_LOGW(MQTT_TAG, "Skipping packet of %d bytes, larger than the receive buffer", packet_len);
+            acknowledge_skipped(rx_buffer + offset, rx_len - offset, rx_sock);
+            skip_len = packet_len - (rx_len - offset);
+            offset = rx_len;
+            ++msg_number;
+            break;
+        }
+        if (packet_len == 0 || (size_t)packet_len > rx_len - offset) break;   // Wait for the rest
+
+        // Streaming topics take a zero-copy path straight into their modules, the first packet is the CONNACK
+        int handled = msg_number > 0 ? try_handle_frame(rx_buffer + offset, packet_len, rx_sock) : 0;
+        if (handled < 0) return -1;
+        if (!handled && packet_handler(rx_buffer + offset, packet_len, rx_sock, msg_number)) return -1;
+        ++msg_number;
+        offset += packet_len;
+    }
+
+    // Keep the incomplete tail for the next read
+    memmove(rx_buffer, rx_buffer + offset, rx_len - offset);
+    rx_len -= offset;
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "esp_log.h"
+
+#include "smart_led_reporter.h"
+#include "smart_led_state.h"
+#include "led_effect.h"
+#include "led_render_parallel.h"
+#include "../../components/mqtt_protocl_lib/include/mqtt_parser.h"
+#include "../../components/mqtt_protocl_lib/include/mqtt_client_api.h"
+
+
+#define REPORTER_TAG            "STATE_REPORT"
+#define MAX_STATE_TOPIC_LEN     96
+#define MAX_STATE_PAYLOAD_LEN   176
+#define REPORT_TASK_PRIORITY    5       // Below the network tasks, a state report can wait
+
+
+static smart_led_reporter_config_t reporter_config;
+static smart_led_reporter_stats_t reporter_stats;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TimerHandle_t window_timer = NULL;
+static TaskHandle_t report_task = NULL;
+static char state_topic[MAX_STATE_TOPIC_LEN];
+static int broker_sock = -1;
+
+static smart_led_state_t last_published;
+static bool has_published = false;
+static uint32_t publishes_since_keyframe = 0;
+
+
+/* Whether `a` and `b` differ in a field the state topic carries; the mode, for one, is not reported */
+static bool reported_fields_differ(const smart_led_state_t *a, const smart_led_state_t *b) {
+    return a->on != b->on || a->brightness != b->brightness || a->red != b->red || a->green != b->green ||
+           a->blue != b->blue || a->effect != b->effect || strcmp(a->text, b->text);
+}
+
+
+/* Appends to the `len` bytes in `buf`. Once the output is truncated, len stays at the end of the buffer. */
+static int append(char *buf, size_t buf_len, int len, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buf + len, buf_len - len, format, args);
+    va_end(args);
+
+    if (written < 0) return len;
+    return (size_t)(len + written) < buf_len ? len + written : (int)buf_len - 1;
+}
+
+
+/* Serializes the fields of `state` that differ from `prev` (all fields if prev is NULL). */
+static int serialize_state(char *buf, size_t buf_len, const smart_led_state_t *state, const smart_led_state_t *prev) {
+    int len = append(buf, buf_len, 0, "{");
+    const char *sep = "";
+
+    if (!prev || prev->on != state->on) {
+        len = append(buf, buf_len, len, "%s\"state\":\"%s\"", sep, state->on ? "ON" : "OFF");
+        sep = ",";
+    }
+    if (!prev || prev->brightness != state->brightness) {
+        len = append(buf, buf_len, len, "%s\"brightness\":%d", sep, state->brightness);
+        sep = ",";
+    }
+    if (!prev || prev->red != state->red || prev->green != state->green || prev->blue != state->blue) {
+        len = append(buf, buf_len, len, "%s\"color\":{\"r\":%d,\"g\":%d,\"b\":%d}",
+                     sep, state->red, state->green, state->blue);
+        sep = ",";
+    }
+    if (!prev || prev->effect != state->effect) {
+        len = append(buf, buf_len, len, "%s\"effect\":\"%s\"", sep, led_effect_name(state->effect));
+        sep = ",";
+    }
+    if (!prev || strcmp(prev->text, state->text)) {
+        // Stored as received, so it is still valid JSON string content
+        len = append(buf, buf_len, len, "%s\"text\":\"%s\"", sep, state->text);
+    }
+    return append(buf, buf_len, len, "}");
+}
+
+
+/* Size of a QoS 0 PUBLISH packet on the wire */
+static uint32_t publish_packet_size(size_t topic_len, size_t payload_len) {
+    uint8_t remaining_len_bytes[4];
+    size_t remaining_len = sizeof(uint16_t) + topic_len + payload_len;
+    return 1 + encode_remaining_length(remaining_len, remaining_len_bytes) + remaining_len;
+}
+
+
+/* Runs in the report task. The socket is shared with the broker task, publish() serializes the writes. */
+static void report_state(void) {
+    smart_led_state_t state = led_state_snapshot();
+    char payload[MAX_STATE_PAYLOAD_LEN];
+
+    if (has_published && !reported_fields_differ(&state, &last_published)) {
+        portENTER_CRITICAL(&stats_lock);
+        ++reporter_stats.suppressed;
+        portEXIT_CRITICAL(&stats_lock);
+        return;
+    }
+
+    bool keyframe = !has_published || !reporter_config.delta_updates ||
+                    publishes_since_keyframe + 1 >= reporter_config.keyframe_interval;
+    int payload_len = serialize_state(payload, sizeof(payload), &state, keyframe ? NULL : &last_published);
+
+    mqtt_publish pub = {
+        .topic = state_topic,
+        .topic_len = strlen(state_topic),
+        .payload = payload,
+        .payload_len = payload_len,
+    };
+    // Deltas are not retained so that late subscribers always get a complete state
+    int sent = publish(pub, PUBLISH_QOS_0 | (keyframe ? PUBLISH_RETAIN_FLAG : 0), broker_sock);
+    if (sent < 0) {
+        ESP_LOGE(REPORTER_TAG, "Failed publishing state");
+        return;     // Keep last_published so the next change retries the full diff
+    }
+
+    last_published = state;
+    has_published = true;
+    publishes_since_keyframe = keyframe ? 0 : publishes_since_keyframe + 1;
+
+    portENTER_CRITICAL(&stats_lock);
+    ++reporter_stats.publishes;
+    reporter_stats.bytes_sent += sent;
+    portEXIT_CRITICAL(&stats_lock);
+    ESP_LOGI(REPORTER_TAG, "Published %s state (%d bytes)", keyframe ? "full" : "delta", sent);
+}
+
+
+static void report_states(void *arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        report_state();
+    }
+}
+
+
+/* Runs in the timer service task, which all software timers share. Publishing is left to the report task. */
+static void window_closed(TimerHandle_t xTimer) {
+    xTaskNotifyGive(report_task);
+}
+
+
+esp_err_t smart_led_reporter_init(const smart_led_reporter_config_t *config, const char *base_topic, int sock) {
+    if (!config || !base_topic || sock < 0) return ESP_ERR_INVALID_ARG;
+    if (strlen(base_topic) + strlen(STATE_TOPIC_SUFFIX) >= sizeof(state_topic)) return ESP_ERR_INVALID_ARG;
+
+    reporter_config = *config;
+    if (reporter_config.keyframe_interval == 0) reporter_config.keyframe_interval = 1;
+    snprintf(state_topic, sizeof(state_topic), "%s%s", base_topic, STATE_TOPIC_SUFFIX);
+    broker_sock = sock;
+    has_published = false;
+
+    if (!report_task && xTaskCreatePinnedToCore(report_states, "State reporter", 3072, NULL, REPORT_TASK_PRIORITY,
+                                                &report_task, LED_NET_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    TickType_t window_ticks = pdMS_TO_TICKS(config->window_ms);
+    if (window_ticks == 0) window_ticks = 1;
+    if (!window_timer) {
+        window_timer = xTimerCreate("state_report", window_ticks, pdFALSE, NULL, window_closed);
+        if (!window_timer) return ESP_ERR_NO_MEM;
+    } else {
+        xTimerChangePeriod(window_timer, window_ticks, 0);
+    }
+
+    // Publish the initial state right away
+    xTimerStart(window_timer, 0);
+    return ESP_OK;
+}
+
+
+void smart_led_reporter_notify(void) {
+    if (!window_timer) return;
+
+    // Account for what publishing this change on its own would have cost
+    char payload[MAX_STATE_PAYLOAD_LEN];
+    smart_led_state_t state = led_state_snapshot();
+    int payload_len = serialize_state(payload, sizeof(payload), &state, NULL);
+    uint32_t naive_bytes = publish_packet_size(strlen(state_topic), payload_len);
+
+    portENTER_CRITICAL(&stats_lock);
+    ++reporter_stats.notifications;
+    reporter_stats.bytes_naive += naive_bytes;
+    portEXIT_CRITICAL(&stats_lock);
+
+    // A running timer means a window is already open; this change will be picked up when it closes
+    if (!xTimerIsTimerActive(window_timer)) {
+        xTimerStart(window_timer, 0);
+    }
+}
+
+
+smart_led_reporter_stats_t smart_led_reporter_get_stats(void) {
+    portENTER_CRITICAL(&stats_lock);
+    smart_led_reporter_stats_t stats = reporter_stats;
+    portEXIT_CRITICAL(&stats_lock);
+    return stats;
+}
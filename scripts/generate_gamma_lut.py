@@ -0,0 +1,33 @@
+import sys
+
+# Usage: generate_gamma_lut.py <output header> <gamma> [<gamma> ...]
+#
+# Emits one 256 entry table per gamma curve, linear (1.0) always first. Entries are 8.8 fixed point so the
+# fraction below one output step survives for temporal dithering.
+
+output_path = sys.argv[1]
+gammas = [1.0] + [float(g) for g in sys.argv[2:] if float(g) != 1.0]
+
+def curve(gamma):
+    return [round(((i / 255) ** gamma) * 255 * 256) for i in range(256)]
+
+def generate_header(output_path):
+    with open(output_path, 'w') as f:
+        f.write("// Auto-generated by scripts/generate_gamma_lut.py\n\n")
+        f.write("#pragma once\n\n#include <stdint.h>\n\n")
+        f.write(f"#define LED_GAMMA_CURVE_COUNT {len(gammas)}\n\n")
+        f.write("static const char *const led_gamma_names[LED_GAMMA_CURVE_COUNT] = {\n")
+        for gamma in gammas:
+            f.write(f"    \"{gamma}\",\n")
+        f.write("};\n\n")
+        f.write("static const uint16_t led_gamma_tables[LED_GAMMA_CURVE_COUNT][256] = {\n")
+        for gamma in gammas:
+            values = curve(gamma)
+            f.write(f"    {{   // {gamma}\n")
+            for row in range(0, 256, 12):
+                f.write("        " + ", ".join(f"{v:5d}" for v in values[row:row + 12]) + ",\n")
+            f.write("    },\n")
+        f.write("};\n")
+
+generate_header(output_path)
+print(f"Generated gamma tables at {output_path}")
@@ -0,0 +1,159 @@
+import sys
+
+# Usage: generate_glyph_atlas.py <output header>
+#
+# Rasterizes the text font and the icon sprites into one table of 8 pixel high columns (bit 0 is the top row),
+# so drawing text on the device is a copy of a few bytes per glyph. Glyphs are cropped to their inked columns
+# and spaced at draw time, which makes the text proportional and the table smaller.
+
+output_path = sys.argv[1]
+
+# Classic 5x7 column font (descenders use the 8th row), printable ASCII from ' '
+FONT_FIRST = 0x20
+FONT = [
+    (0x00, 0x00, 0x00, 0x00, 0x00), (0x00, 0x00, 0x5F, 0x00, 0x00), (0x00, 0x07, 0x00, 0x07, 0x00),
+    (0x14, 0x7F, 0x14, 0x7F, 0x14), (0x24, 0x2A, 0x7F, 0x2A, 0x12), (0x23, 0x13, 0x08, 0x64, 0x62),
+    (0x36, 0x49, 0x56, 0x20, 0x50), (0x00, 0x08, 0x07, 0x03, 0x00), (0x00, 0x1C, 0x22, 0x41, 0x00),
+    (0x00, 0x41, 0x22, 0x1C, 0x00), (0x2A, 0x1C, 0x7F, 0x1C, 0x2A), (0x08, 0x08, 0x3E, 0x08, 0x08),
+    (0x00, 0x80, 0x70, 0x30, 0x00), (0x08, 0x08, 0x08, 0x08, 0x08), (0x00, 0x00, 0x60, 0x60, 0x00),
+    (0x20, 0x10, 0x08, 0x04, 0x02), (0x3E, 0x51, 0x49, 0x45, 0x3E), (0x00, 0x42, 0x7F, 0x40, 0x00),
+    (0x72, 0x49, 0x49, 0x49, 0x46), (0x21, 0x41, 0x49, 0x4D, 0x33), (0x18, 0x14, 0x12, 0x7F, 0x10),
+    (0x27, 0x45, 0x45, 0x45, 0x39), (0x3C, 0x4A, 0x49, 0x49, 0x31), (0x41, 0x21, 0x11, 0x09, 0x07),
+    (0x36, 0x49, 0x49, 0x49, 0x36), (0x46, 0x49, 0x49, 0x29, 0x1E), (0x00, 0x00, 0x14, 0x00, 0x00),
+    (0x00, 0x40, 0x34, 0x00, 0x00), (0x00, 0x08, 0x14, 0x22, 0x41), (0x14, 0x14, 0x14, 0x14, 0x14),
+    (0x00, 0x41, 0x22, 0x14, 0x08), (0x02, 0x01, 0x59, 0x09, 0x06), (0x3E, 0x41, 0x5D, 0x59, 0x4E),
+    (0x7C, 0x12, 0x11, 0x12, 0x7C), (0x7F, 0x49, 0x49, 0x49, 0x36), (0x3E, 0x41, 0x41, 0x41, 0x22),
+    (0x7F, 0x41, 0x41, 0x41, 0x3E), (0x7F, 0x49, 0x49, 0x49, 0x41), (0x7F, 0x09, 0x09, 0x09, 0x01),
+    (0x3E, 0x41, 0x41, 0x51, 0x73), (0x7F, 0x08, 0x08, 0x08, 0x7F), (0x00, 0x41, 0x7F, 0x41, 0x00),
+    (0x20, 0x40, 0x41, 0x3F, 0x01), (0x7F, 0x08, 0x14, 0x22, 0x41), (0x7F, 0x40, 0x40, 0x40, 0x40),
+    (0x7F, 0x02, 0x1C, 0x02, 0x7F), (0x7F, 0x04, 0x08, 0x10, 0x7F), (0x3E, 0x41, 0x41, 0x41, 0x3E),
+    (0x7F, 0x09, 0x09, 0x09, 0x06), (0x3E, 0x41, 0x51, 0x21, 0x5E), (0x7F, 0x09, 0x19, 0x29, 0x46),
+    (0x26, 0x49, 0x49, 0x49, 0x32), (0x03, 0x01, 0x7F, 0x01, 0x03), (0x3F, 0x40, 0x40, 0x40, 0x3F),
+    (0x1F, 0x20, 0x40, 0x20, 0x1F), (0x3F, 0x40, 0x38, 0x40, 0x3F), (0x63, 0x14, 0x08, 0x14, 0x63),
+    (0x03, 0x04, 0x78, 0x04, 0x03), (0x61, 0x59, 0x49, 0x4D, 0x43), (0x00, 0x7F, 0x41, 0x41, 0x41),
+    (0x02, 0x04, 0x08, 0x10, 0x20), (0x00, 0x41, 0x41, 0x41, 0x7F), (0x04, 0x02, 0x01, 0x02, 0x04),
+    (0x40, 0x40, 0x40, 0x40, 0x40), (0x00, 0x03, 0x07, 0x08, 0x00), (0x20, 0x54, 0x54, 0x78, 0x40),
+    (0x7F, 0x28, 0x44, 0x44, 0x38), (0x38, 0x44, 0x44, 0x44, 0x28), (0x38, 0x44, 0x44, 0x28, 0x7F),
+    (0x38, 0x54, 0x54, 0x54, 0x18), (0x00, 0x08, 0x7E, 0x09, 0x02), (0x18, 0xA4, 0xA4, 0x9C, 0x78),
+    (0x7F, 0x08, 0x04, 0x04, 0x78), (0x00, 0x44, 0x7D, 0x40, 0x00), (0x20, 0x40, 0x40, 0x3D, 0x00),
+    (0x7F, 0x10, 0x28, 0x44, 0x00), (0x00, 0x41, 0x7F, 0x40, 0x00), (0x7C, 0x04, 0x78, 0x04, 0x78),
+    (0x7C, 0x08, 0x04, 0x04, 0x78), (0x38, 0x44, 0x44, 0x44, 0x38), (0xFC, 0x18, 0x24, 0x24, 0x18),
+    (0x18, 0x24, 0x24, 0x18, 0xFC), (0x7C, 0x08, 0x04, 0x04, 0x08), (0x48, 0x54, 0x54, 0x54, 0x24),
+    (0x04, 0x04, 0x3F, 0x44, 0x24), (0x3C, 0x40, 0x40, 0x20, 0x7C), (0x1C, 0x20, 0x40, 0x20, 0x1C),
+    (0x3C, 0x40, 0x30, 0x40, 0x3C), (0x44, 0x28, 0x10, 0x28, 0x44), (0x4C, 0x90, 0x90, 0x90, 0x7C),
+    (0x44, 0x64, 0x54, 0x4C, 0x44), (0x00, 0x08, 0x36, 0x41, 0x00), (0x00, 0x00, 0x77, 0x00, 0x00),
+    (0x00, 0x41, 0x36, 0x08, 0x00), (0x02, 0x01, 0x02, 0x04, 0x02),
+]
+SPACE_WIDTH = 3     # The only glyph without ink
+
+# Icons, drawn row by row ('#' is set)
+SPRITES = {
+    "wifi": [
+        "..#####..",
+        ".#.....#.",
+        "#..###..#",
+        "..#...#..",
+        "....#....",
+        "...###...",
+        "....#....",
+        ".........",
+    ],
+    "alert": [
+        "...#...",
+        "..###..",
+        "..#.#..",
+        ".##.##.",
+        ".#####.",
+        "###.###",
+        "#######",
+        ".......",
+    ],
+    "clock": [
+        "..###..",
+        ".#.#.#.",
+        "#..#..#",
+        "#..##.#",
+        "#.....#",
+        ".#...#.",
+        "..###..",
+        ".......",
+    ],
+    "check": [
+        "......#",
+        ".....##",
+        "#...##.",
+        "##.##..",
+        ".###...",
+        "..#....",
+        ".......",
+        ".......",
+    ],
+    "heart": [
+        ".##.##.",
+        "#######",
+        "#######",
+        ".#####.",
+        "..###..",
+        "...#...",
+        ".......",
+        ".......",
+    ],
+}
+
+def crop(columns):
+    while columns and columns[0] == 0:
+        columns = columns[1:]
+    while columns and columns[-1] == 0:
+        columns = columns[:-1]
+    return columns
+
+def rasterize(rows):
+    if len(rows) != 8 or len({len(row) for row in rows}) != 1:
+        sys.exit("sprites must be 8 rows of equal width")
+    return [sum(1 << y for y, row in enumerate(rows) if row[x] == "#") for x in range(len(rows[0]))]
+
+def generate_header(output_path):
+    columns = []
+    glyphs = []
+    for code, glyph in enumerate(FONT):
+        inked = crop(list(glyph))
+        if not inked:
+            inked = [0] * SPACE_WIDTH
+        glyphs.append((len(columns), len(inked), chr(FONT_FIRST + code)))
+        columns.extend(inked)
+    sprites = []
+    for name, rows in SPRITES.items():
+        sprites.append((len(columns), len(rows[0]), name))
+        columns.extend(rasterize(rows))
+    if len(columns) > 65535:
+        sys.exit("atlas too large for 16 bit offsets")
+
+    with open(output_path, 'w') as f:
+        f.write("// Auto-generated by scripts/generate_glyph_atlas.py\n\n")
+        f.write("#pragma once\n\n#include <stdint.h>\n\n")
+        f.write(f"#define LED_ATLAS_GLYPH_FIRST {FONT_FIRST}\n")
+        f.write(f"#define LED_ATLAS_GLYPH_COUNT {len(glyphs)}\n")
+        f.write(f"#define LED_ATLAS_SPRITE_COUNT {len(sprites)}\n\n")
+        f.write("// One byte per column, bit 0 is the top row\n")
+        f.write(f"static const uint8_t led_atlas_columns[{len(columns)}] = {{\n")
+        for row in range(0, len(columns), 16):
+            f.write("    " + " ".join(f"0x{c:02X}," for c in columns[row:row + 16]) + "\n")
+        f.write("};\n\n")
+        f.write("// First column and width of every glyph, then of every sprite\n")
+        f.write("static const uint16_t led_atlas_glyph_offsets[LED_ATLAS_GLYPH_COUNT] = {\n")
+        for offset, _, char in glyphs:
+            f.write(f"    {offset:4d},     // {char!r}\n")
+        f.write("};\n\n")
+        f.write("static const uint8_t led_atlas_glyph_widths[LED_ATLAS_GLYPH_COUNT] = {\n")
+        for row in range(0, len(glyphs), 16):
+            f.write("    " + " ".join(f"{w}," for _, w, _ in glyphs[row:row + 16]) + "\n")
+        f.write("};\n\n")
+        f.write("static const struct {\n    const char *name;\n    uint16_t offset;\n    uint8_t width;\n"
+                "} led_atlas_sprites[LED_ATLAS_SPRITE_COUNT] = {\n")
+        for offset, width, name in sprites:
+            f.write(f"    {{ \"{name}\", {offset}, {width} }},\n")
+        f.write("};\n")
+    return len(columns)
+
+size = generate_header(output_path)
+print(f"Generated glyph atlas with {len(FONT)} glyphs and {len(SPRITES)} sprites ({size} columns) at {output_path}")
@@ -0,0 +1,41 @@
+import os
+import sys
+
+# Usage: generate_pixel_map.py <output header> <pixel map csv>
+#
+# The csv lists the logical "x,y" position of every physical LED, in wiring order, one per line ('#' starts a
+# comment). Without a csv the header only defines a count of 0 and the custom layout is unavailable.
+
+output_path = sys.argv[1]
+csv_path = sys.argv[2]
+
+def parse_csv(csv_path):
+    coords = []
+    if not os.path.exists(csv_path):
+        return coords
+    with open(csv_path, 'r') as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            x, y = (int(v) for v in line.split(","))
+            if not (0 <= x < 65536 and 0 <= y < 65536):
+                sys.exit(f"{csv_path}:{number}: coordinate out of range")
+            coords.append((x, y))
+    return coords
+
+def generate_header(coords, output_path):
+    with open(output_path, 'w') as f:
+        f.write("// Auto-generated by scripts/generate_pixel_map.py\n\n")
+        f.write("#pragma once\n\n#include <stdint.h>\n\n")
+        f.write(f"#define LED_PIXEL_MAP_CUSTOM_COUNT {len(coords)}\n\n")
+        if not coords:
+            return
+        f.write("static const uint16_t led_pixel_map_custom[LED_PIXEL_MAP_CUSTOM_COUNT][2] = {\n")
+        for row in range(0, len(coords), 8):
+            f.write("    " + " ".join(f"{{{x:3d}, {y:3d}}}," for x, y in coords[row:row + 8]) + "\n")
+        f.write("};\n")
+
+coords = parse_csv(csv_path)
+generate_header(coords, output_path)
+print(f"Generated pixel map with {len(coords)} entries at {output_path}")
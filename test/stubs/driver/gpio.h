@@ -0,0 +1,8 @@
+#ifndef GPIO_H
+#define GPIO_H
+
+/* Host stand-in: led_strip_output.h only needs the pin type */
+
+typedef int gpio_num_t;
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef RMT_ENCODER_H
+#define RMT_ENCODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* Host stand-in for the RMT encoder API. The simple encoder (rmt_host.c) runs a whole transaction per encode
+ * call, handing its callback the free channel memory the way the refill interrupt would. */
+
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_symbol_word_t;
+
+typedef struct rmt_channel_t *rmt_channel_handle_t;
+
+typedef enum {
+    RMT_ENCODING_RESET = 0,
+    RMT_ENCODING_COMPLETE = (1 << 0),
+    RMT_ENCODING_MEM_FULL = (1 << 1),
+} rmt_encode_state_t;
+
+typedef struct rmt_encoder_t rmt_encoder_t;
+struct rmt_encoder_t {
+    size_t (*encode)(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data,
+                     size_t data_size, rmt_encode_state_t *ret_state);
+    esp_err_t (*reset)(rmt_encoder_t *encoder);
+    esp_err_t (*del)(rmt_encoder_t *encoder);
+};
+typedef rmt_encoder_t *rmt_encoder_handle_t;
+
+typedef size_t (*rmt_encode_simple_cb_t)(const void *data, size_t data_size, size_t symbols_written,
+                                         size_t symbols_free, rmt_symbol_word_t *symbols, bool *done, void *arg);
+
+typedef struct {
+    rmt_encode_simple_cb_t callback;
+    void *arg;
+    size_t min_chunk_size;
+} rmt_simple_encoder_config_t;
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder);
+esp_err_t rmt_encoder_reset(rmt_encoder_handle_t encoder);
+void *rmt_alloc_encoder_mem(size_t size);
+
+#ifndef __containerof
+#define __containerof(ptr, type, member)    ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+/**
+ * @brief Symbols the refill interrupt frees at a time, 64 (a channel's memory block) by default. Free space
+ *        the callback leaves carries over to the next call.
+ */
+void rmt_host_set_refill(size_t symbols);
+
+/**
+ * @brief Symbols of the last transaction, in order.
+ */
+const rmt_symbol_word_t *rmt_host_symbols(size_t *count);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef ESP_CHECK_H
+#define ESP_CHECK_H
+
+#include "esp_log.h"
+
+/* Host stand-in: the checks without their log lines */
+
+#define ESP_GOTO_ON_FALSE(a, err_code, goto_tag, log_tag, ...) do { \
+    (void)(log_tag); \
+    if (!(a)) { \
+        ret = err_code; \
+        goto goto_tag; \
+    } \
+} while (0)
+
+#define ESP_GOTO_ON_ERROR(x, goto_tag, log_tag, ...) do { \
+    (void)(log_tag); \
+    esp_err_t err_rc_ = (x); \
+    if (err_rc_ != ESP_OK) { \
+        ret = err_rc_; \
+        goto goto_tag; \
+    } \
+} while (0)
+
+#endif
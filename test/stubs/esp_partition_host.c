@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "esp_partition.h"
+
+
+#define HOST_SECTOR_SIZE        4096
+#define HOST_MAX_MAPPINGS       8
+
+static esp_partition_t partition;
+static int partition_fd = -1;
+
+static struct {
+    void *base;                     // As returned by mmap, page aligned
+    size_t len;
+} mappings[HOST_MAX_MAPPINGS];
+
+
+static bool in_bounds(const esp_partition_t *part, size_t offset, size_t size) {
+    return part == &partition && offset <= part->size && size <= part->size - offset;
+}
+
+
+esp_err_t esp_partition_host_create(const char *path, esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                    const char *label, size_t size) {
+    partition_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (partition_fd < 0) return ESP_FAIL;
+
+    partition = (esp_partition_t){ .type = type, .subtype = subtype, .size = size, .erase_size = HOST_SECTOR_SIZE };
+    strncpy(partition.label, label, sizeof(partition.label) - 1);
+    if (ftruncate(partition_fd, size) != 0) return ESP_FAIL;
+    return esp_partition_erase_range(&partition, 0, size);
+}
+
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+    if (partition_fd < 0 || type != partition.type || subtype != partition.subtype) return NULL;
+    if (label && strcmp(label, partition.label)) return NULL;
+    return &partition;
+}
+
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size) {
+    if (!in_bounds(part, offset, size)) return ESP_ERR_INVALID_SIZE;
+    return pread(partition_fd, dst, size, offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+}
+
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size) {
+    if (!in_bounds(part, offset, size)) return ESP_ERR_INVALID_SIZE;
+
+    // Programming flash only clears bits
+    uint8_t *merged = malloc(size);
+    if (!merged) return ESP_ERR_NO_MEM;
+    esp_err_t ret = esp_partition_read(part, offset, merged, size);
+    if (ret == ESP_OK) {
+        for (size_t i = 0; i < size; ++i) merged[i] &= ((const uint8_t *)src)[i];
+        if (pwrite(partition_fd, merged, size, offset) != (ssize_t)size) ret = ESP_FAIL;
+    }
+    free(merged);
+    return ret;
+}
+
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size) {
+    if (!in_bounds(part, offset, size)) return ESP_ERR_INVALID_SIZE;
+    if (offset % HOST_SECTOR_SIZE || size % HOST_SECTOR_SIZE) return ESP_ERR_INVALID_ARG;
+
+    uint8_t erased[HOST_SECTOR_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    for (size_t done = 0; done < size; done += sizeof(erased)) {
+        if (pwrite(partition_fd, erased, sizeof(erased), offset + done) != sizeof(erased)) return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+
+esp_err_t esp_partition_mmap(const esp_partition_t *part, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle) {
+    if (!in_bounds(part, offset, size)) return ESP_ERR_INVALID_SIZE;
+
+    int slot = 0;
+    while (slot < HOST_MAX_MAPPINGS && mappings[slot].base) ++slot;
+    if (slot == HOST_MAX_MAPPINGS) return ESP_ERR_NO_MEM;
+
+    // Shared with the file, so later writes show through as they do through the flash cache
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t lead = offset % page;
+    void *base = mmap(NULL, size + lead, PROT_READ, MAP_SHARED, partition_fd, offset - lead);
+    if (base == MAP_FAILED) return ESP_FAIL;
+
+    mappings[slot].base = base;
+    mappings[slot].len = size + lead;
+    *out_ptr = (const uint8_t *)base + lead;
+    *out_handle = slot;
+    return ESP_OK;
+}
+
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+    if (handle >= HOST_MAX_MAPPINGS || !mappings[handle].base) return;
+    munmap(mappings[handle].base, mappings[handle].len);
+    mappings[handle].base = NULL;
+}
@@ -0,0 +1,41 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/* Host stand-in. Tests of modules that read the time define esp_timer_get_time, usually as a clock they advance
+ * themselves. Timers (esp_timer_host.c) never fire on their own: the test fires them. */
+
+typedef struct host_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+} esp_timer_create_args_t;
+
+int64_t esp_timer_get_time(void);
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *timer);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+bool esp_timer_is_active(esp_timer_handle_t timer);
+
+/**
+ * @brief Runs the callback of the timer created as `name`, as the esp_timer task would when it expires.
+ *
+ * @return false if the timer isn't running.
+ */
+bool esp_timer_host_fire(const char *name);
+
+/**
+ * @brief Microseconds until the timer created as `name` expires, -1 if it isn't running.
+ */
+int64_t esp_timer_host_due_in(const char *name);
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+
+struct host_timer {
+    esp_timer_create_args_t args;
+    bool active;
+    uint64_t period_us;             // 0 for a one shot timer
+    int64_t due_us;
+    struct host_timer *next;
+};
+
+static struct host_timer *timers = NULL;
+static bool in_callback = false;
+
+
+static struct host_timer *find(const char *name) {
+    for (struct host_timer *timer = timers; timer; timer = timer->next) {
+        if (!strcmp(timer->args.name, name)) return timer;
+    }
+    return NULL;
+}
+
+
+bool esp_timer_host_in_callback(void) {
+    return in_callback;
+}
+
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *timer) {
+    struct host_timer *created = calloc(1, sizeof(*created));
+    if (!created) return ESP_ERR_NO_MEM;
+
+    created->args = *args;
+    created->next = timers;
+    timers = created;
+    *timer = created;
+    return ESP_OK;
+}
+
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t us, uint64_t period_us) {
+    if (timer->active) return ESP_ERR_INVALID_STATE;
+    timer->active = true;
+    timer->period_us = period_us;
+    timer->due_us = esp_timer_get_time() + us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    return start(timer, period_us, period_us);
+}
+
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer->active) return ESP_ERR_INVALID_STATE;
+    timer->active = false;
+    return ESP_OK;
+}
+
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    return timer->active;
+}
+
+
+bool esp_timer_host_fire(const char *name) {
+    struct host_timer *timer = find(name);
+    if (!timer || !timer->active) return false;
+
+    if (timer->period_us) {
+        timer->due_us += timer->period_us;
+    } else {
+        timer->active = false;
+    }
+    in_callback = true;
+    timer->args.callback(timer->args.arg);
+    in_callback = false;
+    return true;
+}
+
+
+int64_t esp_timer_host_due_in(const char *name) {
+    struct host_timer *timer = find(name);
+    if (!timer || !timer->active) return -1;
+    return timer->due_us - esp_timer_get_time();
+}
@@ -0,0 +1,25 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+/* Host stand-in: the types and constants the tested modules use. Tasks are cooperative (freertos_host.c) and
+ * never preempt each other, so critical sections have nothing to exclude. */
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef int portMUX_TYPE;
+
+#define pdFALSE                         0
+#define pdTRUE                          1
+#define pdPASS                          pdTRUE
+#define portMAX_DELAY                   ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS              1
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms))
+
+#define portMUX_INITIALIZER_UNLOCKED    0
+#define portENTER_CRITICAL(mux)         ((void)(mux))
+#define portEXIT_CRITICAL(mux)          ((void)(mux))
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+/* Host stand-in: a notified task runs right away, on its own stack, until it waits for the next notification.
+ * A module's task thus behaves as if it had a higher priority than whatever notified it. */
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *task, BaseType_t core);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+/* Only from a task. A wait that no notification can end aborts the test. */
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+#endif
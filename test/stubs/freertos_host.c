@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <ucontext.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+
+#define HOST_TASK_STACK         (256 * 1024)    // Host frames are larger than the target's, so no stack_depth
+
+struct host_task {
+    const char *name;
+    TaskFunction_t fn;
+    void *arg;
+    uint32_t notifications;
+    bool running;                   // On the chain of contexts that notified each other, not waiting
+    ucontext_t context;
+    ucontext_t *resume;             // Where a wait returns to
+    struct host_task *resume_task;
+    char stack[HOST_TASK_STACK];
+};
+
+struct host_semaphore {
+    int count;
+};
+
+static struct host_task *current_task = NULL;     // NULL on the test's own stack
+
+// Set while esp_timer_host.c runs a callback; weak so tests without timers need not link it
+extern bool esp_timer_host_in_callback(void) __attribute__((weak));
+
+
+static void task_entry(void) {
+    current_task->fn(current_task->arg);
+    fprintf(stderr, "Task '%s' returned\n", current_task->name);
+    abort();
+}
+
+
+/* Runs `task` until it waits again */
+static void switch_to(struct host_task *task) {
+    ucontext_t here;
+    task->resume = &here;
+    task->resume_task = current_task;
+    task->running = true;
+    current_task = task;
+    swapcontext(&here, &task->context);
+}
+
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *task, BaseType_t core) {
+    struct host_task *created = calloc(1, sizeof(*created));
+    if (!created) return pdFALSE;
+
+    created->name = name;
+    created->fn = fn;
+    created->arg = arg;
+    getcontext(&created->context);
+    created->context.uc_stack.ss_sp = created->stack;
+    created->context.uc_stack.ss_size = sizeof(created->stack);
+    created->context.uc_link = NULL;
+    makecontext(&created->context, task_entry, 0);
+    if (task) *task = created;
+
+    switch_to(created);     // Up to its first wait
+    return pdPASS;
+}
+
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    ++task->notifications;
+    if (!task->running) switch_to(task);
+    return pdPASS;
+}
+
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    struct host_task *task = current_task;
+    if (!task) {
+        fprintf(stderr, "ulTaskNotifyTake outside a task\n");
+        abort();
+    }
+    if (task->notifications == 0) {
+        if (ticks == 0) return 0;
+        task->running = false;
+        current_task = task->resume_task;
+        swapcontext(&task->context, task->resume);
+        // Resumed by a notification
+    }
+    uint32_t value = task->notifications;
+    task->notifications = clear ? 0 : value - 1;
+    return value;
+}
+
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    struct host_semaphore *semaphore = calloc(1, sizeof(*semaphore));
+    if (semaphore) semaphore->count = 1;
+    return semaphore;
+}
+
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    if (ticks != 0 && !current_task && esp_timer_host_in_callback && esp_timer_host_in_callback()) {
+        fprintf(stderr, "Blocking semaphore take in an esp_timer callback\n");
+        abort();
+    }
+    if (semaphore->count > 0) {
+        --semaphore->count;
+        return pdTRUE;
+    }
+    if (ticks == 0) return pdFALSE;
+    fprintf(stderr, "Semaphore take that can never succeed\n");
+    abort();
+}
+
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    ++semaphore->count;
+    return pdTRUE;
+}
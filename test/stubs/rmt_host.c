@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver/rmt_encoder.h"
+
+
+#define HOST_MAX_SYMBOLS        (64 * 1024)
+#define HOST_CANARY             0xDEADBEEF
+
+typedef struct {
+    rmt_encoder_t base;
+    rmt_simple_encoder_config_t config;
+} host_simple_encoder_t;
+
+static size_t refill_symbols = 64;
+static rmt_symbol_word_t transmitted[HOST_MAX_SYMBOLS + 1];
+static size_t transmitted_count;
+
+
+/* One transaction: the callback gets whatever memory is free, and when it can't fill any of it, the next
+ * refill frees more. A callback that writes nothing into min_chunk_size free symbols would stall the channel. */
+static size_t simple_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *data,
+                            size_t data_size, rmt_encode_state_t *ret_state) {
+    host_simple_encoder_t *simple = __containerof(encoder, host_simple_encoder_t, base);
+    size_t written = 0;
+    size_t free_symbols = refill_symbols;
+    bool done = false;
+
+    while (!done) {
+        if (written + free_symbols > HOST_MAX_SYMBOLS) free_symbols = HOST_MAX_SYMBOLS - written;
+        transmitted[written + free_symbols].val = HOST_CANARY;
+        size_t count = simple->config.callback(data, data_size, written, free_symbols, transmitted + written,
+                                               &done, simple->config.arg);
+        if (count > free_symbols || transmitted[written + free_symbols].val != HOST_CANARY) {
+            fprintf(stderr, "Simple encoder callback wrote past the free symbols\n");
+            abort();
+        }
+        if (count == 0 && !done) {
+            if (free_symbols >= simple->config.min_chunk_size || written + free_symbols == HOST_MAX_SYMBOLS) {
+                fprintf(stderr, "Simple encoder callback stalled with %zu free symbols\n", free_symbols);
+                abort();
+            }
+            free_symbols += refill_symbols;
+            continue;
+        }
+        written += count;
+        free_symbols -= count;
+        if (free_symbols == 0) free_symbols = refill_symbols;
+    }
+    transmitted_count = written;
+    *ret_state = RMT_ENCODING_COMPLETE;
+    return written;
+}
+
+static esp_err_t simple_reset(rmt_encoder_t *encoder) {
+    return ESP_OK;
+}
+
+static esp_err_t simple_del(rmt_encoder_t *encoder) {
+    free(__containerof(encoder, host_simple_encoder_t, base));
+    return ESP_OK;
+}
+
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder) {
+    host_simple_encoder_t *simple = calloc(1, sizeof(*simple));
+    if (!simple) return ESP_ERR_NO_MEM;
+
+    simple->base = (rmt_encoder_t){ .encode = simple_encode, .reset = simple_reset, .del = simple_del };
+    simple->config = *config;
+    if (!simple->config.min_chunk_size) simple->config.min_chunk_size = 64;
+    *ret_encoder = &simple->base;
+    return ESP_OK;
+}
+
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder) {
+    return encoder->del(encoder);
+}
+
+
+esp_err_t rmt_encoder_reset(rmt_encoder_handle_t encoder) {
+    return encoder->reset(encoder);
+}
+
+
+void *rmt_alloc_encoder_mem(size_t size) {
+    return calloc(1, size);
+}
+
+
+void rmt_host_set_refill(size_t symbols) {
+    refill_symbols = symbols;
+}
+
+
+const rmt_symbol_word_t *rmt_host_symbols(size_t *count) {
+    *count = transmitted_count;
+    return transmitted;
+}
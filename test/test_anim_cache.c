@@ -0,0 +1,184 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "led_anim_cache.h"
+#include "led_frame_buffer.h"
+#include "led_frame_codec.h"
+
+
+#define PARTITION_FILE          "test_anim_partition.bin"
+#define PARTITION_SIZE          (LED_ANIM_SLOTS * 16 * 1024)
+#define FRAMES                  60
+#define INTERVAL_MS             20
+#define CHUNK_LEN               256
+
+static int64_t now_us;
+static int frames_received;
+static uint8_t frames[FRAMES][LED_FRAME_BYTES];
+static uint8_t clip[FRAMES * (2 + LED_FRAME_BYTES + 8)];
+static size_t clip_len;
+static size_t frame_offsets[FRAMES];
+
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+void stream_frame_received(void) {
+    ++frames_received;
+}
+
+
+static void write_be16(uint8_t *buf, uint16_t value) {
+    buf[0] = value >> 8;
+    buf[1] = value;
+}
+
+static void write_be32(uint8_t *buf, uint32_t value) {
+    write_be16(buf, value >> 16);
+    write_be16(buf + 2, value);
+}
+
+/* A chase over a gradient, stored as a keyframe and deltas */
+static void build_clip(void) {
+    clip_len = 0;
+    for (int f = 0; f < FRAMES; ++f) {
+        for (size_t i = 0; i < LED_COUNT; ++i) {
+            bool lit = (i + LED_COUNT - f * 5) % LED_COUNT < 10;
+            frames[f][i * 3] = lit ? 255 : i / 2;
+            frames[f][i * 3 + 1] = lit ? 160 : 0;
+            frames[f][i * 3 + 2] = lit ? 0 : 150 - i / 2;
+        }
+        size_t len = led_frame_encode(frames[f], f ? frames[f - 1] : NULL, LED_FRAME_BYTES, clip + clip_len + 2,
+                                      sizeof(clip) - clip_len - 2);
+        write_be16(clip + clip_len, len);
+        frame_offsets[f] = clip_len;
+        clip_len += 2 + len;
+    }
+}
+
+static esp_err_t send(uint8_t op, uint8_t slot, const uint8_t *args, size_t args_len) {
+    uint8_t message[2 + 8 + CHUNK_LEN];
+    message[0] = op;
+    message[1] = slot;
+    memcpy(message + 2, args, args_len);
+    return led_anim_handle_message(message, 2 + args_len);
+}
+
+static esp_err_t begin(uint8_t slot, uint32_t size, uint16_t frame_count, uint16_t interval_ms) {
+    uint8_t args[8];
+    write_be32(args, size);
+    write_be16(args + 4, frame_count);
+    write_be16(args + 6, interval_ms);
+    return send(ANIM_OP_BEGIN, slot, args, sizeof(args));
+}
+
+static esp_err_t send_chunk(uint8_t slot, const uint8_t *data, uint32_t offset, size_t len) {
+    uint8_t args[4 + CHUNK_LEN];
+    write_be32(args, offset);
+    memcpy(args + 4, data + offset, len);
+    return send(ANIM_OP_DATA, slot, args, 4 + len);
+}
+
+static esp_err_t end(uint8_t slot, uint32_t crc) {
+    uint8_t args[4];
+    write_be32(args, crc);
+    return send(ANIM_OP_END, slot, args, sizeof(args));
+}
+
+/* Uploads `len` bytes of `data` in chunks, each sent twice as a QoS 1 redelivery would */
+static esp_err_t upload(uint8_t slot, const uint8_t *data, size_t len, uint16_t frame_count, uint32_t crc) {
+    esp_err_t ret = begin(slot, len, frame_count, INTERVAL_MS);
+    for (size_t offset = 0; offset < len && ret == ESP_OK; offset += CHUNK_LEN) {
+        size_t chunk = len - offset < CHUNK_LEN ? len - offset : CHUNK_LEN;
+        ret = send_chunk(slot, data, offset, chunk);
+        if (ret == ESP_OK) ret = send_chunk(slot, data, offset, chunk);
+    }
+    return ret == ESP_OK ? end(slot, crc) : ret;
+}
+
+/* Fires the frame timer `count` times and counts shown frames that differ from frames[first], frames[first + 1]... */
+static int play_mismatches(int first, int count) {
+    int mismatches = 0;
+    for (int i = 0; i < count; ++i) {
+        now_us += INTERVAL_MS * 1000;
+        const uint8_t *shown = esp_timer_host_fire("anim_frame") ? led_fb_take_latest() : NULL;
+        if (!shown || memcmp(shown, frames[(first + i) % FRAMES], LED_FRAME_BYTES)) ++mismatches;
+    }
+    return mismatches;
+}
+
+
+int main(void) {
+    build_clip();
+    uint32_t crc = esp_rom_crc32_le(0, clip, clip_len);
+    printf("  %d frames in %zu bytes, %d raw\n", FRAMES, clip_len, FRAMES * LED_FRAME_BYTES);
+
+    CHECK_EQ(led_anim_handle_message((const uint8_t[]){ ANIM_OP_STOP }, 1), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(led_anim_init(), ESP_ERR_NOT_FOUND);
+    CHECK_EQ(esp_partition_host_create(PARTITION_FILE, ESP_PARTITION_TYPE_DATA, LED_ANIM_PARTITION_SUBTYPE,
+                                       LED_ANIM_PARTITION_LABEL, PARTITION_SIZE), ESP_OK);
+    CHECK_EQ(led_fb_init(), ESP_OK);
+    CHECK_EQ(led_anim_init(), ESP_OK);
+
+    // Rejected uploads
+    CHECK_EQ(begin(0, clip_len, FRAMES, LED_ANIM_MIN_INTERVAL_MS - 1), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(begin(0, PARTITION_SIZE / LED_ANIM_SLOTS, FRAMES, INTERVAL_MS), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(begin(LED_ANIM_SLOTS, clip_len, FRAMES, INTERVAL_MS), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(send_chunk(0, clip, 0, CHUNK_LEN), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(begin(0, clip_len, FRAMES, INTERVAL_MS), ESP_OK);
+    CHECK_EQ(send_chunk(0, clip, 0, CHUNK_LEN), ESP_OK);
+    CHECK_EQ(send_chunk(0, clip, 2 * CHUNK_LEN, CHUNK_LEN), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(led_anim_upload_written(), CHUNK_LEN);
+    CHECK_EQ(upload(0, clip, clip_len, FRAMES, crc ^ 1), ESP_ERR_INVALID_CRC);
+    CHECK_EQ(led_anim_upload_written(), 0);
+    CHECK_EQ(led_anim_play(0, false), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(upload(1, clip, clip_len, FRAMES - 1, crc), ESP_ERR_INVALID_SIZE);
+    uint8_t starts_on_delta[clip_len];
+    memcpy(starts_on_delta, clip, clip_len);
+    starts_on_delta[2] &= ~FRAME_CODEC_KEYFRAME;
+    CHECK_EQ(upload(1, starts_on_delta, clip_len, FRAMES, esp_rom_crc32_le(0, starts_on_delta, clip_len)),
+             ESP_ERR_INVALID_ARG);
+
+    // Stored clips play frame by frame from the mapped file, at their interval, and stop after the last one
+    CHECK_EQ(upload(0, clip, clip_len, FRAMES, crc), ESP_OK);
+    CHECK_EQ(led_anim_play(0, false), ESP_OK);
+    CHECK_EQ(esp_timer_host_due_in("anim_frame"), INTERVAL_MS * 1000);
+    CHECK_EQ(play_mismatches(0, FRAMES), 0);
+    CHECK_EQ(frames_received, FRAMES);
+    CHECK(esp_timer_host_fire("anim_frame"));
+    CHECK(led_fb_take_latest() == NULL);
+    CHECK(!esp_timer_host_fire("anim_frame"));
+
+    // Looped, over the end and back onto the keyframe; the same clip from another slot
+    CHECK_EQ(upload(2, clip, clip_len, FRAMES, crc), ESP_OK);
+    uint8_t play_looped[] = { ANIM_OP_PLAY, 2, ANIM_PLAY_LOOP };
+    CHECK_EQ(led_anim_handle_message(play_looped, sizeof(play_looped)), ESP_OK);
+    CHECK_EQ(play_mismatches(0, FRAMES + 3), 0);
+
+    // Stopping, and uploading into the slot that plays, stop the timer
+    led_anim_stop();
+    CHECK(!esp_timer_host_fire("anim_frame"));
+    CHECK_EQ(led_anim_play(2, true), ESP_OK);
+    CHECK_EQ(begin(2, clip_len, FRAMES, INTERVAL_MS), ESP_OK);
+    CHECK(!esp_timer_host_fire("anim_frame"));
+    CHECK_EQ(led_anim_play(2, true), ESP_ERR_INVALID_STATE);
+
+    // One frame from the timer to the frame buffer, through the play task, against decoding alone
+    CHECK_EQ(led_anim_play(0, true), ESP_OK);
+    BENCH("timer to frame buffer, per frame", 100000, {
+        esp_timer_host_fire("anim_frame");
+        test_sink += led_fb_take_latest() != NULL;
+    });
+    static uint8_t decoded[LED_FRAME_BYTES];
+    BENCH("decode only, per frame", 100000, {
+        size_t cursor = frame_offsets[bench_i % FRAMES];
+        test_sink += led_frame_decode(clip + cursor + 2, clip[cursor] << 8 | clip[cursor + 1], decoded,
+                                      LED_FRAME_BYTES);
+    });
+
+    return test_finish("test_anim_cache");
+}
@@ -0,0 +1,116 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "test_support.h"
+#include "led_clock_sync.h"
+
+
+#define SERVER_OFFSET_US        3723456789LL    // Server time - local time
+#define EXCHANGES               20000
+#define SERVER_PROCESSING_US    40
+
+static int64_t now_us;
+static uint32_t rng_state = 0x12345678;
+
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* Uniform in [0, 1) */
+static double uniform(void) {
+    return (next_random() >> 8) / 16777216.0;
+}
+
+/* One way Wi-Fi delay: air time plus exponential queueing, and now and then a burst of retries or a beacon
+ * interval spent in power save */
+static int64_t delay_us(int64_t base_us, double mean_jitter_us, double burst_chance, int64_t burst_max_us) {
+    int64_t delay = base_us - (int64_t)(mean_jitter_us * log(1.0 - uniform()));
+    if (uniform() < burst_chance) delay += (int64_t)(uniform() * burst_max_us);
+    return delay;
+}
+
+static int compare_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_percentiles(const char *label, int64_t *errors, int count) {
+    qsort(errors, count, sizeof(*errors), compare_int64);
+    printf("  %-40s p50 %6lld  p95 %6lld  p99 %6lld us\n", label, (long long)errors[count / 2],
+           (long long)errors[count * 95 / 100], (long long)errors[count * 99 / 100]);
+}
+
+
+int main(void) {
+    static int64_t filtered_errors[EXCHANGES], sample_errors[EXCHANGES];
+    int64_t local_us;
+    CHECK(!led_clock_from_timecode(0, &local_us));
+
+    // The downlink waits in the access point for the station to wake up, so it is slower and burstier than the
+    // uplink: the asymmetry that a single exchange turns into offset error
+    now_us = 5000000;
+    int count = 0;
+    for (int i = 0; i < EXCHANGES; ++i) {
+        int64_t t0 = now_us;
+        int64_t t1 = t0 + delay_us(900, 400, 0.05, 8000) + SERVER_OFFSET_US;
+        int64_t t2 = t1 + SERVER_PROCESSING_US;
+        int64_t t3 = t2 - SERVER_OFFSET_US + delay_us(1400, 1500, 0.25, 100000);
+        led_clock_add_exchange(t0, t1, t2, t3);
+        now_us = t3 + CLOCK_SYNC_INTERVAL_MS * 1000;
+
+        // What the filter picked is off by at most half its round trip; the exchange alone by half its own
+        led_clock_stats_t stats = led_clock_sync_get_stats();
+        int64_t error = llabs(stats.offset_us - SERVER_OFFSET_US);
+        CHECK(error <= stats.rtt_us / 2 + 1);
+        int64_t rtt = (t3 - t0) - (t2 - t1);
+        if (i >= CLOCK_SYNC_FILTER_SIZE) {
+            filtered_errors[count] = error;
+            sample_errors[count] = llabs(((t1 - t0) + (t2 - t3)) / 2 - SERVER_OFFSET_US);
+            CHECK(sample_errors[count] <= rtt / 2 + 1);
+            ++count;
+        }
+    }
+    CHECK_EQ(led_clock_sync_get_stats().samples, EXCHANGES);
+    led_clock_add_failure();
+    CHECK_EQ(led_clock_sync_get_stats().failures, 1);
+    CHECK(led_clock_sync_get_stats().synced);
+
+    print_percentiles("skew, single exchange", sample_errors, count);
+    int64_t single_p99 = sample_errors[count * 99 / 100];
+    print_percentiles("skew, min round trip of 8", filtered_errors, count);
+    CHECK(filtered_errors[count * 99 / 100] < single_p99 / 4);
+    CHECK(filtered_errors[count * 99 / 100] < 1000);
+
+    // Timecodes (16.16 network seconds) to local time, to within their 15 us resolution, ahead and behind
+    int64_t offset = led_clock_sync_get_stats().offset_us;
+    for (int64_t ahead_us = -1500000; ahead_us <= 1500000; ahead_us += 250000) {
+        int64_t network_us = now_us + offset + ahead_us;
+        uint32_t timecode = (uint32_t)((network_us / 1000000) << 16) |
+                            (uint32_t)((network_us % 1000000) * 65536 / 1000000);
+        CHECK(led_clock_from_timecode(timecode, &local_us));
+        CHECK(llabs(local_us - (now_us + ahead_us)) <= 16);
+    }
+
+    // The seconds wrap every 18.2 hours: just before the wrap, a timecode just after it is still ahead
+    now_us = 5 * 65536LL * 1000000 - 300000 - offset;
+    CHECK(led_clock_from_timecode(3277, &local_us));     // 0.05 s into the next period
+    CHECK(llabs(local_us - (now_us + 350000)) <= 16);
+
+    BENCH("add exchange", 1000000, led_clock_add_exchange(bench_i, bench_i + 2000 + SERVER_OFFSET_US,
+                                                         bench_i + 2040 + SERVER_OFFSET_US, bench_i + 4040));
+    BENCH("timecode to local time", 1000000, {
+        led_clock_from_timecode(bench_i, &local_us);
+        test_sink += local_us;
+    });
+
+    return test_finish("test_clock_sync");
+}
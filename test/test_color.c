@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_color.h"
+#include "led_frame_buffer.h"
+
+
+#define MAX_FLOAT_DEVIATION     2       // Counts per channel against the float conversion it replaced
+
+static uint8_t frame[LED_FRAME_BYTES];
+
+
+/* The float conversion the JSON {h, s} path used before led_hsv_to_rgb: h in degrees, s and v in percent */
+static void float_hsv2rgb(uint32_t h, uint32_t s, uint32_t v, uint32_t *r, uint32_t *g, uint32_t *b) {
+    h %= 360;
+    uint32_t rgb_max = v * 2.55f;
+    uint32_t rgb_min = rgb_max * (100 - s) / 100.0f;
+    uint32_t i = h / 60;
+    uint32_t diff = h % 60;
+    uint32_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
+
+    switch (i) {
+        case 0:  *r = rgb_max;           *g = rgb_min + rgb_adj; *b = rgb_min;           break;
+        case 1:  *r = rgb_max - rgb_adj; *g = rgb_max;           *b = rgb_min;           break;
+        case 2:  *r = rgb_min;           *g = rgb_max;           *b = rgb_min + rgb_adj; break;
+        case 3:  *r = rgb_min;           *g = rgb_max - rgb_adj; *b = rgb_max;           break;
+        case 4:  *r = rgb_min + rgb_adj; *g = rgb_min;           *b = rgb_max;           break;
+        default: *r = rgb_max;           *g = rgb_min;           *b = rgb_max - rgb_adj; break;
+    }
+}
+
+static bool is_color(led_rgb_t color, uint8_t r, uint8_t g, uint8_t b) {
+    return color.r == r && color.g == g && color.b == b;
+}
+
+
+int main(void) {
+    // Primaries, greys and black
+    CHECK(is_color(led_hsv_to_rgb(0, 255, 255), 255, 0, 0));
+    CHECK(is_color(led_hsv_to_rgb(LED_HUE_DEGREES(120), 255, 255), 0, 255, 0));
+    CHECK(is_color(led_hsv_to_rgb(LED_HUE_DEGREES(240), 255, 255), 0, 0, 255));
+    CHECK(is_color(led_hsv_to_rgb(LED_HUE_DEGREES(60), 255, 255), 255, 255, 0));
+    int grey_mismatches = 0;
+    for (int hue = 0; hue < 65536; hue += 251) {
+        if (!is_color(led_hsv_to_rgb(hue, 0, 77), 77, 77, 77)) ++grey_mismatches;
+        if (!is_color(led_hsv_to_rgb(hue, 255, 0), 0, 0, 0)) ++grey_mismatches;
+    }
+    CHECK_EQ(grey_mismatches, 0);
+
+    // Every hue and saturation the JSON {h, s} path can ask for, against the float conversion
+    int max_deviation = 0;
+    for (uint32_t h = 0; h < 360; ++h) {
+        for (uint32_t s = 0; s <= 100; ++s) {
+            uint32_t r, g, b;
+            float_hsv2rgb(h, s, 100, &r, &g, &b);
+            led_rgb_t color = led_hsv_to_rgb(LED_HUE_DEGREES(h), s * 255 / 100, 255);
+            int deviations[] = { abs(color.r - (int)r), abs(color.g - (int)g), abs(color.b - (int)b) };
+            for (int c = 0; c < 3; ++c) {
+                if (deviations[c] > max_deviation) max_deviation = deviations[c];
+            }
+        }
+    }
+    printf("  max deviation from the float conversion %d\n", max_deviation);
+    CHECK(max_deviation <= MAX_FLOAT_DEVIATION);
+
+    CHECK_EQ(led_scale8(255, 255), 255);
+    CHECK_EQ(led_scale8(200, 255), 200);
+    CHECK_EQ(led_scale8(255, 0), 0);
+    CHECK_EQ(led_scale8(128, 128), 64);
+
+    // Fills stay inside their span
+    const led_rgb_t teal = { 0, 128, 128 };
+    memset(frame, 0xAA, sizeof(frame));
+    led_fill_solid(frame, 7, 100, teal);
+    CHECK_EQ(frame[7 * 3 - 1], 0xAA);
+    CHECK_EQ(frame[107 * 3], 0xAA);
+    int fill_mismatches = 0;
+    for (size_t i = 7; i < 107; ++i) {
+        if (memcmp(frame + i * 3, &teal, 3)) ++fill_mismatches;
+    }
+    CHECK_EQ(fill_mismatches, 0);
+    led_fill_solid(frame, 0, 0, teal);
+    CHECK_EQ(frame[0], 0xAA);
+
+    led_fill_gradient(frame, 1, LED_COUNT - 1, 1000, -300, 200, 180);
+    CHECK_EQ(frame[0], 0xAA);
+    int gradient_mismatches = 0;
+    for (size_t i = 1; i < LED_COUNT; ++i) {
+        led_rgb_t expected = led_hsv_to_rgb((uint16_t)(1000 - 300 * (int32_t)(i - 1)), 200, 180);
+        if (memcmp(frame + i * 3, &expected, 3)) ++gradient_mismatches;
+    }
+    CHECK_EQ(gradient_mismatches, 0);
+
+    BENCH("led_hsv_to_rgb", 10000000, test_sink += led_hsv_to_rgb(bench_i * 97, bench_i, 255).g);
+    BENCH("float hsv2rgb", 10000000, {
+        uint32_t r, g, b;
+        float_hsv2rgb(bench_i % 360, bench_i % 101, 100, &r, &g, &b);
+        test_sink += g;
+    });
+    BENCH("led_fill_solid, whole frame", 200000, {
+        led_fill_solid(frame, 0, LED_COUNT, (led_rgb_t){ bench_i, 0, 0 });
+        test_sink += frame[bench_i % LED_FRAME_BYTES];
+    });
+    BENCH("per pixel stores, whole frame", 200000, {
+        for (size_t i = 0; i < LED_COUNT; ++i) {
+            frame[i * 3] = bench_i;
+            frame[i * 3 + 1] = 0;
+            frame[i * 3 + 2] = 0;
+        }
+        test_sink += frame[bench_i % LED_FRAME_BYTES];
+    });
+
+    return test_finish("test_color");
+}
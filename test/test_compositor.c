@@ -0,0 +1,112 @@
+#include <math.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_compositor.h"
+#include "led_frame_buffer.h"
+
+
+#define OVERLAY_OPACITY         64
+#define NOTIFY_FIRST            10
+#define NOTIFY_COUNT            5
+
+static const led_rgb_t white = { 255, 255, 255 };
+static const led_rgb_t red = { 255, 0, 0 };
+
+static uint8_t base[LED_FRAME_BYTES];
+static uint8_t frame[LED_FRAME_BYTES];
+static uint8_t expected[LED_FRAME_BYTES];
+
+
+/* What the stack set up in main() composites to, recomputed from scratch */
+static void reference(bool overlay_visible) {
+    for (size_t i = 0; i < LED_COUNT; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            int value = base[i * 3 + c];
+            if (overlay_visible) {
+                value += led_scale8(255, led_scale8(255, OVERLAY_OPACITY));
+                if (value > 255) value = 255;
+            }
+            if (i >= NOTIFY_FIRST && i < NOTIFY_FIRST + NOTIFY_COUNT) value = (&red.r)[c];
+            expected[i * 3 + c] = value;
+        }
+    }
+}
+
+
+int main(void) {
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) base[i] = i * 7;
+
+    led_layer_fill(LED_LAYER_OVERLAY, 0, LED_COUNT, white, 255);
+    led_layer_set_blend(LED_LAYER_OVERLAY, LED_BLEND_ADD, OVERLAY_OPACITY);
+    CHECK(led_layer_show(LED_LAYER_OVERLAY, true));
+    led_layer_fill(LED_LAYER_NOTIFY, NOTIFY_FIRST, NOTIFY_COUNT, red, 255);
+    CHECK(led_layer_show(LED_LAYER_NOTIFY, true));
+    CHECK(led_compositor_active());
+    led_layer_update(LED_LAYER_BASE, base, NULL);
+
+    CHECK_EQ(led_compositor_compose(frame), LED_COUNT);
+    reference(true);
+    CHECK(!memcmp(frame, expected, sizeof(frame)));
+
+    // Nothing changed: nothing recomposited, same frame
+    CHECK_EQ(led_compositor_compose(frame), 0);
+    CHECK(!memcmp(frame, expected, sizeof(frame)));
+
+    // Only the changed base pixels are recomposited
+    base[3 * 50] ^= 1;
+    base[3 * 200] ^= 1;
+    base[3 * 201 + 2] ^= 1;
+    led_layer_update(LED_LAYER_BASE, base, NULL);
+    CHECK_EQ(led_compositor_compose(frame), 3);
+    reference(true);
+    CHECK(!memcmp(frame, expected, sizeof(frame)));
+
+    // Hiding the overlay recomposites all of it
+    CHECK(led_layer_show(LED_LAYER_OVERLAY, false));
+    CHECK(!led_layer_show(LED_LAYER_OVERLAY, false));
+    CHECK_EQ(led_compositor_compose(frame), LED_COUNT);
+    reference(false);
+    CHECK(!memcmp(frame, expected, sizeof(frame)));
+    CHECK(led_layer_show(LED_LAYER_OVERLAY, true));
+    led_compositor_compose(frame);
+
+    // Partial normal blends round to nearest, towards brighter and darker colors alike
+    static const led_rgb_t shades[] = { { 255, 255, 255 }, { 0, 0, 0 }, { 200, 13, 77 } };
+    for (size_t s = 0; s < sizeof(shades) / sizeof(shades[0]); ++s) {
+        for (int opacity = 1; opacity < 255; opacity += 31) {
+            uint8_t alpha = led_scale8(255, opacity);
+            led_layer_fill(LED_LAYER_OVERLAY, 0, LED_COUNT, shades[s], 255);
+            led_layer_set_blend(LED_LAYER_OVERLAY, LED_BLEND_NORMAL, opacity);
+            led_compositor_compose(frame);
+            int mismatches = 0;
+            for (size_t i = 0; i < LED_COUNT; ++i) {
+                if (i >= NOTIFY_FIRST && i < NOTIFY_FIRST + NOTIFY_COUNT) continue;
+                for (int c = 0; c < 3; ++c) {
+                    int from = base[i * 3 + c];
+                    int to = (&shades[s].r)[c];
+                    if (frame[i * 3 + c] != lround((from * (255.0 - alpha) + to * alpha) / 255)) ++mismatches;
+                }
+            }
+            CHECK_EQ(mismatches, 0);
+        }
+    }
+    led_layer_fill(LED_LAYER_OVERLAY, 0, LED_COUNT, white, 255);
+    led_layer_set_blend(LED_LAYER_OVERLAY, LED_BLEND_ADD, OVERLAY_OPACITY);
+    led_compositor_compose(frame);
+
+    // One changed pixel per frame against marking the whole base layer dirty
+    BENCH("compose, one dirty pixel", 20000, {
+        base[3 * (bench_i % LED_COUNT)]++;
+        led_layer_update(LED_LAYER_BASE, base, NULL);
+        test_sink += led_compositor_compose(frame);
+    });
+    BENCH("compose, whole frame dirty", 20000, {
+        base[3 * (bench_i % LED_COUNT)]++;
+        led_layer_update(LED_LAYER_BASE, base, NULL);
+        led_layer_mark(LED_LAYER_BASE, 0, LED_COUNT);
+        test_sink += led_compositor_compose(frame);
+    });
+
+    return test_finish("test_compositor");
+}
@@ -0,0 +1,123 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "led_effect.h"
+#include "led_frame_buffer.h"
+#include "led_pixel_map.h"
+#include "led_render_parallel.h"
+
+
+#define FRAME_MS                10
+#define RUN_MS                  1000
+
+static int64_t now_us;
+static uint8_t incremental[LED_FRAME_BYTES];
+static uint8_t stepped_once[LED_FRAME_BYTES];
+static led_rgb_t palette[LED_EFFECT_PALETTE_SIZE];
+static led_rgb_t palette_once[LED_EFFECT_PALETTE_SIZE];
+
+static const led_effect_params_t params = { .color = { 10, 200, 30 }, .text = "Hi 42" };
+
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+/* Both halves on the calling core: the split itself is target code */
+void led_render_split(led_span_render_fn fn, uint8_t *frame, size_t count, void *ctx) {
+    fn(frame, 0, count / 2, ctx);
+    fn(frame, count / 2, count - count / 2, ctx);
+}
+
+
+/* Restarts `id` by switching away from it and back */
+static void restart(uint8_t id, uint8_t *out, led_rgb_t *colors) {
+    led_effect_render_frame(id == LED_EFFECT_BREATHE ? LED_EFFECT_CHASE : LED_EFFECT_BREATHE, &params, out, colors);
+    led_effect_render_frame(id, &params, out, colors);
+}
+
+/* Renders RUN_MS of `id` frame by frame, then again as a single step. Effects only write what changed, so a
+ * pixel an incremental render forgot shows up as a difference. */
+static bool incremental_matches(uint8_t id) {
+    size_t bytes = LED_FRAME_BYTES;
+
+    restart(id, incremental, palette);
+    bool indexed = false;
+    for (int ms = 0; ms < RUN_MS; ms += FRAME_MS) {
+        now_us += FRAME_MS * 1000;
+        indexed = led_effect_render_frame(id, &params, incremental, palette);
+    }
+    restart(id, stepped_once, palette_once);
+    now_us += RUN_MS * 1000;
+    led_effect_render_frame(id, &params, stepped_once, palette_once);
+
+    if (indexed) {
+        bytes = LED_COUNT;
+        if (memcmp(palette, palette_once, sizeof(palette))) return false;
+    }
+    return !memcmp(incremental, stepped_once, bytes);
+}
+
+
+int main(void) {
+    led_map_config_t map = { .layout = LED_MAP_MATRIX, .width = 20, .height = 15, .serpentine = true };
+    CHECK_EQ(led_map_init(&map), ESP_OK);
+
+    CHECK_EQ(led_effect_find("none", 4), LED_EFFECT_NONE);
+    CHECK_EQ(led_effect_find("rainbow", 7), LED_EFFECT_RAINBOW);
+    CHECK_EQ(led_effect_find("rain", 4), -1);
+    for (int id = LED_EFFECT_NONE + 1; id < LED_EFFECT_COUNT; ++id) {
+        const char *name = led_effect_name(id);
+        CHECK_EQ(led_effect_find(name, strlen(name)), id);
+    }
+
+    // Fire catches up at most a few steps after a gap, so a single long step is meant to differ
+    CHECK(incremental_matches(LED_EFFECT_CHASE));
+    CHECK(incremental_matches(LED_EFFECT_RAINBOW));
+    CHECK(incremental_matches(LED_EFFECT_BREATHE));
+    CHECK(incremental_matches(LED_EFFECT_PLASMA));
+    CHECK(incremental_matches(LED_EFFECT_TEXT));
+
+    // A restarted chase starts on a black canvas with only its segment lit
+    restart(LED_EFFECT_CHASE, incremental, palette);
+    int lit = 0;
+    for (size_t i = 0; i < LED_COUNT; ++i) {
+        if (incremental[i * 3] || incremental[i * 3 + 1] || incremental[i * 3 + 2]) ++lit;
+    }
+    CHECK_EQ(lit, 10);
+
+    // The rainbow comes back around after its period
+    CHECK(led_effect_render_frame(LED_EFFECT_RAINBOW, &params, incremental, palette));
+    memcpy(palette_once, palette, sizeof(palette));
+    now_us += 5000 * 1000;
+    led_effect_render_frame(LED_EFFECT_RAINBOW, &params, incremental, palette);
+    CHECK(!memcmp(palette, palette_once, sizeof(palette)));
+
+    // Fire heats up from its base
+    restart(LED_EFFECT_FIRE, incremental, palette);
+    for (int ms = 0; ms < RUN_MS; ms += FRAME_MS) {
+        now_us += FRAME_MS * 1000;
+        led_effect_render_frame(LED_EFFECT_FIRE, &params, incremental, palette);
+    }
+    CHECK(incremental[0] || incremental[3] || incremental[6]);
+
+    // One frame of each effect at the frame clock, state step included
+    static const char *const labels[LED_EFFECT_COUNT] = {
+        [LED_EFFECT_CHASE] = "chase frame",
+        [LED_EFFECT_RAINBOW] = "rainbow frame",
+        [LED_EFFECT_BREATHE] = "breathe frame",
+        [LED_EFFECT_FIRE] = "fire frame",
+        [LED_EFFECT_PLASMA] = "plasma frame",
+        [LED_EFFECT_TEXT] = "text frame",
+    };
+    for (int id = LED_EFFECT_NONE + 1; id < LED_EFFECT_COUNT; ++id) {
+        if (!labels[id]) continue;
+        restart(id, incremental, palette);
+        BENCH(labels[id], 20000, {
+            now_us += FRAME_MS * 1000;
+            test_sink += led_effect_render_frame(id, &params, incremental, palette);
+        });
+    }
+
+    return test_finish("test_effects");
+}
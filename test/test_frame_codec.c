@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_frame_codec.h"
+#include "led_frame_buffer.h"
+
+
+#define ENCODED_MAX             (1 + LED_FRAME_BYTES + LED_FRAME_BYTES / 100)    // Raw pixels plus op headers
+
+static uint8_t prev[LED_FRAME_BYTES];
+static uint8_t frame[LED_FRAME_BYTES];
+static uint8_t decoded[LED_FRAME_BYTES];
+static uint8_t untouched[LED_FRAME_BYTES];
+static uint8_t encoded[ENCODED_MAX];
+
+
+static void set_pixel(uint8_t *out, size_t pixel, uint8_t r, uint8_t g, uint8_t b) {
+    out[pixel * 3] = r;
+    out[pixel * 3 + 1] = g;
+    out[pixel * 3 + 2] = b;
+}
+
+/* Frames a stream sends, each against `prev` */
+static void next_frame(int kind, int step) {
+    memcpy(frame, prev, sizeof(frame));
+    switch (kind) {
+        case 0:     // Unchanged
+            break;
+        case 1:     // A chase: a 10 pixel segment moves on
+            for (int i = 0; i < 10; ++i) set_pixel(frame, (step + i) % LED_COUNT, 0, 0, 0);
+            for (int i = 0; i < 10; ++i) set_pixel(frame, (step + 1 + i) % LED_COUNT, 255, 160, 0);
+            break;
+        case 2:     // A few scattered pixels
+            for (int i = 0; i < 30; ++i) set_pixel(frame, rand() % LED_COUNT, rand(), rand(), rand());
+            break;
+        case 3:     // Solid color
+            for (size_t i = 0; i < LED_COUNT; ++i) set_pixel(frame, i, 0, step, 255 - step);
+            break;
+        default:    // Noise
+            for (size_t i = 0; i < LED_FRAME_BYTES; ++i) frame[i] = rand();
+            break;
+    }
+}
+
+/* Encodes `frame` against `base` (NULL for a keyframe) and decodes it onto `prev` */
+static size_t round_trip(const uint8_t *base) {
+    size_t len = led_frame_encode(frame, base, sizeof(frame), encoded, sizeof(encoded));
+    if (!len) return 0;
+    memcpy(decoded, prev, sizeof(decoded));
+    if (led_frame_decode(encoded, len, decoded, sizeof(decoded)) != ESP_OK) return 0;
+    return memcmp(decoded, frame, sizeof(frame)) ? 0 : len;
+}
+
+
+int main(void) {
+    srand(1);
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) prev[i] = rand();
+
+    // Delta and keyframes of every kind decode back to the frame
+    static const char *const kinds[] = { "unchanged", "chase", "scattered", "solid", "noise" };
+    int round_trip_failures = 0;
+    for (int kind = 0; kind < 5; ++kind) {
+        size_t delta_total = 0;
+        size_t key_total = 0;
+        for (int step = 0; step < 100; ++step) {
+            next_frame(kind, step);
+            size_t delta = round_trip(prev);
+            size_t key = round_trip(NULL);
+            if (!delta || !key) ++round_trip_failures;
+            delta_total += delta;
+            key_total += key;
+            memcpy(prev, frame, sizeof(prev));
+        }
+        printf("  %-10s delta %5zu bytes, keyframe %5zu bytes, raw %d bytes\n", kinds[kind], delta_total / 100,
+               key_total / 100, LED_FRAME_BYTES);
+    }
+    CHECK_EQ(round_trip_failures, 0);
+
+    // Nothing changed: the flags byte alone
+    memcpy(frame, prev, sizeof(frame));
+    CHECK_EQ(led_frame_encode(frame, prev, sizeof(frame), encoded, sizeof(encoded)), 1);
+
+    // Ops by hand: extended counts, XOR, and pixels past the last op left alone
+    memset(decoded, 0x55, sizeof(decoded));
+    static const uint8_t ops[] = {
+        0, FRAME_OP_SKIP | FRAME_OP_COUNT_MASK, 255 - 64 + 1,          // 256 pixels
+        FRAME_OP_XOR | 1, 0xFF, 0x00, 0x0F, 0x00, 0x00, 0x00,
+        FRAME_OP_FILL | 2, 1, 2, 3,
+    };
+    CHECK_EQ(led_frame_decode(ops, sizeof(ops), decoded, sizeof(decoded)), ESP_OK);
+    CHECK_EQ(decoded[255 * 3], 0x55);
+    CHECK_EQ(decoded[256 * 3], 0xAA);
+    CHECK_EQ(decoded[256 * 3 + 2], 0x5A);
+    CHECK_EQ(decoded[257 * 3], 0x55);
+    CHECK_EQ(decoded[258 * 3 + 2], 3);
+    CHECK_EQ(decoded[260 * 3 + 2], 3);
+    CHECK_EQ(decoded[261 * 3], 0x55);
+    static const uint8_t keyframe_fill[] = { FRAME_CODEC_KEYFRAME, FRAME_OP_FILL, 9, 9, 9 };
+    CHECK_EQ(led_frame_decode(keyframe_fill, sizeof(keyframe_fill), decoded, sizeof(decoded)), ESP_OK);
+    CHECK_EQ(decoded[0], 9);
+    CHECK_EQ(decoded[3], 0);
+
+    // Malformed payloads leave the frame as it was: every truncation of a noisy frame, and ops past its end
+    next_frame(4, 0);
+    size_t len = led_frame_encode(frame, prev, sizeof(frame), encoded, sizeof(encoded));
+    int truncation_mismatches = 0;
+    for (size_t cut = 1; cut < len; ++cut) {
+        memcpy(decoded, prev, sizeof(decoded));
+        if (led_frame_decode(encoded, cut, decoded, sizeof(decoded)) == ESP_OK) continue;     // Cut between ops
+        if (memcmp(decoded, prev, sizeof(decoded))) ++truncation_mismatches;
+    }
+    CHECK_EQ(truncation_mismatches, 0);
+    static const uint8_t past_end[] = {
+        0, FRAME_OP_FILL | FRAME_OP_COUNT_MASK, 200, 1, 2, 3, FRAME_OP_FILL | 62, 4, 5, 6,       // 264 + 63 pixels
+    };
+    memcpy(untouched, decoded, sizeof(untouched));
+    CHECK_EQ(led_frame_decode(past_end, sizeof(past_end), decoded, sizeof(decoded)), ESP_ERR_INVALID_SIZE);
+    CHECK(!memcmp(decoded, untouched, sizeof(decoded)));
+    CHECK_EQ(led_frame_decode(past_end, 0, decoded, sizeof(decoded)), ESP_ERR_INVALID_SIZE);
+
+    // An output buffer too small for the frame
+    CHECK_EQ(led_frame_encode(frame, prev, sizeof(frame), encoded, LED_FRAME_BYTES / 2), 0);
+
+    next_frame(1, 7);
+    len = led_frame_encode(frame, prev, sizeof(frame), encoded, sizeof(encoded));
+    BENCH("encode chase delta", 200000, {
+        test_sink += led_frame_encode(frame, prev, sizeof(frame), encoded, sizeof(encoded));
+    });
+    BENCH("decode chase delta", 200000, {
+        test_sink += led_frame_decode(encoded, len, decoded, sizeof(decoded));
+    });
+    next_frame(4, 0);
+    len = led_frame_encode(frame, prev, sizeof(frame), encoded, sizeof(encoded));
+    BENCH("encode noise", 200000, {
+        test_sink += led_frame_encode(frame, prev, sizeof(frame), encoded, sizeof(encoded));
+    });
+    BENCH("decode noise", 200000, {
+        test_sink += led_frame_decode(encoded, len, decoded, sizeof(decoded));
+    });
+    BENCH("raw frame copy", 200000, {
+        memcpy(decoded, frame, sizeof(decoded));
+        test_sink += decoded[bench_i % LED_FRAME_BYTES];
+    });
+
+    return test_finish("test_frame_codec");
+}
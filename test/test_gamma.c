@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_gamma.h"
+#include "led_gamma_tables.h"
+#include "led_pixel_format.h"
+
+
+#define MAX_LEVEL               0xFF00      // Full scale in 8.8, so level + dither offset never overflows
+#define DITHER_CYCLE            256         // Frames until the bit reversed offsets have taken every value
+#define BENCH_PIXELS_MAX        2000
+
+static uint8_t pixels[BENCH_PIXELS_MAX * LED_PIXEL_BYTES];
+static uint8_t wire[BENCH_PIXELS_MAX * LED_WIRE_BYTES];
+
+
+/* Generated tables and the tables led_gamma_set folds the brightness into: from 0 up to at most full scale,
+ * never down */
+static bool is_monotonic(const uint16_t *levels, uint16_t max) {
+    if (levels[0] != 0 || levels[255] > max) return false;
+    for (int i = 1; i < 256; ++i) {
+        if (levels[i] < levels[i - 1]) return false;
+    }
+    return true;
+}
+
+/* What the wire shows of channel value `value` on the first pixel, summed over `frames` frames */
+static uint32_t shown_sum(uint8_t value, int frames) {
+    uint32_t sum = 0;
+    for (int f = 0; f < frames; ++f) {
+        led_gamma_lut_t lut;
+        uint8_t out[LED_WIRE_BYTES];
+        led_gamma_prepare(&lut, true);
+        led_wire_pixel((const uint8_t[]){ value, value, value }, lut.levels, lut.dither_offset, out);
+        sum += out[0];
+    }
+    return sum;
+}
+
+/* One frame out of the output stage: the table, then every pixel to wire bytes as the encoders do it */
+static void wire_frame(size_t count, bool dither) {
+    led_gamma_lut_t lut;
+    led_gamma_prepare(&lut, dither);
+    uint8_t offset = lut.dither_offset;
+    for (size_t pixel = 0; pixel < count; ++pixel) {
+        led_wire_pixel(pixels + pixel * LED_PIXEL_BYTES, lut.levels, offset, wire + pixel * LED_WIRE_BYTES);
+        offset += lut.dither_stride;
+    }
+    test_sink += wire[count * LED_WIRE_BYTES - 1];
+}
+
+
+int main(void) {
+    // Every generated curve: monotonic, and full scale at 255 exactly; linear is curve 0
+    CHECK(LED_GAMMA_CURVE_COUNT >= 2);
+    for (int curve = 0; curve < LED_GAMMA_CURVE_COUNT; ++curve) {
+        CHECK(is_monotonic(led_gamma_tables[curve], MAX_LEVEL));
+        CHECK_EQ(led_gamma_tables[curve][255], MAX_LEVEL);
+    }
+    for (int i = 0; i < 256; ++i) CHECK_EQ(led_gamma_tables[LED_GAMMA_LINEAR][i], i << 8);
+
+    // With the brightness folded in, at every brightness
+    CHECK_EQ(led_gamma_set(LED_GAMMA_CURVE_COUNT, 255), ESP_ERR_INVALID_ARG);
+    int non_monotonic = 0;
+    for (int curve = 0; curve < LED_GAMMA_CURVE_COUNT; ++curve) {
+        for (int brightness = 0; brightness < 256; ++brightness) {
+            led_gamma_lut_t lut;
+            CHECK_EQ(led_gamma_set(curve, brightness), ESP_OK);
+            led_gamma_prepare(&lut, false);
+            if (!is_monotonic(lut.levels, (MAX_LEVEL * (brightness + 1)) >> 8)) ++non_monotonic;
+        }
+    }
+    CHECK_EQ(non_monotonic, 0);
+
+    // Whole steps have nothing to dither: linear at full brightness, or dithering off
+    led_gamma_lut_t lut;
+    CHECK_EQ(led_gamma_set(LED_GAMMA_LINEAR, 255), ESP_OK);
+    CHECK(!led_gamma_prepare(&lut, true));
+    CHECK_EQ(lut.dither_stride, 0);
+    CHECK_EQ(led_gamma_set(LED_GAMMA_DEFAULT, 255), ESP_OK);
+    CHECK(!led_gamma_prepare(&lut, false));
+    CHECK_EQ(lut.dither_offset, 0);
+    CHECK(led_gamma_prepare(&lut, true));
+    CHECK(lut.dither_stride % 2 == 1);
+
+    // Dithered, every channel value averages out to its exact level over a cycle, and to within one step over
+    // any aligned run of 16 frames; among them the low values that an undithered curve shows as 0
+    int wrong_averages = 0, rough_runs = 0, recovered = 0;
+    for (int brightness = 255; brightness >= 31; brightness -= 112) {
+        CHECK_EQ(led_gamma_set(LED_GAMMA_DEFAULT, brightness), ESP_OK);
+        led_gamma_prepare(&lut, false);
+        led_gamma_lut_t last;
+        do led_gamma_prepare(&last, true); while (last.dither_offset != 0xFF);    // The last frame of a cycle
+        for (int value = 0; value < 256; ++value) {
+            uint16_t level = lut.levels[value];
+            uint32_t sum = 0;
+            for (int run = 0; run < DITHER_CYCLE / 16; ++run) {
+                uint32_t run_sum = shown_sum(value, 16);
+                if (abs((int)(run_sum * 256) - 16 * level) >= 256) ++rough_runs;
+                sum += run_sum;
+            }
+            if (sum != level) ++wrong_averages;
+            if (level >> 8 == 0 && sum > 0) ++recovered;
+        }
+    }
+    CHECK_EQ(wrong_averages, 0);
+    CHECK_EQ(rough_runs, 0);
+    CHECK(recovered > 20);
+    printf("  %d channel values below one step shown through dithering\n", recovered);
+
+    // The output stage per frame, as the render loop runs it
+    srand(1);
+    for (size_t i = 0; i < sizeof(pixels); ++i) pixels[i] = rand();
+    CHECK_EQ(led_gamma_set(LED_GAMMA_DEFAULT, 200), ESP_OK);
+    BENCH("prepare + wire, 300 LEDs", 20000, wire_frame(300, false));
+    BENCH("prepare + wire, 300 LEDs, dithered", 20000, wire_frame(300, true));
+    BENCH("prepare + wire, 2000 LEDs", 5000, wire_frame(2000, false));
+    BENCH("prepare + wire, 2000 LEDs, dithered", 5000, wire_frame(2000, true));
+    BENCH("prepare only", 1000000, {
+        led_gamma_prepare(&lut, true);
+        test_sink += lut.dither_offset;
+    });
+
+    return test_finish("test_gamma");
+}
@@ -0,0 +1,99 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "json_sax.h"
+
+
+#define MAX_EVENTS              32
+
+static json_event events[MAX_EVENTS];
+static int event_count;
+
+
+static esp_err_t record(const json_event *event, void *ctx) {
+    (void)ctx;
+    if (event_count < MAX_EVENTS) events[event_count] = *event;
+    ++event_count;
+    return ESP_OK;
+}
+
+static esp_err_t parse(const char *json, size_t len) {
+    event_count = 0;
+    return json_sax_parse(json, len, record, NULL);
+}
+
+static esp_err_t parse_string(const char *json) {
+    return parse(json, strlen(json));
+}
+
+
+int main(void) {
+    static const char document[] =
+        "{\"state\": \"ON\", \"brightness\": 128, \"color\": {\"r\": 255, \"g\": 0, \"b\": 12}, "
+        "\"effect\": null, \"list\": [true, false, -1.5e1], \"text\": \"a\\\"b\\u00e9\"}";
+    CHECK_EQ(parse_string(document), ESP_OK);
+    CHECK_EQ(event_count, 25);
+    CHECK_EQ(events[0].type, JSON_OBJECT_START);
+    CHECK_EQ(events[1].type, JSON_KEY);
+    CHECK(events[1].str_len == 5 && !memcmp(events[1].str, "state", 5));
+    CHECK_EQ(events[2].type, JSON_STRING);
+    CHECK(events[2].str_len == 2 && !memcmp(events[2].str, "ON", 2));
+    CHECK_EQ(events[4].number, 128);
+    CHECK_EQ(events[7].depth, 2);
+    CHECK_EQ(events[8].number, 255);
+    CHECK_EQ(events[15].type, JSON_NULL);
+    CHECK_EQ(events[18].type, JSON_TRUE);
+    CHECK_EQ(events[19].type, JSON_FALSE);
+    CHECK_EQ(events[20].number, -15);
+    CHECK_EQ(events[23].str_len, 10);       // Escapes are validated, not decoded
+    CHECK_EQ(events[24].type, JSON_OBJECT_END);
+
+    // Numbers are truncated towards zero and saturate
+    CHECK_EQ(parse_string("0.99"), ESP_OK);
+    CHECK_EQ(events[0].number, 0);
+    CHECK_EQ(parse_string("-2.5"), ESP_OK);
+    CHECK_EQ(events[0].number, -2);
+    CHECK_EQ(parse_string("1e20"), ESP_OK);
+    CHECK_EQ(events[0].number, INT32_MAX);
+
+    // Fixed point reads keep the fraction
+    CHECK_EQ(parse_string("0.4"), ESP_OK);
+    CHECK_EQ(json_number_scaled(&events[0], 3), 400);
+    CHECK_EQ(parse_string("-1.25"), ESP_OK);
+    CHECK_EQ(json_number_scaled(&events[0], 3), -1250);
+    CHECK_EQ(json_number_scaled(&events[0], 1), -12);
+    CHECK_EQ(parse_string("25e-3"), ESP_OK);
+    CHECK_EQ(json_number_scaled(&events[0], 3), 25);
+    CHECK_EQ(parse_string("3"), ESP_OK);
+    CHECK_EQ(json_number_scaled(&events[0], 3), 3000);
+    CHECK_EQ(parse_string("0.0004"), ESP_OK);
+    CHECK_EQ(json_number_scaled(&events[0], 3), 0);
+    CHECK_EQ(parse_string("1e7"), ESP_OK);
+    CHECK_EQ(json_number_scaled(&events[0], 3), INT32_MAX);
+    CHECK_EQ(parse_string("-1e7"), ESP_OK);
+    CHECK_EQ(json_number_scaled(&events[0], 3), -INT32_MAX);
+
+    // Malformed and truncated documents
+    CHECK_EQ(parse_string("{\"a\": 1,}"), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(parse_string("{\"a\" 1}"), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(parse_string("[1, 2"), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(parse_string("\"abc"), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(parse_string("01"), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(parse_string("\"\\x\""), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(parse_string("\"\\u12g4\""), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(parse_string("\"a\tb\""), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(parse_string("[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]"), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(parse_string("{} {}"), ESP_ERR_INVALID_ARG);
+
+    // A backslash before a NUL inside the buffer is not an escape, nor is one at the very end
+    static const char nul_escape[] = { '"', 'a', '\\', '\0', '"' };
+    CHECK_EQ(parse(nul_escape, sizeof(nul_escape)), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(parse("\"a\\", 3), ESP_ERR_INVALID_SIZE);
+
+    BENCH("parse light command", 200000, {
+        test_sink += json_sax_parse(document, sizeof(document) - 1, record, NULL);
+        event_count = 0;
+    });
+
+    return test_finish("test_json_sax");
+}
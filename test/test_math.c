@@ -0,0 +1,103 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "test_support.h"
+#include "led_math.h"
+
+
+#define SIN_MAX_ERROR           (1.0 / 8192)    // What led_math.h promises
+#define NOISE_MAX_STEP          3               // Smoothstep slope is at most 1.5, plus rounding
+#define RANDOM_SAMPLES          100000
+#define RANDOM_BUCKETS          10
+
+
+int main(void) {
+    // Lerp is exact at both ends in both directions and rounds to nearest in between
+    CHECK_EQ(led_lerp8(255, 0, 0), 255);
+    CHECK_EQ(led_lerp8(255, 0, 255), 0);
+    CHECK_EQ(led_lerp8(0, 255, 0), 0);
+    CHECK_EQ(led_lerp8(0, 255, 255), 255);
+    int lerp_mismatches = 0;
+    for (int from = 0; from < 256; ++from) {
+        for (int to = 0; to < 256; ++to) {
+            for (int amount = 0; amount < 256; ++amount) {
+                long expected = lround((from * (255.0 - amount) + to * amount) / 255);
+                if (led_lerp8(from, to, amount) != expected) ++lerp_mismatches;
+            }
+        }
+    }
+    CHECK_EQ(lerp_mismatches, 0);
+
+    // Sine against libm over every angle
+    double sin_max_error = 0;
+    for (int angle = 0; angle < 65536; ++angle) {
+        double error = fabs(led_sin16(angle) / 32767.0 - sin(angle * 2 * M_PI / 65536));
+        if (error > sin_max_error) sin_max_error = error;
+    }
+    printf("  sin16 max error %.2e\n", sin_max_error);
+    CHECK(sin_max_error < SIN_MAX_ERROR);
+    CHECK_EQ(led_sin16(0), 0);
+    CHECK_EQ(led_sin16(16384), 32767);
+    CHECK_EQ(led_sin16(32768), 0);
+    CHECK_EQ(led_sin16(49152), -32767);
+    CHECK_EQ(led_cos16(0), 32767);
+    CHECK_EQ(led_sin8(0), 128);
+    CHECK_EQ(led_sin8(64), 255);
+    CHECK_EQ(led_sin8(192), 0);
+
+    CHECK_EQ(led_scale16(65535, 65535), 65535);
+    CHECK_EQ(led_scale16(65535, 0), 0);
+    CHECK_EQ(led_scale16(1000, 32767), 500);
+    CHECK_EQ(led_mul_q15(16384, 16384), 8192);
+    CHECK_EQ(led_mul_q15(-32768, 32767), -32767);
+
+    // Noise is smooth between lattice points, varied across them and seamless where coordinates wrap
+    int noise_max_step = 0;
+    int noise_min = 255;
+    int noise_max = 0;
+    for (int x = 0; x < 65536; ++x) {
+        int value = led_noise8(x);
+        int step = abs(value - led_noise8((x + 1) & 0xFFFF));
+        if (step > noise_max_step) noise_max_step = step;
+        if (value < noise_min) noise_min = value;
+        if (value > noise_max) noise_max = value;
+    }
+    CHECK(noise_max_step <= NOISE_MAX_STEP);
+    CHECK(noise_max - noise_min > 200);
+    int noise_2d_max_step = 0;
+    for (int y = 0; y < 65536; y += 97) {
+        for (int x = 0; x < 65536; x += 89) {
+            int value = led_noise8_2d(x, y);
+            int step_x = abs(value - led_noise8_2d((x + 1) & 0xFFFF, y));
+            int step_y = abs(value - led_noise8_2d(x, (y + 1) & 0xFFFF));
+            if (step_x > noise_2d_max_step) noise_2d_max_step = step_x;
+            if (step_y > noise_2d_max_step) noise_2d_max_step = step_y;
+        }
+    }
+    CHECK(noise_2d_max_step <= NOISE_MAX_STEP);
+    CHECK(abs(led_noise8_2d(0xFFFF, 0x1234) - led_noise8_2d(0, 0x1234)) <= NOISE_MAX_STEP);
+
+    // A zero seed is replaced, and bounded values cover their range evenly
+    led_rng_t rng;
+    led_rng_seed(&rng, 0);
+    CHECK(rng.state != 0);
+    int buckets[RANDOM_BUCKETS] = { 0 };
+    for (int i = 0; i < RANDOM_SAMPLES; ++i) {
+        uint32_t value = led_random_below(&rng, RANDOM_BUCKETS);
+        if (value < RANDOM_BUCKETS) ++buckets[value];
+    }
+    int bucket_total = 0;
+    for (int i = 0; i < RANDOM_BUCKETS; ++i) {
+        CHECK(abs(buckets[i] - RANDOM_SAMPLES / RANDOM_BUCKETS) < RANDOM_SAMPLES / RANDOM_BUCKETS / 10);
+        bucket_total += buckets[i];
+    }
+    CHECK_EQ(bucket_total, RANDOM_SAMPLES);
+
+    BENCH("led_sin16", 10000000, test_sink += led_sin16(bench_i * 40503));
+    BENCH("sinf", 10000000, test_sink += (int32_t)(sinf(bench_i * 40503 * (float)(2 * M_PI / 65536)) * 32767));
+    BENCH("led_lerp8", 10000000, test_sink += led_lerp8(bench_i, bench_i >> 8, bench_i >> 16));
+    BENCH("led_noise8_2d", 10000000, test_sink += led_noise8_2d(bench_i * 37, bench_i * 11));
+    BENCH("led_random8", 10000000, test_sink += led_random8(&rng));
+
+    return test_finish("test_math");
+}
@@ -0,0 +1,280 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "smart_led_mqtt_rx.h"
+#include "led_frame_buffer.h"
+#include "led_frame_codec.h"
+#include "led_anim_cache.h"
+#include "led_effect.h"
+#include "../components/mqtt_protocl_lib/include/mqtt_parser.h"
+#include "../components/mqtt_protocl_lib/include/mqtt_protocol.h"
+#include "../components/mqtt_protocl_lib/include/mqtt_client_api.h"
+
+
+#define SOCK                    7
+#define TCP_SEGMENT             1460        // What a read returns from a busy stream, one Ethernet MSS
+#define STREAM_FRAMES           64
+
+static int frames_received;
+static int pubacks;
+static uint16_t last_puback;
+static int publishes;
+static int anim_messages;
+static esp_err_t anim_result;
+static int programs;
+static int handled;
+static int handled_types[16];
+static int handled_msg_numbers[16];
+static int handler_result;
+
+static uint8_t frames[3][LED_FRAME_BYTES];
+static uint8_t stream[STREAM_FRAMES * (LED_FRAME_BYTES + 64)];
+
+
+int64_t esp_timer_get_time(void) {
+    return 0;
+}
+
+void stream_frame_received(void) {
+    ++frames_received;
+}
+
+int mqtt_client_send_puback(uint16_t pkt_id, int sock) {
+    ++pubacks;
+    last_puback = pkt_id;
+    return sock == SOCK ? 0 : -1;
+}
+
+int publish(mqtt_publish pub, uint8_t pub_flags, int sock) {
+    ++publishes;
+    return pub.payload_len;
+}
+
+esp_err_t led_anim_handle_message(const uint8_t *data, size_t len) {
+    ++anim_messages;
+    return anim_result;
+}
+
+uint32_t led_anim_upload_written(void) {
+    return 0;
+}
+
+esp_err_t led_effect_load_program(const uint8_t *data, size_t len) {
+    ++programs;
+    return ESP_OK;
+}
+
+/* Everything the streaming topics don't take */
+static int record_packet(uint8_t *packet, size_t len, int sock, int msg_number) {
+    if (handled < 16) {
+        handled_types[handled] = packet[0] & TYPE_MASK;
+        handled_msg_numbers[handled] = msg_number;
+    }
+    ++handled;
+    return handler_result;
+}
+
+
+/* Appends a PUBLISH on `topic` to `out` and returns its length */
+static size_t publish_packet(uint8_t *out, const char *topic, uint16_t pkt_id, const uint8_t *payload,
+                             size_t payload_len) {
+    size_t topic_len = strlen(topic);
+    uint32_t remaining = 2 + topic_len + (pkt_id ? 2 : 0) + payload_len;
+    size_t len = 0;
+    out[len++] = PUBLISH_TYPE | (pkt_id ? PUBLISH_QOS_1 : PUBLISH_QOS_0);
+    do {
+        out[len] = remaining % 128;
+        remaining /= 128;
+        if (remaining) out[len] |= 128;
+        ++len;
+    } while (remaining);
+    out[len++] = topic_len >> 8;
+    out[len++] = topic_len;
+    memcpy(out + len, topic, topic_len);
+    len += topic_len;
+    if (pkt_id) {
+        out[len++] = pkt_id >> 8;
+        out[len++] = pkt_id;
+    }
+    if (payload) memcpy(out + len, payload, payload_len);
+    return len + payload_len;
+}
+
+static size_t connack_packet(uint8_t *out) {
+    memcpy(out, (const uint8_t[]){ CONNACK_TYPE, 2, 0, 0 }, 4);
+    return 4;
+}
+
+static size_t pingresp_packet(uint8_t *out) {
+    memcpy(out, (const uint8_t[]){ PINGRESP_TYPE, 0 }, 2);
+    return 2;
+}
+
+/* Passes `len` bytes of `data` to the splitter in reads of at most `read_len`, as many as fit in its buffer */
+static int feed(const uint8_t *data, size_t len, size_t read_len) {
+    while (len) {
+        size_t space;
+        uint8_t *rx_space = smart_led_mqtt_rx_space(&space);
+        size_t chunk = len < read_len ? len : read_len;
+        if (chunk > space) chunk = space;
+        memcpy(rx_space, data, chunk);
+        if (smart_led_mqtt_rx_received(chunk)) return -1;
+        data += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/* A new connection, past its CONNACK */
+static void connect(void) {
+    uint8_t connack[4];
+    smart_led_mqtt_rx_init(SOCK, record_packet);
+    handled = 0;
+    feed(connack, connack_packet(connack), sizeof(connack));
+}
+
+static bool latest_is(const uint8_t *frame) {
+    const uint8_t *latest = led_fb_take_latest();
+    return latest && !memcmp(latest, frame, LED_FRAME_BYTES);
+}
+
+
+int main(void) {
+    static uint8_t packet[MQTT_RX_BUFF_SIZE * 4];
+    CHECK_EQ(led_fb_init(), ESP_OK);
+    for (int f = 0; f < 3; ++f) {
+        for (size_t i = 0; i < LED_FRAME_BYTES; ++i) frames[f][i] = i * 7 + f * 31;
+    }
+
+    // The first packet is the CONNACK, whatever it is: even a frame goes to the handler
+    smart_led_mqtt_rx_init(SOCK, record_packet);
+    size_t len = publish_packet(packet, FRAME_TOPIC, 0, frames[0], LED_FRAME_BYTES);
+    CHECK_EQ(feed(packet, len, len), 0);
+    CHECK_EQ(handled, 1);
+    CHECK_EQ(handled_msg_numbers[0], 0);
+    CHECK_EQ(frames_received, 0);
+
+    // Coalesced: a CONNACK, two frames and a PINGRESP in one read
+    smart_led_mqtt_rx_init(SOCK, record_packet);
+    handled = 0;
+    len = connack_packet(packet);
+    len += publish_packet(packet + len, FRAME_TOPIC, 0, frames[0], LED_FRAME_BYTES);
+    len += publish_packet(packet + len, FRAME_TOPIC, 0, frames[1], LED_FRAME_BYTES);
+    len += pingresp_packet(packet + len);
+    CHECK(len <= MQTT_RX_BUFF_SIZE);
+    CHECK_EQ(feed(packet, len, len), 0);
+    CHECK_EQ(frames_received, 2);
+    CHECK(latest_is(frames[1]));
+    CHECK_EQ(handled, 2);
+    CHECK_EQ(handled_types[0], CONNACK_TYPE);
+    CHECK_EQ(handled_types[1], PINGRESP_TYPE);
+    CHECK_EQ(handled_msg_numbers[1], 3);
+    CHECK(led_fb_take_latest() == NULL);
+
+    // Partial: a frame cut in two at every byte, the header and the topic included
+    len = publish_packet(packet, FRAME_TOPIC, 0, frames[2], LED_FRAME_BYTES);
+    int split_mismatches = 0;
+    for (size_t split = 1; split < len; ++split) {
+        connect();
+        frames_received = 0;
+        if (feed(packet, split, split) || frames_received != 0 || feed(packet + split, len - split, len) ||
+            frames_received != 1 || !latest_is(frames[2])) {
+            ++split_mismatches;
+        }
+    }
+    CHECK_EQ(split_mismatches, 0);
+
+    // And three frames a byte at a time
+    connect();
+    frames_received = 0;
+    len = 0;
+    for (int f = 0; f < 3; ++f) len += publish_packet(packet + len, FRAME_TOPIC, 0, frames[f], LED_FRAME_BYTES);
+    CHECK_EQ(feed(packet, len, 1), 0);
+    CHECK_EQ(frames_received, 3);
+    CHECK(latest_is(frames[2]));
+    CHECK_EQ(handled, 1);
+
+    // Short frames blank the tail, QoS 1 frames are acknowledged, frames longer than the strip are dropped
+    static uint8_t expected[LED_FRAME_BYTES];
+    memcpy(expected, frames[1], 30);
+    len = publish_packet(packet, FRAME_TOPIC, 0x1234, frames[1], 30);
+    CHECK_EQ(feed(packet, len, len), 0);
+    CHECK(latest_is(expected));
+    CHECK_EQ(last_puback, 0x1234);
+    static uint8_t too_long[LED_FRAME_BYTES + 3];
+    frames_received = 0;
+    len = publish_packet(packet, FRAME_TOPIC, 0x1235, too_long, sizeof(too_long));
+    CHECK_EQ(feed(packet, len, len), 0);
+    CHECK_EQ(frames_received, 0);
+    CHECK(led_fb_take_latest() == NULL);
+    CHECK_EQ(last_puback, 0x1235);
+
+    // Encoded frames apply onto the newest frame, malformed ones change nothing
+    static uint8_t encoded[LED_FRAME_BYTES * 2];
+    len = publish_packet(packet, FRAME_TOPIC, 0, frames[0], LED_FRAME_BYTES);
+    size_t encoded_len = led_frame_encode(frames[1], frames[0], LED_FRAME_BYTES, encoded, sizeof(encoded));
+    len += publish_packet(packet + len, DELTA_TOPIC, 0, encoded, encoded_len);
+    CHECK_EQ(feed(packet, len, TCP_SEGMENT), 0);
+    CHECK(latest_is(frames[1]));
+    frames_received = 0;
+    len = publish_packet(packet, DELTA_TOPIC, 0, encoded, encoded_len / 2);
+    CHECK_EQ(feed(packet, len, len), 0);
+    CHECK_EQ(frames_received, 0);
+    CHECK(led_fb_take_latest() == NULL);
+
+    // Clip and program messages go to their modules; a rejected clip message publishes its status
+    anim_result = ESP_ERR_INVALID_SIZE;
+    len = publish_packet(packet, ANIM_TOPIC, 9, (const uint8_t[]){ ANIM_OP_STOP }, 1);
+    len += publish_packet(packet + len, PROGRAM_TOPIC, 10, frames[0], 40);
+    CHECK_EQ(feed(packet, len, len), 0);
+    CHECK_EQ(anim_messages, 1);
+    CHECK_EQ(publishes, 1);
+    CHECK_EQ(programs, 1);
+    CHECK_EQ(last_puback, 10);
+    CHECK_EQ(handled, 1);
+
+    // A publish larger than the buffer is skipped across reads, and acknowledged; the stream carries on after it
+    connect();
+    pubacks = 0;
+    frames_received = 0;
+    static uint8_t large[MQTT_RX_BUFF_SIZE * 2];
+    len = publish_packet(packet, LED_TOPIC, 77, large, sizeof(large));
+    len += publish_packet(packet + len, FRAME_TOPIC, 0, frames[2], LED_FRAME_BYTES);
+    len += pingresp_packet(packet + len);
+    CHECK_EQ(feed(packet, len, TCP_SEGMENT), 0);
+    CHECK_EQ(pubacks, 1);
+    CHECK_EQ(last_puback, 77);
+    CHECK_EQ(frames_received, 1);
+    CHECK(latest_is(frames[2]));
+    CHECK_EQ(handled, 2);
+    CHECK_EQ(handled_msg_numbers[1], 3);
+
+    // Malformed lengths and failed handlers drop the connection
+    connect();
+    CHECK_EQ(feed((const uint8_t[]){ PUBLISH_TYPE, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 }, 6, 6), -1);
+    connect();
+    handler_result = -1;
+    len = pingresp_packet(packet);
+    CHECK_EQ(feed(packet, len, len), -1);
+    handler_result = 0;
+
+    // Throughput: a stream of frames read a TCP segment at a time, from the read to the committed frame
+    size_t stream_len = 0;
+    for (int f = 0; f < STREAM_FRAMES; ++f) {
+        stream_len += publish_packet(stream + stream_len, FRAME_TOPIC, 0, frames[f % 3], LED_FRAME_BYTES);
+    }
+    printf("  %d frames, %zu bytes per frame publish\n", STREAM_FRAMES, stream_len / STREAM_FRAMES);
+    connect();
+    frames_received = 0;
+    int64_t start = test_now_ns();
+    for (int i = 0; i < 200; ++i) {
+        feed(stream, stream_len, TCP_SEGMENT);
+        test_sink += led_fb_take_latest() != NULL;
+    }
+    double elapsed_s = (test_now_ns() - start) / 1e9;
+    CHECK_EQ(frames_received, 200 * STREAM_FRAMES);
+    printf("  %-40s %10.0f frames/s\n", "frames, read in TCP segments", frames_received / elapsed_s);
+    printf("  %-40s %10.1f ns\n", "per frame", elapsed_s * 1e9 / frames_received);
+
+    return test_finish("test_mqtt_rx");
+}
@@ -0,0 +1,111 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "led_pixel_map.h"
+#include "led_frame_buffer.h"
+#include "led_strip_encoder.h"
+
+
+#define GRID_WIDTH              20
+#define GRID_HEIGHT             15
+
+static uint8_t frame[LED_FRAME_BYTES];
+
+
+/* Position of the LED at `led` in wiring order, turned clockwise one quarter at a time */
+static void reference_position(const led_map_config_t *config, size_t led, int *x, int *y) {
+    int width = config->width;
+    int height = config->height;
+    *y = led / width;
+    *x = led % width;
+    if (config->serpentine && (*y & 1)) *x = width - 1 - *x;
+    for (int turn = 0; turn < config->rotation; ++turn) {
+        int turned_x = height - 1 - *y;
+        *y = *x;
+        *x = turned_x;
+        int turned_width = height;
+        height = width;
+        width = turned_width;
+    }
+}
+
+/* Every LED of the matrix lands where the reference puts it, and LEDs past the matrix keep their index */
+static bool matrix_matches(const led_map_config_t *config) {
+    if (led_map_init(config) != ESP_OK) return false;
+    const uint16_t *table = led_map_table();
+    size_t matrix_leds = config->width * config->height;
+    for (size_t led = 0; led < LED_COUNT; ++led) {
+        if (led >= matrix_leds) {
+            if (table[led] != led) return false;
+            continue;
+        }
+        int x, y;
+        reference_position(config, led, &x, &y);
+        if (table[led] != led_map_index(x, y)) return false;
+    }
+    return true;
+}
+
+
+int main(void) {
+    led_map_config_t linear = { .layout = LED_MAP_LINEAR };
+    CHECK_EQ(led_map_init(&linear), ESP_OK);
+    CHECK(led_map_table() == NULL);
+    CHECK_EQ(led_map_width(), LED_COUNT);
+    CHECK_EQ(led_map_height(), 1);
+
+    // Every rotation, wired straight and serpentine, on the full grid and on one smaller than the strip
+    int matrix_mismatches = 0;
+    for (int rotation = 0; rotation < 4; ++rotation) {
+        for (int serpentine = 0; serpentine < 2; ++serpentine) {
+            led_map_config_t full = { .layout = LED_MAP_MATRIX, .width = GRID_WIDTH, .height = GRID_HEIGHT,
+                                      .serpentine = serpentine, .rotation = rotation };
+            led_map_config_t partial = { .layout = LED_MAP_MATRIX, .width = 7, .height = 9,
+                                         .serpentine = serpentine, .rotation = rotation };
+            if (!matrix_matches(&full)) ++matrix_mismatches;
+            if (!matrix_matches(&partial)) ++matrix_mismatches;
+        }
+    }
+    CHECK_EQ(matrix_mismatches, 0);
+
+    // A quarter turn swaps the logical grid's sides
+    led_map_config_t turned = { .layout = LED_MAP_MATRIX, .width = 7, .height = 9, .rotation = 1 };
+    CHECK_EQ(led_map_init(&turned), ESP_OK);
+    CHECK_EQ(led_map_width(), 9);
+    CHECK_EQ(led_map_height(), 7);
+    CHECK_EQ(led_map_index(8, 6), 6 * 9 + 8);
+    CHECK_EQ(led_map_index(9, 0), LED_MAP_NONE);
+    CHECK_EQ(led_map_index(0, -1), LED_MAP_NONE);
+
+    // Serpentine: the second wired row runs backwards
+    led_map_config_t serpentine = { .layout = LED_MAP_MATRIX, .width = GRID_WIDTH, .height = GRID_HEIGHT,
+                                    .serpentine = true };
+    CHECK_EQ(led_map_init(&serpentine), ESP_OK);
+    CHECK_EQ(led_map_table()[GRID_WIDTH], 2 * GRID_WIDTH - 1);
+    CHECK_EQ(led_map_table()[2 * GRID_WIDTH], 2 * GRID_WIDTH);
+
+    // Rejected configurations
+    led_map_config_t bad = { .layout = LED_MAP_MATRIX, .width = GRID_WIDTH, .height = GRID_HEIGHT, .rotation = 4 };
+    CHECK_EQ(led_map_init(&bad), ESP_ERR_INVALID_ARG);
+    bad = (led_map_config_t){ .layout = LED_MAP_MATRIX, .width = 0, .height = GRID_HEIGHT };
+    CHECK_EQ(led_map_init(&bad), ESP_ERR_INVALID_ARG);
+    bad = (led_map_config_t){ .layout = LED_MAP_MATRIX, .width = GRID_WIDTH, .height = GRID_HEIGHT + 1 };
+    CHECK_EQ(led_map_init(&bad), ESP_ERR_INVALID_SIZE);
+    bad = (led_map_config_t){ .layout = LED_MAP_CUSTOM };
+    CHECK_EQ(led_map_init(&bad), ESP_ERR_INVALID_SIZE);     // No pixel_map.csv in the host build
+    bad = (led_map_config_t){ .layout = LED_MAP_CUSTOM + 1 };
+    CHECK_EQ(led_map_init(&bad), ESP_ERR_INVALID_ARG);
+
+    // Gathering a frame in wiring order, as the encoders do, with and without the table
+    CHECK_EQ(led_map_init(&serpentine), ESP_OK);
+    led_strip_frame_t unmapped = { .pixels = frame, .pixel_count = LED_COUNT };
+    led_strip_frame_t mapped = { .pixels = frame, .map = led_map_table(), .pixel_count = LED_COUNT };
+    BENCH("gather frame, unmapped", 200000, {
+        for (size_t led = 0; led < LED_COUNT; ++led) test_sink += led_strip_frame_pixel(&unmapped, led)[1];
+    });
+    BENCH("gather frame, through the table", 200000, {
+        for (size_t led = 0; led < LED_COUNT; ++led) test_sink += led_strip_frame_pixel(&mapped, led)[1];
+    });
+
+    return test_finish("test_pixel_map");
+}
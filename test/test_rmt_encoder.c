@@ -0,0 +1,138 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_strip_encoder.h"
+
+
+#define PIXELS                  300
+#define RESOLUTION_HZ           10000000    // As the firmware configures the RMT channels
+#define TICK_NS                 (1000000000 / RESOLUTION_HZ)
+
+#if LED_CHIP == LED_CHIP_WS2812
+#define CHIP_NAME               "WS2812"
+#elif LED_CHIP == LED_CHIP_WS2811
+#define CHIP_NAME               "WS2811"
+#elif LED_CHIP == LED_CHIP_SK6812_RGBW
+#define CHIP_NAME               "SK6812_RGBW"
+#elif LED_CHIP == LED_CHIP_UCS8903
+#define CHIP_NAME               "UCS8903"
+#endif
+
+static uint16_t levels[256];
+static uint8_t pixels[PIXELS * LED_PIXEL_BYTES];
+static uint8_t expected[PIXELS * LED_WIRE_BYTES];
+static uint8_t decoded[PIXELS * LED_WIRE_BYTES];
+
+
+/* Wire bytes of every pixel of `frame`, dither offsets advancing as the encoder advances them */
+static void expected_frame(const led_strip_frame_t *frame, uint8_t *out) {
+    uint8_t offset = frame->dither_offset;
+    for (size_t pixel = 0; pixel < frame->pixel_count; ++pixel) {
+        led_wire_pixel(led_strip_frame_pixel(frame, pixel), frame->levels, offset, out + pixel * LED_WIRE_BYTES);
+        offset += frame->dither_stride;
+    }
+}
+
+/* Whether a high and low time are the chip's, to within the tick the durations are rounded down to */
+static bool is_bit(rmt_symbol_word_t symbol, int high_ns, int low_ns) {
+    int high = symbol.duration0 * TICK_NS, low = symbol.duration1 * TICK_NS;
+    return symbol.level0 == 1 && symbol.level1 == 0 && high <= high_ns && high > high_ns - TICK_NS &&
+           low <= low_ns && low > low_ns - TICK_NS;
+}
+
+/* Encodes `frame` with the refill interrupt freeing `refill` symbols at a time, decodes the symbols back into
+ * wire bytes and checks them and the closing reset code */
+static bool encodes_to(rmt_encoder_handle_t encoder, const led_strip_frame_t *frame, size_t refill,
+                       const uint8_t *wire) {
+    rmt_host_set_refill(refill);
+    rmt_encode_state_t state = RMT_ENCODING_RESET;
+    size_t returned = encoder->encode(encoder, NULL, frame, sizeof(*frame), &state);
+    size_t count;
+    const rmt_symbol_word_t *symbols = rmt_host_symbols(&count);
+    size_t wire_bytes = frame->pixel_count * LED_WIRE_BYTES;
+    if (state != RMT_ENCODING_COMPLETE || returned != count || count != wire_bytes * 8 + 1) return false;
+
+    memset(decoded, 0, wire_bytes);
+    for (size_t bit = 0; bit < wire_bytes * 8; ++bit) {
+        if (is_bit(symbols[bit], LED_T1H_NS, LED_T1L_NS)) {
+            decoded[bit / 8] |= 0x80 >> (bit % 8);
+        } else if (!is_bit(symbols[bit], LED_T0H_NS, LED_T0L_NS)) {
+            return false;
+        }
+    }
+    rmt_symbol_word_t reset = symbols[count - 1];
+    int reset_ns = (reset.duration0 + reset.duration1) * TICK_NS;
+    return !memcmp(decoded, wire, wire_bytes) && reset.level0 == 0 && reset.level1 == 0 &&
+           reset_ns == LED_RESET_US * 1000;
+}
+
+
+int main(void) {
+    printf("  %s: %d symbols per pixel, bits %d/%d ns and %d/%d ns\n", CHIP_NAME, LED_WIRE_BYTES * 8,
+           LED_T0H_NS, LED_T0L_NS, LED_T1H_NS, LED_T1L_NS);
+
+    for (int v = 0; v < 256; ++v) levels[v] = v * v;
+    srand(1);
+    for (size_t i = 0; i < sizeof(pixels); ++i) pixels[i] = rand();
+
+    rmt_encoder_handle_t encoder, other;
+    CHECK_EQ(rmt_new_led_strip_encoder(NULL, &encoder), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(rmt_new_led_strip_encoder(&(led_strip_encoder_config_t){ .resolution = RESOLUTION_HZ }, &encoder),
+             ESP_OK);
+    CHECK_EQ(rmt_new_led_strip_encoder(&(led_strip_encoder_config_t){ .resolution = RESOLUTION_HZ / 2 }, &other),
+             ESP_ERR_INVALID_ARG);
+
+    // Refills smaller than a byte, a byte, inside a pixel, a pixel and longer; the encoder resumes wherever the
+    // last one ended, mid-pixel included, and dithers on as if it had never stopped
+    static const size_t refills[] = { 1, 5, 8, 12, 13, LED_WIRE_BYTES * 8, LED_WIRE_BYTES * 8 + 9, 32, 64, 100,
+                                      PIXELS * LED_WIRE_BYTES * 8 + 1 };
+    led_strip_frame_t frame = {
+        .pixels = pixels, .pixel_count = PIXELS, .levels = levels, .dither_offset = 37, .dither_stride = 71,
+    };
+    expected_frame(&frame, expected);
+    int refill_mismatches = 0;
+    for (size_t i = 0; i < sizeof(refills) / sizeof(refills[0]); ++i) {
+        if (!encodes_to(encoder, &frame, refills[i], expected)) {
+            printf("  refills of %zu symbols decode wrong\n", refills[i]);
+            ++refill_mismatches;
+        }
+        CHECK_EQ(rmt_encoder_reset(encoder), ESP_OK);
+    }
+    CHECK_EQ(refill_mismatches, 0);
+
+    // Short strips, one pixel and none, end in the reset code all the same
+    for (size_t count = 0; count <= 3; ++count) {
+        frame.pixel_count = count;
+        expected_frame(&frame, expected);
+        CHECK(encodes_to(encoder, &frame, 13, expected));
+    }
+
+    // Map and palette
+    static uint16_t reversed[PIXELS];
+    static led_rgb_t palette[256];
+    for (int i = 0; i < PIXELS; ++i) reversed[i] = PIXELS - 1 - i;
+    for (int i = 0; i < 256; ++i) palette[i] = (led_rgb_t){ i, 255 - i, i / 2 };
+    led_strip_frame_t mapped = { .pixels = pixels, .palette = palette, .map = reversed, .pixel_count = PIXELS,
+                                 .levels = levels, .dither_offset = 200, .dither_stride = 3 };
+    expected_frame(&mapped, expected);
+    CHECK(encodes_to(encoder, &mapped, 12, expected));
+
+    // The refill interrupt's share of a frame: 64 symbol refills as on the wire, against one refill for all
+    frame.pixel_count = PIXELS;
+    rmt_encode_state_t state;
+    rmt_host_set_refill(64);
+    BENCH("encode 300 pixels, 64 symbol refills", 5000, {
+        frame.dither_offset = bench_i;
+        test_sink += encoder->encode(encoder, NULL, &frame, sizeof(frame), &state);
+    });
+    rmt_host_set_refill(PIXELS * LED_WIRE_BYTES * 8 + 1);
+    BENCH("encode 300 pixels, one refill", 5000, {
+        frame.dither_offset = bench_i;
+        test_sink += encoder->encode(encoder, NULL, &frame, sizeof(frame), &state);
+    });
+
+    CHECK_EQ(rmt_del_encoder(encoder), ESP_OK);
+    return test_finish("test_rmt_encoder " CHIP_NAME);
+}
@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "smart_led_json.h"
+#include "led_effect.h"
+#include "led_transition.h"
+
+
+static const smart_led_state_t initial = {
+    .on = 1, .brightness = 100, .red = 10, .green = 20, .blue = 30, .effect = LED_EFFECT_NONE, .text = "hi",
+};
+
+// A command as Home Assistant sends it, and one padded with the kind of metadata other controllers add
+static const char command[] =
+    "{\"state\": \"ON\", \"brightness\": 180, \"color\": {\"r\": 255, \"g\": 80, \"b\": 0}, \"transition\": 0.4}";
+static char padded[4096];
+
+
+/* The effect registry, cut down to the names the commands use */
+int led_effect_find(const char *name, size_t len) {
+    if (len == 4 && !memcmp(name, "none", 4)) return LED_EFFECT_NONE;
+    if (len == 7 && !memcmp(name, "rainbow", 7)) return LED_EFFECT_RAINBOW;
+    return -1;
+}
+
+
+static esp_err_t apply(const char *json, smart_led_state_t *state, uint32_t *transition_ms) {
+    *state = initial;
+    *transition_ms = 1234;
+    return smart_led_apply_json(json, strlen(json), state, transition_ms);
+}
+
+
+/*
+ * The baseline: a DOM parser in the style of cJSON, one heap node per value with copies of keys and strings,
+ * then lookups over the tree. The counting allocator gives its peak heap use.
+ */
+
+typedef enum { DOM_OBJECT, DOM_ARRAY, DOM_STRING, DOM_NUMBER, DOM_LITERAL } dom_type;
+
+typedef struct dom_node {
+    dom_type type;
+    char *key;
+    char *string;
+    double number;
+    struct dom_node *child;
+    struct dom_node *next;
+} dom_node;
+
+static size_t dom_live_bytes, dom_peak_bytes, dom_allocations;
+
+static void *dom_alloc(size_t size) {
+    size_t *block = malloc(sizeof(size_t) + size);
+    if (!block) return NULL;
+    *block = size;
+    dom_live_bytes += size;
+    if (dom_live_bytes > dom_peak_bytes) dom_peak_bytes = dom_live_bytes;
+    ++dom_allocations;
+    return block + 1;
+}
+
+static void dom_release(void *ptr) {
+    if (!ptr) return;
+    size_t *block = (size_t *)ptr - 1;
+    dom_live_bytes -= *block;
+    free(block);
+}
+
+static void dom_free(dom_node *node) {
+    while (node) {
+        dom_node *next = node->next;
+        dom_free(node->child);
+        dom_release(node->key);
+        dom_release(node->string);
+        dom_release(node);
+        node = next;
+    }
+}
+
+static void dom_skip_space(const char **p, const char *end) {
+    while (*p < end && (**p == ' ' || **p == '\t' || **p == '\n' || **p == '\r')) ++*p;
+}
+
+/* A copy of the string at `p`, escapes left as they are */
+static char *dom_string(const char **p, const char *end) {
+    const char *start = ++*p;
+    while (*p < end && **p != '"') *p += **p == '\\' ? 2 : 1;
+    if (*p >= end) return NULL;
+    char *copy = dom_alloc(*p - start + 1);
+    if (!copy) return NULL;
+    memcpy(copy, start, *p - start);
+    copy[*p - start] = '\0';
+    ++*p;
+    return copy;
+}
+
+static dom_node *dom_value(const char **p, const char *end, int depth) {
+    dom_skip_space(p, end);
+    if (*p >= end || depth > 16) return NULL;
+    dom_node *node = dom_alloc(sizeof(*node));
+    if (!node) return NULL;
+    memset(node, 0, sizeof(*node));
+
+    char c = **p;
+    if (c == '{' || c == '[') {
+        node->type = c == '{' ? DOM_OBJECT : DOM_ARRAY;
+        dom_node **tail = &node->child;
+        ++*p;
+        dom_skip_space(p, end);
+        if (*p < end && **p == (c == '{' ? '}' : ']')) {
+            ++*p;
+            return node;
+        }
+        while (*p < end) {
+            char *key = NULL;
+            if (c == '{') {
+                dom_skip_space(p, end);
+                if (*p >= end || **p != '"' || !(key = dom_string(p, end))) break;
+                dom_skip_space(p, end);
+                if (*p >= end || **p != ':') {
+                    dom_release(key);
+                    break;
+                }
+                ++*p;
+            }
+            dom_node *child = dom_value(p, end, depth + 1);
+            if (!child) {
+                dom_release(key);
+                break;
+            }
+            child->key = key;
+            *tail = child;
+            tail = &child->next;
+            dom_skip_space(p, end);
+            if (*p < end && **p == ',') {
+                ++*p;
+                continue;
+            }
+            if (*p < end && **p == (c == '{' ? '}' : ']')) {
+                ++*p;
+                return node;
+            }
+            break;
+        }
+    } else if (c == '"') {
+        node->type = DOM_STRING;
+        if ((node->string = dom_string(p, end))) return node;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        node->type = DOM_NUMBER;
+        char *number_end;
+        node->number = strtod(*p, &number_end);     // The documents here are NUL terminated
+        *p = number_end;
+        return node;
+    } else {
+        static const char *const literals[] = { "true", "false", "null" };
+        for (int i = 0; i < 3; ++i) {
+            size_t len = strlen(literals[i]);
+            if (end - *p >= (ptrdiff_t)len && !memcmp(*p, literals[i], len)) {
+                node->type = DOM_LITERAL;
+                *p += len;
+                return node;
+            }
+        }
+    }
+    dom_free(node);
+    return NULL;
+}
+
+static const dom_node *dom_get(const dom_node *object, const char *key) {
+    for (const dom_node *child = object->child; child; child = child->next) {
+        if (!strcmp(child->key, key)) return child;
+    }
+    return NULL;
+}
+
+/* smart_led_apply_json for the keys the benchmark documents use, through the tree */
+static esp_err_t dom_apply_json(const char *payload, size_t len, smart_led_state_t *state, uint32_t *transition_ms) {
+    const char *p = payload;
+    dom_node *root = dom_value(&p, payload + len, 0);
+    if (!root || root->type != DOM_OBJECT) {
+        dom_free(root);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    smart_led_state_t staged = *state;
+    esp_err_t ret = ESP_OK;
+    const dom_node *item = dom_get(root, "state");
+    if (item && item->type == DOM_STRING) staged.on = !strcmp(item->string, "ON");
+    if ((item = dom_get(root, "brightness")) && item->type == DOM_NUMBER) {
+        staged.brightness = item->number < 0 ? 0 : item->number > 255 ? 255 : item->number;
+    }
+    const dom_node *color = dom_get(root, "color");
+    if (color && color->type == DOM_OBJECT) {
+        if ((item = dom_get(color, "r"))) staged.red = item->number;
+        if ((item = dom_get(color, "g"))) staged.green = item->number;
+        if ((item = dom_get(color, "b"))) staged.blue = item->number;
+    }
+    if ((item = dom_get(root, "transition"))) {
+        if (item->type != DOM_NUMBER || item->number < 0 || item->number * 1000 > LED_TRANSITION_MAX_MS) {
+            ret = ESP_ERR_INVALID_ARG;
+        } else {
+            *transition_ms = item->number * 1000;
+        }
+    }
+    dom_free(root);
+    if (ret == ESP_OK) *state = staged;
+    return ret;
+}
+
+
+/* Applies `json` `iterations` times with `fn` and prints the time per document and the throughput */
+static void bench_apply(const char *label, const char *json,
+                        esp_err_t (*fn)(const char *, size_t, smart_led_state_t *, uint32_t *), int iterations) {
+    size_t len = strlen(json);
+    smart_led_state_t state = initial;
+    uint32_t transition_ms;
+    int64_t start = test_now_ns();
+    for (int i = 0; i < iterations; ++i) test_sink += fn(json, len, &state, &transition_ms);
+    double ns = (double)(test_now_ns() - start) / iterations;
+    printf("  %-40s %10.1f ns  %7.1f MB/s\n", label, ns, len * 1e3 / ns);
+}
+
+
+int main(void) {
+    smart_led_state_t state;
+    uint32_t transition_ms;
+
+    // A full command
+    CHECK_EQ(apply(command, &state, &transition_ms), ESP_OK);
+    CHECK(state.on == 1 && state.brightness == 180 && state.red == 255 && state.green == 80 && state.blue == 0);
+    CHECK_EQ(transition_ms, 400);
+
+    // Partial commands change what they name and leave the rest
+    CHECK_EQ(apply("{\"brightness\": 7}", &state, &transition_ms), ESP_OK);
+    CHECK(state.brightness == 7 && state.on == 1 && state.red == 10 && state.green == 20 && state.blue == 30);
+    CHECK_EQ(transition_ms, 1234);
+    CHECK_EQ(apply("{\"color\": {\"g\": 99}}", &state, &transition_ms), ESP_OK);
+    CHECK(state.red == 10 && state.green == 99 && state.blue == 30 && state.brightness == 100);
+    CHECK_EQ(apply("{\"state\": \"TOGGLE\"}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(state.on, 0);
+    CHECK_EQ(apply("{\"effect\": \"rainbow\", \"text\": \"Hello\"}", &state, &transition_ms), ESP_OK);
+    CHECK(state.effect == LED_EFFECT_RAINBOW && !strcmp(state.text, "Hello") && state.text[6] == 0);
+    CHECK_EQ(apply("{\"color\": {\"h\": 120, \"s\": 100}}", &state, &transition_ms), ESP_OK);
+    CHECK(state.red == 0 && state.green == 255 && state.blue == 0);
+    CHECK_EQ(apply("{}", &state, &transition_ms), ESP_OK);
+    CHECK(!memcmp(&state, &initial, sizeof(state)));
+
+    // Out of range brightness and channels saturate, fractions truncate
+    CHECK_EQ(apply("{\"brightness\": 300}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(state.brightness, 255);
+    CHECK_EQ(apply("{\"brightness\": -5}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(state.brightness, 0);
+    CHECK_EQ(apply("{\"brightness\": 1e30}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(state.brightness, 255);
+    CHECK_EQ(apply("{\"brightness\": 12.9}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(state.brightness, 12);
+    CHECK_EQ(apply("{\"color\": {\"r\": 256, \"b\": -1}}", &state, &transition_ms), ESP_OK);
+    CHECK(state.red == 255 && state.blue == 0);
+
+    // Unknown keys are skipped, whatever they hold; known names nested inside them are not commands
+    CHECK_EQ(apply("{\"color_temp\": 300, \"extra\": {\"color\": {\"r\": 1}, \"brightness\": 2}, "
+                   "\"list\": [{\"state\": \"OFF\"}, null, true], \"r\": 3}", &state, &transition_ms), ESP_OK);
+    CHECK(!memcmp(&state, &initial, sizeof(state)));
+    CHECK_EQ(apply("{\"color\": {\"x\": 0.3, \"y\": [1, 2], \"r\": 4}}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(state.red, 4);
+
+    // Transitions: seconds with a fraction, or milliseconds, up to LED_TRANSITION_MAX_MS
+    CHECK_EQ(apply("{\"transition\": 2}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(transition_ms, 2000);
+    CHECK_EQ(apply("{\"transition\": 0}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(transition_ms, 0);
+    CHECK_EQ(apply("{\"transition_ms\": 250}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(transition_ms, 250);
+    CHECK_EQ(apply("{\"transition\": 60}", &state, &transition_ms), ESP_OK);
+    CHECK_EQ(transition_ms, LED_TRANSITION_MAX_MS);
+
+    // Bad values reject the whole command, whatever came before them
+    static const char *const rejected[] = {
+        "{\"brightness\": 50, \"transition\": -1}",
+        "{\"transition\": 60.001}",
+        "{\"transition\": 1e9}",
+        "{\"transition\": \"2\"}",
+        "{\"transition\": null}",
+        "{\"transition\": [1]}",
+        "{\"transition\": {\"s\": 1}}",
+        "{\"transition_ms\": 60001}",
+        "{\"transition_ms\": -1}",
+        "{\"state\": \"on\"}",
+        "{\"effect\": \"sparkles\"}",
+        "{\"color\": {\"h\": 361}}",
+        "{\"color\": {\"s\": -1}}",
+        "{\"text\": \"this text is longer than thirty-two\"}",
+        "[{\"state\": \"ON\"}]",
+        "{\"brightness\": 50,}",
+    };
+    int accepted = 0;
+    for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); ++i) {
+        if (apply(rejected[i], &state, &transition_ms) != ESP_ERR_INVALID_ARG ||
+            memcmp(&state, &initial, sizeof(state)) || transition_ms != 1234) {
+            printf("  accepted %s\n", rejected[i]);
+            ++accepted;
+        }
+    }
+    CHECK_EQ(accepted, 0);
+    CHECK_EQ(smart_led_apply_json(command, sizeof(command) - 10, &state, &transition_ms), ESP_ERR_INVALID_SIZE);
+
+    // The padded command: the same state through both parsers
+    int len = snprintf(padded, sizeof(padded), "{\"state\": \"ON\", \"device\": {\"name\": \"Shelf\", \"ids\": [");
+    for (int i = 0; i < 120; ++i) len += snprintf(padded + len, sizeof(padded) - len, "%s\"id-%03d\"", i ? ", " : "", i);
+    snprintf(padded + len, sizeof(padded) - len, "], \"sw\": 1.2}, \"brightness\": 180, \"transition\": 0.4, "
+             "\"color\": {\"r\": 255, \"g\": 80, \"b\": 0}}");
+    smart_led_state_t dom_state = initial;
+    uint32_t dom_transition_ms = 0;
+    CHECK_EQ(apply(padded, &state, &transition_ms), ESP_OK);
+    CHECK_EQ(dom_apply_json(padded, strlen(padded), &dom_state, &dom_transition_ms), ESP_OK);
+    CHECK(!memcmp(&state, &dom_state, sizeof(state)));
+    CHECK_EQ(transition_ms, dom_transition_ms);
+
+    // Heap: the DOM holds the whole tree at once, the SAX binder none of it
+    const char *documents[] = { command, padded };
+    for (int i = 0; i < 2; ++i) {
+        dom_peak_bytes = dom_allocations = 0;
+        dom_apply_json(documents[i], strlen(documents[i]), &dom_state, &dom_transition_ms);
+        CHECK_EQ(dom_live_bytes, 0);
+        printf("  %zu byte document: DOM peak heap %zu bytes in %zu allocations, SAX none\n",
+               strlen(documents[i]), dom_peak_bytes, dom_allocations);
+    }
+
+    bench_apply("SAX, command", command, smart_led_apply_json, 200000);
+    bench_apply("DOM, command", command, dom_apply_json, 200000);
+    bench_apply("SAX, padded command", padded, smart_led_apply_json, 20000);
+    bench_apply("DOM, padded command", padded, dom_apply_json, 20000);
+
+    return test_finish("test_smart_led_json");
+}
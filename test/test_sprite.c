@@ -0,0 +1,105 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "led_sprite.h"
+#include "led_pixel_map.h"
+#include "led_frame_buffer.h"
+#include "led_math.h"
+
+
+#define GRID_WIDTH              20
+#define GRID_HEIGHT             15
+
+static const led_rgb_t amber = { 255, 160, 0 };
+
+static uint8_t frame[LED_FRAME_BYTES];
+static uint8_t expected[LED_FRAME_BYTES];
+
+
+/* Pixel by pixel, every row of every column, clipped per pixel */
+static void reference_blit(uint8_t *out, const led_sprite_t *sprite, int x, int y, led_rgb_t color,
+                           uint8_t alpha) {
+    for (int c = 0; c < sprite->width; ++c) {
+        for (int row = 0; row < LED_SPRITE_HEIGHT; ++row) {
+            int px = x + c;
+            int py = y + row;
+            if (!(sprite->columns[c] & (1 << row))) continue;
+            if (px < 0 || px >= GRID_WIDTH || py < 0 || py >= GRID_HEIGHT) continue;
+            uint8_t *pixel = out + (py * GRID_WIDTH + px) * 3;
+            pixel[0] = led_lerp8(pixel[0], color.r, alpha);
+            pixel[1] = led_lerp8(pixel[1], color.g, alpha);
+            pixel[2] = led_lerp8(pixel[2], color.b, alpha);
+        }
+    }
+}
+
+static void fill_background(void) {
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) frame[i] = i * 13;
+    memcpy(expected, frame, sizeof(frame));
+}
+
+
+int main(void) {
+    led_map_config_t map = { .layout = LED_MAP_MATRIX, .width = GRID_WIDTH, .height = GRID_HEIGHT };
+    CHECK_EQ(led_map_init(&map), ESP_OK);
+
+    led_sprite_t heart;
+    CHECK(led_sprite_find("heart", 5, &heart));
+    CHECK_EQ(heart.width, 7);
+    CHECK(!led_sprite_find("hear", 4, &heart));
+    led_sprite_t unknown = led_sprite_glyph('\x01');
+    led_sprite_t question = led_sprite_glyph('?');
+    CHECK(unknown.columns == question.columns && unknown.width == question.width);
+
+    // Clipped blits at every position around the grid, opaque and blended, against the per pixel reference
+    int mismatches = 0;
+    static const uint8_t alphas[] = { 255, 128, 1 };
+    for (size_t a = 0; a < sizeof(alphas); ++a) {
+        for (int y = -LED_SPRITE_HEIGHT; y <= GRID_HEIGHT; ++y) {
+            for (int x = -heart.width; x <= GRID_WIDTH; ++x) {
+                fill_background();
+                led_blit(frame, &heart, x, y, amber, alphas[a]);
+                reference_blit(expected, &heart, x, y, amber, alphas[a]);
+                if (memcmp(frame, expected, sizeof(frame))) ++mismatches;
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // Text: glyph widths plus spacing, icons in braces, unknown icon names as plain text
+    led_sprite_t h = led_sprite_glyph('H');
+    led_sprite_t i = led_sprite_glyph('i');
+    CHECK_EQ(led_text_width(""), 0);
+    CHECK_EQ(led_text_width("Hi"), h.width + LED_TEXT_SPACING + i.width);
+    CHECK_EQ(led_text_width("{heart}"), 7);
+    CHECK_EQ(led_text_width("{heart}i"), 7 + LED_TEXT_SPACING + i.width);
+    CHECK(led_text_width("{hart}") > led_text_width("hart"));
+
+    fill_background();
+    int end = led_blit_text(frame, "{heart}i", 2, 3, amber, 255);
+    CHECK_EQ(end, 2 + led_text_width("{heart}i") + LED_TEXT_SPACING);
+    reference_blit(expected, &heart, 2, 3, amber, 255);
+    reference_blit(expected, &i, 2 + 7 + LED_TEXT_SPACING, 3, amber, 255);
+    CHECK(!memcmp(frame, expected, sizeof(frame)));
+
+    // Drawing stops at the right edge
+    CHECK(led_blit_text(frame, "Door open, Door open", 0, 0, amber, 255) < GRID_WIDTH + 8);
+
+    // A scrolling line with most of it off the grid, and the same glyphs drawn pixel by pixel
+    static const char line[] = "Door open 21:30";
+    BENCH("blit text, clipped line", 200000, {
+        test_sink += led_blit_text(frame, line, 5 - (int)(bench_i % 40), 4, amber, 255);
+    });
+    BENCH("per pixel reference, same line", 200000, {
+        const char *c = line;
+        int x = 5 - (int)(bench_i % 40);
+        while (*c && x < GRID_WIDTH) {
+            led_sprite_t glyph = led_sprite_glyph(*c++);
+            reference_blit(frame, &glyph, x, 4, amber, 255);
+            x += glyph.width + LED_TEXT_SPACING;
+        }
+        test_sink += x;
+    });
+
+    return test_finish("test_sprite");
+}
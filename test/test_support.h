@@ -0,0 +1,54 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+
+/*
+ * Checks and timing for the host tests. A failed check prints where it failed and the test carries on, so one
+ * run shows every failure; test_finish turns them into the exit code.
+ */
+
+static int test_failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        ++test_failures; \
+    } \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+    long long actual_ = (long long)(actual); \
+    long long expected_ = (long long)(expected); \
+    if (actual_ != expected_) { \
+        printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_, expected_); \
+        ++test_failures; \
+    } \
+} while (0)
+
+static inline int64_t test_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* Runs the body (the remaining arguments, so it may contain commas) `iterations` times and prints the mean
+ * time per iteration */
+#define BENCH(label, iterations, ...) do { \
+    int64_t start_ = test_now_ns(); \
+    for (long bench_i = 0; bench_i < (iterations); ++bench_i) { __VA_ARGS__; } \
+    printf("  %-40s %10.1f ns\n", label, (double)(test_now_ns() - start_) / (iterations)); \
+} while (0)
+
+/* Keeps the compiler from dropping benchmarked work whose result is otherwise unused */
+static volatile uint32_t test_sink;
+
+static inline int test_finish(const char *name) {
+    printf("%s: %s\n", name, test_failures ? "FAILED" : "passed");
+    return test_failures ? 1 : 0;
+}
+
+#endif
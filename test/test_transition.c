@@ -0,0 +1,211 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_transition.h"
+#include "led_frame_buffer.h"
+
+
+#define DURATION_MS             1000
+#define PALETTE_SIZE            256
+
+static int64_t now_us;
+static uint8_t from[LED_FRAME_BYTES];
+static uint8_t to[LED_FRAME_BYTES];
+static uint8_t frame[LED_FRAME_BYTES];
+
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+
+/* The curves as their formulas give them, in doubles */
+static double eased(led_ease_t ease, double t) {
+    switch (ease) {
+        case LED_EASE_IN: return t * t;
+        case LED_EASE_OUT: return 1 - (1 - t) * (1 - t);
+        case LED_EASE_IN_OUT: return t * t * (3 - 2 * t);
+        default: return t;
+    }
+}
+
+/* Shows `pixels` with no transition running, as the first frame of a scene */
+static void show(const uint8_t *pixels, uint8_t brightness) {
+    memcpy(frame, pixels, LED_FRAME_BYTES);
+    led_transition_cut();
+    CHECK(!led_transition_apply(frame, NULL, &brightness));
+}
+
+/* Renders `target` at `t_ms` into a transition started at 0 and returns the largest channel error against the
+ * blend of `start` and `target` at `weight` */
+static int blend_error(const uint8_t *start, const uint8_t *target, int t_ms, double weight, uint8_t *brightness) {
+    now_us = t_ms * 1000LL;
+    memcpy(frame, target, LED_FRAME_BYTES);
+    CHECK(led_transition_apply(frame, NULL, brightness));
+    int error = 0;
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) {
+        int expected = (int)floor(start[i] + (target[i] - start[i]) * weight);
+        if (abs(frame[i] - expected) > error) error = abs(frame[i] - expected);
+    }
+    return error;
+}
+
+
+int main(void) {
+    srand(1);
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) {
+        from[i] = rand();
+        to[i] = rand();
+    }
+
+    // Every curve runs from 0 to one exactly, never backwards, within a step of its formula
+    static const led_ease_t eases[] = { LED_EASE_LINEAR, LED_EASE_IN, LED_EASE_OUT, LED_EASE_IN_OUT };
+    for (int e = 0; e < 4; ++e) {
+        CHECK_EQ(led_transition_ease(eases[e], 0), 0);
+        CHECK_EQ(led_transition_ease(eases[e], LED_EASE_ONE), LED_EASE_ONE);
+        int backwards = 0, off = 0;
+        uint32_t previous = 0;
+        for (uint32_t t = 0; t <= LED_EASE_ONE; ++t) {
+            uint32_t weight = led_transition_ease(eases[e], t);
+            if (weight < previous) ++backwards;
+            if (fabs(weight - eased(eases[e], t / 65536.0) * LED_EASE_ONE) > 1.0) ++off;
+            previous = weight;
+        }
+        CHECK_EQ(backwards, 0);
+        CHECK_EQ(off, 0);
+    }
+    CHECK_EQ(led_transition_ease(LED_EASE_IN_OUT, LED_EASE_ONE / 2), LED_EASE_ONE / 2);
+
+    // The first frame has nothing to fade from, a transition of 0 cuts
+    now_us = 0;
+    uint8_t brightness = 40;
+    led_transition_request(DURATION_MS, LED_EASE_LINEAR);
+    memcpy(frame, from, LED_FRAME_BYTES);
+    CHECK(!led_transition_apply(frame, NULL, &brightness));
+    led_transition_request(0, LED_EASE_LINEAR);
+    memcpy(frame, to, LED_FRAME_BYTES);
+    CHECK(!led_transition_apply(frame, NULL, &brightness));
+    CHECK(!memcmp(frame, to, LED_FRAME_BYTES));
+
+    // The blend, along every curve: the start frame exactly at 0, the rendered one untouched at the end, and
+    // both frames and brightness in between
+    for (int e = 0; e < 4; ++e) {
+        now_us = 0;
+        show(from, 40);
+        led_transition_request(DURATION_MS, eases[e]);
+        brightness = 240;
+        CHECK_EQ(blend_error(from, to, 0, 0.0, &brightness), 0);
+        CHECK_EQ(brightness, 40);
+        for (int t_ms = 125; t_ms < DURATION_MS; t_ms += 125) {
+            double weight = eased(eases[e], (double)t_ms / DURATION_MS);
+            brightness = 240;
+            CHECK(blend_error(from, to, t_ms, weight, &brightness) <= 1);
+            CHECK(fabs(brightness - (40 + 200 * weight)) <= 1);
+        }
+        now_us = DURATION_MS * 1000;
+        memcpy(frame, to, LED_FRAME_BYTES);
+        brightness = 240;
+        CHECK(!led_transition_apply(frame, NULL, &brightness));
+        CHECK(!memcmp(frame, to, LED_FRAME_BYTES));
+        CHECK_EQ(brightness, 240);
+    }
+
+    // Replaced mid-fade: the new transition starts from the blend on the strip, not from either end
+    static uint8_t halfway[LED_FRAME_BYTES], third[LED_FRAME_BYTES];
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) third[i] = 255 - to[i];
+    now_us = 0;
+    show(from, 100);
+    led_transition_request(DURATION_MS, LED_EASE_LINEAR);
+    brightness = 100;
+    CHECK(blend_error(from, to, 0, 0.0, &brightness) == 0);
+    brightness = 100;
+    CHECK(blend_error(from, to, DURATION_MS / 2, 0.5, &brightness) <= 1);
+    memcpy(halfway, frame, LED_FRAME_BYTES);
+    led_transition_request(DURATION_MS, LED_EASE_LINEAR);
+    brightness = 100;
+    memcpy(frame, third, LED_FRAME_BYTES);
+    CHECK(led_transition_apply(frame, NULL, &brightness));
+    CHECK(!memcmp(frame, halfway, LED_FRAME_BYTES));
+    now_us += DURATION_MS * 1000 / 4;
+    memcpy(frame, third, LED_FRAME_BYTES);
+    CHECK(led_transition_apply(frame, NULL, &brightness));
+    int replaced_error = 0;
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) {
+        int expected = (int)floor(halfway[i] + (third[i] - halfway[i]) * 0.25);
+        if (abs(frame[i] - expected) > replaced_error) replaced_error = abs(frame[i] - expected);
+    }
+    CHECK(replaced_error <= 1);
+
+    // Indexed frames: kept as indices while no transition runs, expanded in place while one does, even with
+    // the palette in the same buffer right behind the indices, where the expanded colors overwrite it
+    static uint8_t indexed[LED_FRAME_BYTES + PALETTE_SIZE * sizeof(led_rgb_t)];
+    static led_rgb_t palette[PALETTE_SIZE];
+    static uint8_t expanded[LED_FRAME_BYTES];
+    for (int i = 0; i < PALETTE_SIZE; ++i) palette[i] = (led_rgb_t){ i, 255 - i, i * 7 };
+    for (size_t i = 0; i < LED_COUNT; ++i) {
+        indexed[i] = (i * 13) % PALETTE_SIZE;
+        memcpy(expanded + i * LED_PIXEL_BYTES, &palette[indexed[i]], LED_PIXEL_BYTES);
+    }
+    led_rgb_t *shared_palette = (led_rgb_t *)(indexed + LED_COUNT);
+    memcpy(shared_palette, palette, sizeof(palette));
+
+    now_us = 0;
+    led_transition_cut();
+    brightness = 50;
+    CHECK(!led_transition_apply(indexed, shared_palette, &brightness));
+    CHECK(!memcmp(shared_palette, palette, sizeof(palette)));
+    led_transition_request(DURATION_MS, LED_EASE_LINEAR);
+    brightness = 50;
+    CHECK(blend_error(expanded, to, 0, 0.0, &brightness) == 0);    // Faded from the indexed frame's colors
+
+    now_us = 0;
+    show(from, 50);
+    led_transition_request(DURATION_MS, LED_EASE_LINEAR);
+    brightness = 50;
+    CHECK(led_transition_apply(indexed, shared_palette, &brightness));
+    CHECK(!memcmp(indexed, from, LED_FRAME_BYTES));
+    now_us = DURATION_MS * 1000 / 2;
+    for (size_t i = 0; i < LED_COUNT; ++i) indexed[i] = (i * 13) % PALETTE_SIZE;
+    memcpy(shared_palette, palette, sizeof(palette));
+    CHECK(led_transition_apply(indexed, shared_palette, &brightness));
+    int indexed_error = 0;
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) {
+        int expected = (int)floor(from[i] + (expanded[i] - from[i]) * 0.5);
+        if (abs(indexed[i] - expected) > indexed_error) indexed_error = abs(indexed[i] - expected);
+    }
+    CHECK(indexed_error <= 1);
+
+    // Requests above the limit are clamped: still running just before it, over after it
+    now_us = 0;
+    show(from, 50);
+    led_transition_request(LED_TRANSITION_MAX_MS * 2, LED_EASE_LINEAR);
+    CHECK(led_transition_apply(frame, NULL, &brightness));
+    now_us = LED_TRANSITION_MAX_MS * 1000LL - 1;
+    CHECK(led_transition_apply(frame, NULL, &brightness));
+    now_us = LED_TRANSITION_MAX_MS * 1000LL;
+    CHECK(!led_transition_apply(frame, NULL, &brightness));
+
+    // One frame through a running transition, as the render loop applies it
+    now_us = 0;
+    show(from, 50);
+    led_transition_request(LED_TRANSITION_MAX_MS, LED_EASE_IN_OUT);
+    BENCH("blend, RGB frame", 200000, {
+        now_us = bench_i;
+        memcpy(frame, to, LED_FRAME_BYTES);
+        test_sink += led_transition_apply(frame, NULL, &brightness);
+    });
+    BENCH("blend, indexed frame", 200000, {
+        now_us = bench_i;
+        memcpy(frame, indexed, LED_COUNT);
+        test_sink += led_transition_apply(frame, palette, &brightness);
+    });
+    led_transition_cut();
+    BENCH("no transition, RGB frame", 200000, {
+        memcpy(frame, to, LED_FRAME_BYTES);
+        test_sink += led_transition_apply(frame, NULL, &brightness);
+    });
+
+    return test_finish("test_transition");
+}
@@ -0,0 +1,293 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "led_udp_protocol.h"
+#include "led_frame_buffer.h"
+#include "led_clock_sync.h"
+#include "led_jitter_buffer.h"
+
+
+/* Wire constants, from the DDP and E1.31 specifications rather than the module */
+#define DDP_VERSION_1           0x40
+#define DDP_FLAG_TIMECODE       (1 << 4)
+#define DDP_FLAG_QUERY          (1 << 1)
+#define DDP_FLAG_PUSH           (1 << 0)
+#define DDP_ID_DISPLAY          1
+#define DDP_HEADER_LEN          10
+#define E131_HEADER_LEN         126
+#define E131_OPT_PREVIEW        (1 << 7)
+#define E131_OPT_TERMINATED     (1 << 6)
+
+static int frames_received;
+static bool clock_synced;
+static int jb_pushes;
+static int64_t jb_last_pts;
+static uint8_t jb_last_frame[LED_FRAME_BYTES];
+static uint8_t packet[1472];
+
+
+int64_t esp_timer_get_time(void) {
+    return 0;
+}
+
+void stream_frame_received(void) {
+    ++frames_received;
+}
+
+/* Timecodes are local microseconds / 16 once "synchronized", enough to see them arrive as presentation times */
+bool led_clock_from_timecode(uint32_t timecode, int64_t *local_us) {
+    *local_us = (int64_t)timecode * 16;
+    return clock_synced;
+}
+
+esp_err_t led_jb_push(const uint8_t *frame, int64_t pts_us) {
+    ++jb_pushes;
+    jb_last_pts = pts_us;
+    memcpy(jb_last_frame, frame, LED_FRAME_BYTES);
+    return ESP_OK;
+}
+
+
+static void write_be16(uint8_t *buf, uint16_t value) {
+    buf[0] = value >> 8;
+    buf[1] = value;
+}
+
+static void write_be32(uint8_t *buf, uint32_t value) {
+    write_be16(buf, value >> 16);
+    write_be16(buf + 2, value);
+}
+
+/* A test frame: every channel depends on the frame number and its position */
+static void fill_frame(uint8_t *frame, int number) {
+    for (size_t i = 0; i < LED_FRAME_BYTES; ++i) frame[i] = i * 7 + number * 31;
+}
+
+static size_t ddp_packet(uint8_t flags, uint8_t seq, uint32_t offset, const uint8_t *data, uint16_t len) {
+    packet[0] = DDP_VERSION_1 | flags;
+    packet[1] = seq;
+    packet[2] = 0;
+    packet[3] = DDP_ID_DISPLAY;
+    write_be32(packet + 4, offset);
+    write_be16(packet + 8, len);
+    size_t header_len = DDP_HEADER_LEN;
+    if (flags & DDP_FLAG_TIMECODE) {
+        write_be32(packet + header_len, offset + 1000);     // Any timecode, recognizable in the pts
+        header_len += 4;
+    }
+    memcpy(packet + header_len, data, len);
+    return header_len + len;
+}
+
+/* Sends a whole frame as one pushed DDP packet */
+static void send_ddp_frame(uint8_t seq, const uint8_t *frame) {
+    led_udp_handle_ddp(packet, ddp_packet(DDP_FLAG_PUSH, seq, 0, frame, LED_FRAME_BYTES));
+}
+
+static size_t e131_packet(uint16_t universe, uint8_t seq, uint8_t options, const uint8_t *data, uint16_t len) {
+    static const uint8_t acn_packet_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+    memset(packet, 0, E131_HEADER_LEN);
+    write_be16(packet, 0x0010);
+    memcpy(packet + 4, acn_packet_id, sizeof(acn_packet_id));
+    write_be32(packet + 18, 0x00000004);
+    write_be32(packet + 40, 0x00000002);
+    packet[111] = seq;
+    packet[112] = options;
+    write_be16(packet + 113, universe);
+    packet[117] = 0x02;
+    write_be16(packet + 123, len + 1);
+    memcpy(packet + E131_HEADER_LEN, data, len);
+    return E131_HEADER_LEN + len;
+}
+
+/* Sends universe `index` of `frame` */
+static void send_universe(int index, uint8_t seq, const uint8_t *frame) {
+    size_t offset = index * E131_CHANNELS_PER_UNIVERSE;
+    size_t len = LED_FRAME_BYTES - offset < E131_CHANNELS_PER_UNIVERSE ? LED_FRAME_BYTES - offset
+                                                                       : E131_CHANNELS_PER_UNIVERSE;
+    led_udp_handle_e131(packet, e131_packet(E131_START_UNIVERSE + index, seq, 0, frame + offset, len));
+}
+
+static bool shows(const uint8_t *frame) {
+    const uint8_t *latest = led_fb_take_latest();
+    return latest && !memcmp(latest, frame, LED_FRAME_BYTES);
+}
+
+
+static void test_ddp(void) {
+    static uint8_t frame[LED_FRAME_BYTES], older[LED_FRAME_BYTES];
+    led_udp_stats_t before = led_udp_get_stats();
+
+    // In order, through the whole sequence space and over the wrap from 15 to 1 (0 isn't a sequence number)
+    for (int i = 0; i < 20; ++i) {
+        fill_frame(frame, i);
+        send_ddp_frame(i % 15 + 1, frame);
+        CHECK(shows(frame));
+    }
+    CHECK_EQ(frames_received, 20);
+    CHECK_EQ(led_udp_get_stats().dropped_out_of_order, before.dropped_out_of_order);
+
+    // The last one was 5: a duplicate and the ones before are stale, also across the wrap
+    memcpy(older, frame, sizeof(older));
+    fill_frame(frame, 100);
+    send_ddp_frame(5, frame);
+    send_ddp_frame(4, frame);
+    send_ddp_frame(14, frame);
+    CHECK(led_fb_take_latest() == NULL);
+    CHECK_EQ(led_udp_get_stats().dropped_out_of_order, before.dropped_out_of_order + 3);
+
+    // Up to half the sequence space ahead is a gap from lost packets; 0 is always taken, without moving the
+    // sequence on
+    send_ddp_frame(13, frame);
+    CHECK(shows(frame));
+    send_ddp_frame(0, older);
+    CHECK(shows(older));
+    send_ddp_frame(13, frame);
+    CHECK(led_fb_take_latest() == NULL);
+    send_ddp_frame(1, frame);
+    CHECK(shows(frame));
+
+    // Packets without push assemble at their offsets, the push commits; data beyond the strip is clipped
+    fill_frame(frame, 101);
+    size_t half = LED_FRAME_BYTES / 2;
+    led_udp_handle_ddp(packet, ddp_packet(0, 2, 0, frame, half));
+    CHECK(led_fb_take_latest() == NULL);
+    uint8_t tail[LED_FRAME_BYTES];
+    memcpy(tail, frame + half, LED_FRAME_BYTES - half);
+    memset(tail + LED_FRAME_BYTES - half, 0xAA, half);
+    led_udp_handle_ddp(packet, ddp_packet(DDP_FLAG_PUSH, 3, half, tail, LED_FRAME_BYTES));
+    CHECK(shows(frame));
+
+    // Invalid and unsupported packets. The truncated one passes the sequence check first and takes up 4.
+    uint32_t invalid = led_udp_get_stats().dropped_invalid;
+    size_t len = ddp_packet(DDP_FLAG_PUSH, 4, 0, frame, 30);
+    led_udp_handle_ddp(packet, len - 1);
+    led_udp_handle_ddp(packet, DDP_HEADER_LEN - 1);
+    packet[0] = 0x80 | DDP_FLAG_PUSH;
+    led_udp_handle_ddp(packet, len);
+    CHECK_EQ(led_udp_get_stats().dropped_invalid, invalid + 3);
+    led_udp_handle_ddp(packet, ddp_packet(DDP_FLAG_PUSH | DDP_FLAG_QUERY, 4, 0, frame, 30));
+    ddp_packet(DDP_FLAG_PUSH, 4, 0, frame, 30);
+    packet[3] = 2;
+    led_udp_handle_ddp(packet, len);
+    CHECK(led_fb_take_latest() == NULL);
+
+    // Timecoded frames go to the jitter buffer once the clock is synchronized, straight out before that
+    int received = frames_received;
+    fill_frame(frame, 102);
+    led_udp_handle_ddp(packet, ddp_packet(DDP_FLAG_TIMECODE | DDP_FLAG_PUSH, 5, 0, frame, LED_FRAME_BYTES));
+    CHECK(shows(frame));
+    CHECK_EQ(jb_pushes, 0);
+    clock_synced = true;
+    fill_frame(frame, 103);
+    led_udp_handle_ddp(packet, ddp_packet(DDP_FLAG_TIMECODE, 6, 0, frame, half));
+    led_udp_handle_ddp(packet, ddp_packet(DDP_FLAG_TIMECODE | DDP_FLAG_PUSH, 7, half, frame + half,
+                                          LED_FRAME_BYTES - half));
+    CHECK_EQ(jb_pushes, 1);
+    CHECK_EQ(jb_last_pts, (int64_t)(half + 1000) * 16);
+    CHECK(!memcmp(jb_last_frame, frame, LED_FRAME_BYTES));
+    CHECK(led_fb_take_latest() == NULL);
+    CHECK_EQ(frames_received, received + 1);
+    clock_synced = false;
+}
+
+
+static void test_e131(void) {
+    static uint8_t frame[LED_FRAME_BYTES], next[LED_FRAME_BYTES];
+    CHECK(E131_UNIVERSE_COUNT >= 2);
+    led_udp_stats_t before = led_udp_get_stats();
+    int received = frames_received;
+
+    // A frame is committed once every universe arrived, in any order
+    fill_frame(frame, 0);
+    for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) {
+        CHECK(led_fb_take_latest() == NULL);
+        send_universe(i, 1, frame);
+    }
+    CHECK(shows(frame));
+    fill_frame(frame, 1);
+    for (int i = E131_UNIVERSE_COUNT - 1; i >= 0; --i) send_universe(i, 2, frame);
+    CHECK(shows(frame));
+    CHECK_EQ(frames_received, received + 2);
+
+    // A lost universe: the next frame's first universe commits the incomplete one over the last complete frame
+    fill_frame(next, 2);
+    send_universe(0, 3, next);
+    CHECK(led_fb_take_latest() == NULL);
+    memcpy(frame, next, E131_CHANNELS_PER_UNIVERSE);
+    fill_frame(next, 3);
+    send_universe(0, 4, next);
+    CHECK(shows(frame));
+    for (int i = 1; i < E131_UNIVERSE_COUNT; ++i) send_universe(i, 4, next);
+    CHECK(shows(next));
+
+    // Per universe sequence numbers: duplicates and up to 19 behind are dropped, 20 behind is a restarted source
+    fill_frame(next, 4);
+    send_universe(0, 4, next);
+    send_universe(0, 3, next);
+    send_universe(0, 4 - 19, next);
+    CHECK_EQ(led_udp_get_stats().dropped_out_of_order, before.dropped_out_of_order + 3);
+    for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) send_universe(i, 4 - 20, next);
+    CHECK(shows(next));
+
+    // Over the wrap from 255 to 0
+    uint8_t seq = 4 - 20;
+    while (seq != 255) {
+        ++seq;
+        for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) send_universe(i, seq, next);
+    }
+    fill_frame(frame, 5);
+    for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) send_universe(i, 0, frame);
+    CHECK(shows(frame));
+    CHECK_EQ(led_udp_get_stats().dropped_out_of_order, before.dropped_out_of_order + 3);
+
+    // A terminated stream resets the sequence of its universe, preview data and foreign universes are ignored
+    led_udp_handle_e131(packet, e131_packet(E131_START_UNIVERSE, 0, E131_OPT_TERMINATED, frame, 0));
+    fill_frame(frame, 6);
+    for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) send_universe(i, i ? 1 : 200, frame);
+    CHECK(shows(frame));
+    led_udp_handle_e131(packet, e131_packet(E131_START_UNIVERSE, 201, E131_OPT_PREVIEW, next, 30));
+    led_udp_handle_e131(packet, e131_packet(E131_START_UNIVERSE + E131_UNIVERSE_COUNT, 1, 0, next, 30));
+    led_udp_handle_e131(packet, e131_packet(E131_START_UNIVERSE - 1, 1, 0, next, 30));
+    for (int i = 1; i < E131_UNIVERSE_COUNT; ++i) send_universe(i, 2, next);
+    CHECK(led_fb_take_latest() == NULL);
+
+    // Invalid packets
+    uint32_t invalid = led_udp_get_stats().dropped_invalid;
+    size_t len = e131_packet(E131_START_UNIVERSE, 202, 0, next, 30);
+    led_udp_handle_e131(packet, len - 1);
+    led_udp_handle_e131(packet, E131_HEADER_LEN - 1);
+    packet[125] = 0xDD;     // Not a DMX start code
+    led_udp_handle_e131(packet, len);
+    e131_packet(E131_START_UNIVERSE, 202, 0, next, 30);
+    packet[4] = 'X';
+    led_udp_handle_e131(packet, len);
+    CHECK_EQ(led_udp_get_stats().dropped_invalid, invalid + 4);
+}
+
+
+int main(void) {
+    CHECK_EQ(led_fb_init(), ESP_OK);
+    test_ddp();
+    test_e131();
+
+    // Packets from the generator to the frame buffer, one pushed DDP packet or every universe per frame
+    static uint8_t frame[LED_FRAME_BYTES];
+    fill_frame(frame, 0);
+    for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) {
+        led_udp_handle_e131(packet, e131_packet(E131_START_UNIVERSE + i, 0, E131_OPT_TERMINATED, frame, 0));
+    }
+    uint32_t dropped = led_udp_get_stats().dropped_out_of_order;
+    BENCH("DDP frame", 100000, {
+        send_ddp_frame((bench_i + 7) % 15 + 1, frame);
+        test_sink += led_fb_take_latest() != NULL;
+    });
+    BENCH("E1.31 frame", 100000, {
+        for (int i = 0; i < E131_UNIVERSE_COUNT; ++i) send_universe(i, bench_i, frame);
+        test_sink += led_fb_take_latest() != NULL;
+    });
+
+    CHECK_EQ(led_udp_get_stats().dropped_out_of_order, dropped);
+
+    return test_finish("test_udp_protocol");
+}
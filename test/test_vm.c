@@ -0,0 +1,182 @@
+#include <string.h>
+
+#include "test_support.h"
+#include "led_vm.h"
+#include "led_math.h"
+#include "led_frame_buffer.h"
+
+
+#define PIXEL_COUNT             LED_COUNT
+#define GRID_WIDTH              20
+
+#define INSN(op, d, a, b)       (op), (d), (a), (b)
+// The 8.8 immediate goes into the two operand bytes
+#define LDI(d, value)           LED_VM_LDI, (d), IMM_HI(value), IMM_LO(value)
+#define IMM_HI(value)           (uint8_t)((int16_t)((value) * 256) >> 8)
+#define IMM_LO(value)           (uint8_t)(int16_t)((value) * 256)
+
+static led_vm_program_t program;
+static int32_t regs[LED_VM_REGISTERS];
+
+
+/* Frame: r1 = t / 4. Pixel: hue u + r1 at full value into r0 - r2. */
+static const uint8_t rainbow[] = {
+    LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 2, 3,
+    LDI(1, 0.25),
+    INSN(LED_VM_MUL, 1, LED_VM_R_T, 1),
+    INSN(LED_VM_ADD, 2, LED_VM_R_U, 1),
+    LDI(3, 1),
+    INSN(LED_VM_HSV, 0, 2, 3),
+};
+
+/* Pixel: s = sin(x * 0.1 + t) turns, red |s|, green s where it is positive, blue 0 */
+static const uint8_t wave[] = {
+    LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 0, 9,
+    LDI(4, 0.1),
+    INSN(LED_VM_MUL, 4, LED_VM_R_X, 4),
+    INSN(LED_VM_ADD, 4, 4, LED_VM_R_T),
+    INSN(LED_VM_SIN, 5, 4, 0),
+    INSN(LED_VM_ABS, 0, 5, 0),
+    LDI(6, 0),
+    INSN(LED_VM_JLT, 1, 5, 6),
+    INSN(LED_VM_MOV, 1, 5, 0),
+    LDI(2, 0),
+};
+
+
+static uint8_t channel(int32_t value) {
+    if (value <= 0) return 0;
+    if (value >= LED_VM_ONE) return 255;
+    return (value * 255 + LED_VM_ONE / 2) >> 16;
+}
+
+/* The same effects written directly against led_math and led_color */
+static led_rgb_t native_rainbow(size_t index, int32_t time) {
+    int32_t u = (int64_t)index * LED_VM_ONE / PIXEL_COUNT;
+    return led_hsv_to_rgb((u + time / 4) & (LED_VM_ONE - 1), 255, 255);
+}
+
+static led_rgb_t native_wave(int x, int32_t time) {
+    int32_t s = led_sin16(x * (int32_t)(0.1 * 256) * 256 + time) * 2;
+    return (led_rgb_t){ channel(s < 0 ? -s : s), channel(s), 0 };
+}
+
+static bool same_color(led_rgb_t a, led_rgb_t b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+/* Loads a program of frame code only and returns r0 after one frame */
+static int32_t run_frame_code(const uint8_t *code, uint8_t insns) {
+    uint8_t upload[5 + LED_VM_MAX_CODE * 4] = { LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, insns, 0 };
+    memcpy(upload + 5, code, insns * 4);
+    if (led_vm_load(&program, upload, 5 + insns * 4) != ESP_OK) return -1;
+    memset(regs, 0, sizeof(regs));
+    led_vm_run_frame(&program, regs, 0);
+    return regs[0];
+}
+
+
+int main(void) {
+    // Verification
+    static const uint8_t empty[] = { LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 0, 0 };
+    static const uint8_t bad_magic[] = { 'X', LED_VM_MAGIC_1, LED_VM_VERSION, 0, 0 };
+    static const uint8_t bad_version[] = { LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION + 1, 0, 0 };
+    static const uint8_t truncated[] = { LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 1, 0, LED_VM_MOV, 0 };
+    static const uint8_t too_long[] = { LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, LED_VM_MAX_CODE + 1, 0 };
+    static const uint8_t jump_past_end[] = {
+        LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 1, 0, INSN(LED_VM_JMP, 1, 0, 0),
+    };
+    static const uint8_t bad_register[] = {
+        LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 0, 1, INSN(LED_VM_ADD, 0, LED_VM_REGISTERS, 0),
+    };
+    static const uint8_t bad_opcode[] = {
+        LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 1, 0, INSN(LED_VM_OP_COUNT, 0, 0, 0),
+    };
+    static const uint8_t hsv_overrun[] = {
+        LED_VM_MAGIC_0, LED_VM_MAGIC_1, LED_VM_VERSION, 1, 0, INSN(LED_VM_HSV, LED_VM_REGISTERS - 2, 0, 0),
+    };
+    CHECK_EQ(led_vm_load(&program, empty, sizeof(empty)), ESP_OK);
+    CHECK_EQ(led_vm_load(&program, bad_magic, sizeof(bad_magic)), ESP_ERR_INVALID_VERSION);
+    CHECK_EQ(led_vm_load(&program, bad_version, sizeof(bad_version)), ESP_ERR_INVALID_VERSION);
+    CHECK_EQ(led_vm_load(&program, empty, 4), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(led_vm_load(&program, truncated, sizeof(truncated)), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(led_vm_load(&program, too_long, sizeof(too_long)), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(led_vm_load(&program, jump_past_end, sizeof(jump_past_end)), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(led_vm_load(&program, bad_register, sizeof(bad_register)), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(led_vm_load(&program, bad_opcode, sizeof(bad_opcode)), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(led_vm_load(&program, hsv_overrun, sizeof(hsv_overrun)), ESP_ERR_INVALID_ARG);
+
+    // A rejected upload leaves the loaded program alone
+    CHECK_EQ(led_vm_load(&program, rainbow, sizeof(rainbow)), ESP_OK);
+    CHECK_EQ(led_vm_load(&program, bad_register, sizeof(bad_register)), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(program.frame_len, 2);
+    CHECK_EQ(program.pixel_len, 3);
+
+    // Arithmetic: saturation, division by zero, floor and frac of negative values
+    static const uint8_t square_overflow[] = {
+        LDI(0, 127), INSN(LED_VM_MUL, 0, 0, 0), INSN(LED_VM_MUL, 0, 0, 0),
+    };
+    static const uint8_t square[] = { LDI(0, -1.5), INSN(LED_VM_MUL, 0, 0, 0) };
+    static const uint8_t third[] = {
+        LDI(1, 1), LDI(2, 3), INSN(LED_VM_DIV, 0, 1, 2),
+    };
+    static const uint8_t div_zero[] = { LDI(1, 1), INSN(LED_VM_DIV, 0, 1, 2) };
+    static const uint8_t floor_neg[] = { LDI(1, -0.5), INSN(LED_VM_FLOOR, 0, 1, 0) };
+    static const uint8_t frac_neg[] = { LDI(1, -0.25), INSN(LED_VM_FRAC, 0, 1, 0) };
+    static const uint8_t skipped[] = {
+        LDI(0, 2), INSN(LED_VM_JGE, 1, 0, 1), LDI(0, 3),
+    };
+    CHECK_EQ(run_frame_code(square_overflow, 3), INT32_MAX);
+    CHECK_EQ(run_frame_code(square, 2), 2.25 * LED_VM_ONE);
+    CHECK_EQ(run_frame_code(third, 3), LED_VM_ONE / 3);
+    CHECK_EQ(run_frame_code(div_zero, 2), 0);
+    CHECK_EQ(run_frame_code(floor_neg, 2), -LED_VM_ONE);
+    CHECK_EQ(run_frame_code(frac_neg, 2), 0.75 * LED_VM_ONE);
+    CHECK_EQ(run_frame_code(skipped, 3), 2 * LED_VM_ONE);
+
+    // Whole effects match their native versions pixel for pixel
+    int mismatches = 0;
+    CHECK_EQ(led_vm_load(&program, rainbow, sizeof(rainbow)), ESP_OK);
+    for (int32_t time = 0; time < 4 * LED_VM_ONE; time += LED_VM_ONE / 7) {
+        memset(regs, 0, sizeof(regs));
+        led_vm_run_frame(&program, regs, time);
+        for (size_t i = 0; i < PIXEL_COUNT; ++i) {
+            led_rgb_t color = led_vm_run_pixel(&program, regs, i % GRID_WIDTH, i / GRID_WIDTH, i, PIXEL_COUNT);
+            if (!same_color(color, native_rainbow(i, time))) ++mismatches;
+        }
+    }
+    CHECK_EQ(led_vm_load(&program, wave, sizeof(wave)), ESP_OK);
+    for (int32_t time = 0; time < 4 * LED_VM_ONE; time += LED_VM_ONE / 7) {
+        memset(regs, 0, sizeof(regs));
+        led_vm_run_frame(&program, regs, time);
+        for (size_t i = 0; i < PIXEL_COUNT; ++i) {
+            led_rgb_t color = led_vm_run_pixel(&program, regs, i % GRID_WIDTH, i / GRID_WIDTH, i, PIXEL_COUNT);
+            if (!same_color(color, native_wave(i % GRID_WIDTH, time))) ++mismatches;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // One frame of each effect, interpreted against native
+    CHECK_EQ(led_vm_load(&program, rainbow, sizeof(rainbow)), ESP_OK);
+    BENCH("rainbow frame, vm", 2000, {
+        led_vm_run_frame(&program, regs, bench_i * 1000);
+        for (size_t i = 0; i < PIXEL_COUNT; ++i) {
+            test_sink += led_vm_run_pixel(&program, regs, i % GRID_WIDTH, i / GRID_WIDTH, i, PIXEL_COUNT).r;
+        }
+    });
+    BENCH("rainbow frame, native", 2000, {
+        for (size_t i = 0; i < PIXEL_COUNT; ++i) test_sink += native_rainbow(i, bench_i * 1000).r;
+    });
+    CHECK_EQ(led_vm_load(&program, wave, sizeof(wave)), ESP_OK);
+    BENCH("wave frame, vm", 2000, {
+        led_vm_run_frame(&program, regs, bench_i * 1000);
+        for (size_t i = 0; i < PIXEL_COUNT; ++i) {
+            test_sink += led_vm_run_pixel(&program, regs, i % GRID_WIDTH, i / GRID_WIDTH, i, PIXEL_COUNT).r;
+        }
+    });
+    BENCH("wave frame, native", 2000, {
+        for (size_t i = 0; i < PIXEL_COUNT; ++i) test_sink += native_wave(i % GRID_WIDTH, bench_i * 1000).r;
+    });
+
+    return test_finish("test_vm");
+}
@@ -0,0 +1,223 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_pixel_format.h"
+#include "led_strip_spi_encoder.h"
+#include "led_strip_parallel_encoder.h"
+
+
+#define PIXELS                  300
+#define LANES                   16
+
+// Pixel { 0x11, 0x22, 0x33 } on the wire, through linear levels
+#if LED_CHIP == LED_CHIP_WS2812
+#define CHIP_NAME               "WS2812"
+static const uint8_t expected_wire[] = { 0x22, 0x11, 0x33 };
+#elif LED_CHIP == LED_CHIP_WS2811
+#define CHIP_NAME               "WS2811"
+static const uint8_t expected_wire[] = { 0x11, 0x22, 0x33 };
+#elif LED_CHIP == LED_CHIP_SK6812_RGBW
+#define CHIP_NAME               "SK6812_RGBW"
+static const uint8_t expected_wire[] = { 0x11, 0x00, 0x22, 0x11 };
+#elif LED_CHIP == LED_CHIP_UCS8903
+#define CHIP_NAME               "UCS8903"
+static const uint8_t expected_wire[] = { 0x11, 0x00, 0x22, 0x00, 0x33, 0x00 };
+#endif
+
+static uint16_t linear[256];
+static uint16_t squared[256];
+static uint8_t pixels[LANES][PIXELS * LED_PIXEL_BYTES];
+static uint8_t spi_out[LED_STRIP_SPI_BYTES(PIXELS)];
+static uint8_t parallel_out[LED_PARALLEL_BYTES(LANES, PIXELS)];
+static led_strip_spi_encoder_t spi;
+
+
+/* Wire bytes of every pixel of `frame`, dither offsets advancing as the encoders advance them */
+static void expected_frame(const led_strip_frame_t *frame, uint8_t *out) {
+    uint8_t offset = frame->dither_offset;
+    for (size_t pixel = 0; pixel < frame->pixel_count; ++pixel) {
+        led_wire_pixel(led_strip_frame_pixel(frame, pixel), frame->levels, offset, out + pixel * LED_WIRE_BYTES);
+        offset += frame->dither_stride;
+    }
+}
+
+/* Strip bits back from the SPI stream: every SPI nibble is a run of high bits as long as the chip's high time */
+static bool spi_decodes_to(const uint8_t *spi_bytes, const uint8_t *wire, size_t wire_bytes) {
+    uint8_t nibble_0 = (0xF0 >> lround(LED_T0H_NS / 312.5)) & 0xF;
+    uint8_t nibble_1 = (0xF0 >> lround(LED_T1H_NS / 312.5)) & 0xF;
+    for (size_t bit = 0; bit < wire_bytes * 8; ++bit) {
+        uint8_t nibble = bit % 2 ? spi_bytes[bit / 2] & 0xF : spi_bytes[bit / 2] >> 4;
+        bool one = wire[bit / 8] & (0x80 >> (bit % 8));
+        if (nibble != (one ? nibble_1 : nibble_0)) return false;
+    }
+    return true;
+}
+
+/* Strip bits of `lane` back from the bus words: high, data, low for every bit */
+static bool parallel_decodes_to(const uint8_t *bus, size_t word_bytes, int lane, const uint8_t *wire,
+                                size_t wire_bytes) {
+    for (size_t bit = 0; bit < wire_bytes * 8; ++bit) {
+        const uint8_t *slots = bus + bit * LED_PARALLEL_SLOTS_PER_BIT * word_bytes;
+        uint8_t lane_mask = 1 << (lane % 8);
+        bool one = wire[bit / 8] & (0x80 >> (bit % 8));
+        if (!(slots[lane / 8] & lane_mask) || (slots[2 * word_bytes + lane / 8] & lane_mask)) return false;
+        if (!(slots[word_bytes + lane / 8] & lane_mask) != !one) return false;
+    }
+    return true;
+}
+
+static void reference_transpose(const uint8_t in[8], uint8_t *out, size_t stride) {
+    for (int j = 0; j < 8; ++j) {
+        uint8_t byte = 0;
+        for (int i = 0; i < 8; ++i) byte |= ((in[i] >> (7 - j)) & 1) << i;
+        out[j * stride] = byte;
+    }
+}
+
+
+int main(void) {
+    printf("  %s: %d wire bytes per pixel, %d SPI bytes and %d parallel bus bytes for %d pixels\n", CHIP_NAME,
+           LED_WIRE_BYTES, LED_STRIP_SPI_BYTES(PIXELS), LED_PARALLEL_BYTES(8, PIXELS), PIXELS);
+
+    for (int v = 0; v < 256; ++v) {
+        linear[v] = v << 8;
+        squared[v] = v * v;
+    }
+    srand(1);
+    for (int l = 0; l < LANES; ++l) {
+        for (size_t i = 0; i < sizeof(pixels[l]); ++i) pixels[l][i] = rand();
+    }
+
+    // Channel order and width
+    static const uint8_t rgb[] = { 0x11, 0x22, 0x33 };
+    uint8_t wire[LED_WIRE_BYTES];
+    CHECK_EQ(sizeof(expected_wire), LED_WIRE_BYTES);
+    led_wire_pixel(rgb, linear, 0, wire);
+    CHECK(!memcmp(wire, expected_wire, LED_WIRE_BYTES));
+
+    // The dither offset rounds 8 bit output, 16 bit chips send the level itself
+    static const uint8_t one_and_a_half[] = { 1, 1, 1 };
+    const uint16_t half_step[256] = { [1] = 0x0180 };
+    led_wire_pixel(one_and_a_half, half_step, 0x7F, wire);
+    CHECK_EQ(wire[LED_WIRE_BYTES - 1], LED_WIRE_BITS == 16 ? 0x80 : 1);
+    led_wire_pixel(one_and_a_half, half_step, 0x80, wire);
+    CHECK_EQ(wire[LED_WIRE_BYTES - 1], LED_WIRE_BITS == 16 ? 0x80 : 2);
+
+#if LED_WIRE_WHITE
+    // White is split off the output levels: color and white LED together give each channel its level, and the
+    // weakest color LED stays off
+    int split_mismatches = 0;
+    for (int r = 0; r < 256; r += 15) {
+        for (int g = 0; g < 256; g += 15) {
+            for (int b = 0; b < 256; b += 15) {
+                const uint8_t color[] = { r, g, b };
+                uint8_t channels[4];
+                led_wire_pixel(color, squared, 0, wire);
+                for (int i = 0; i < 4; ++i) channels[(int[]){ LED_WIRE_ORDER }[i]] = wire[i];
+                for (int c = 0; c < 3; ++c) {
+                    if (abs(channels[c] + channels[3] - (squared[color[c]] >> 8)) > 1) ++split_mismatches;
+                }
+                if (channels[0] && channels[1] && channels[2]) ++split_mismatches;
+            }
+        }
+    }
+    CHECK_EQ(split_mismatches, 0);
+#endif
+
+    // SPI: every wire bit as its high time, then the reset code
+    static uint8_t expected[LANES][PIXELS * LED_WIRE_BYTES];
+    led_strip_spi_encoder_init(&spi);
+    led_strip_frame_t frame = {
+        .pixels = pixels[0], .pixel_count = PIXELS, .levels = squared, .dither_offset = 37, .dither_stride = 71,
+    };
+    expected_frame(&frame, expected[0]);
+    memset(spi_out, 0xAA, sizeof(spi_out));
+    CHECK_EQ(led_strip_spi_encode(&spi, &frame, spi_out), LED_STRIP_SPI_BYTES(PIXELS));
+    CHECK(spi_decodes_to(spi_out, expected[0], PIXELS * LED_WIRE_BYTES));
+    int reset_mismatches = 0;
+    for (size_t i = LED_STRIP_SPI_BYTES(PIXELS) - LED_STRIP_SPI_RESET_BYTES; i < sizeof(spi_out); ++i) {
+        if (spi_out[i]) ++reset_mismatches;
+    }
+    CHECK_EQ(reset_mismatches, 0);
+
+    // Map and palette go through the same encoder
+    static uint16_t reversed[PIXELS];
+    static led_rgb_t palette[256];
+    for (int i = 0; i < PIXELS; ++i) reversed[i] = PIXELS - 1 - i;
+    for (int i = 0; i < 256; ++i) palette[i] = (led_rgb_t){ i, 255 - i, i / 2 };
+    led_strip_frame_t mapped = { .pixels = pixels[1], .palette = palette, .map = reversed, .pixel_count = PIXELS,
+                                 .levels = linear };
+    expected_frame(&mapped, expected[1]);
+    led_wire_pixel(&palette[pixels[1][PIXELS - 1]].r, linear, 0, wire);
+    CHECK(!memcmp(expected[1], wire, LED_WIRE_BYTES));
+    led_strip_spi_encode(&spi, &mapped, spi_out);
+    CHECK(spi_decodes_to(spi_out, expected[1], PIXELS * LED_WIRE_BYTES));
+
+    // Transpose against bit by bit, then whole parallel frames lane by lane, short lanes padded with black
+    int transpose_mismatches = 0;
+    for (int n = 0; n < 10000; ++n) {
+        uint8_t in[8], out[16], reference[16];
+        for (int i = 0; i < 8; ++i) in[i] = rand();
+        led_transpose8x8(in, out, 2);
+        reference_transpose(in, reference, 2);
+        for (int j = 0; j < 8; ++j) {
+            if (out[2 * j] != reference[2 * j]) ++transpose_mismatches;
+        }
+    }
+    CHECK_EQ(transpose_mismatches, 0);
+
+    static const size_t lane_counts[] = { 1, 8, 11, 16 };
+    led_strip_frame_t lanes[LANES];
+    for (size_t n = 0; n < sizeof(lane_counts) / sizeof(lane_counts[0]); ++n) {
+        led_strip_parallel_encoder_t parallel;
+        CHECK_EQ(led_strip_parallel_encoder_init(&parallel, lane_counts[n]), ESP_OK);
+        for (int l = 0; l < LANES; ++l) {
+            lanes[l] = (led_strip_frame_t){ .pixels = pixels[l], .pixel_count = PIXELS - (l % 3) * 7,
+                                            .levels = squared, .dither_offset = l * 29, .dither_stride = 71 };
+            memset(expected[l], 0, sizeof(expected[l]));
+            expected_frame(&lanes[l], expected[l]);
+        }
+        led_strip_parallel_prepare(&parallel, parallel_out, PIXELS);
+        led_strip_parallel_encode(&parallel, lanes, PIXELS, parallel_out);
+        int lane_mismatches = 0;
+        for (size_t l = 0; l < lane_counts[n]; ++l) {
+            if (!parallel_decodes_to(parallel_out, parallel.word_bytes, l, expected[l], PIXELS * LED_WIRE_BYTES)) {
+                ++lane_mismatches;
+            }
+        }
+        CHECK_EQ(lane_mismatches, 0);
+    }
+    led_strip_parallel_encoder_t parallel;
+    CHECK_EQ(led_strip_parallel_encoder_init(&parallel, 0), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(led_strip_parallel_encoder_init(&parallel, LANES + 1), ESP_ERR_INVALID_ARG);
+
+    BENCH("led_wire_pixel", 10000000, {
+        led_wire_pixel(pixels[0] + bench_i % PIXELS * 3, squared, bench_i, wire);
+        test_sink += wire[0];
+    });
+    BENCH("spi encode, 300 pixels", 20000, {
+        frame.dither_offset = bench_i;
+        test_sink += led_strip_spi_encode(&spi, &frame, spi_out);
+    });
+    led_strip_parallel_encoder_init(&parallel, 8);
+    led_strip_parallel_prepare(&parallel, parallel_out, PIXELS);
+    BENCH("parallel encode, 8 lanes x 300 pixels", 2000, {
+        lanes[0].dither_offset = bench_i;
+        led_strip_parallel_encode(&parallel, lanes, PIXELS, parallel_out);
+        test_sink += parallel_out[bench_i % sizeof(parallel_out)];
+    });
+    uint8_t transposed[8];
+    BENCH("led_transpose8x8", 10000000, {
+        led_transpose8x8(pixels[0] + bench_i % (PIXELS - 3) * 3, transposed, 1);
+        test_sink += transposed[bench_i & 7];
+    });
+    BENCH("transpose, bit by bit", 10000000, {
+        reference_transpose(pixels[0] + bench_i % (PIXELS - 3) * 3, transposed, 1);
+        test_sink += transposed[bench_i & 7];
+    });
+
+    return test_finish("test_wire_format " CHIP_NAME);
+}
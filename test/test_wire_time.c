@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_support.h"
+#include "led_strip_output.h"
+#include "led_strip_spi_encoder.h"
+#include "led_strip_parallel_encoder.h"
+
+
+#define RESOLUTION_HZ           10000000    // As the firmware configures the RMT channels
+
+#if LED_CHIP == LED_CHIP_WS2812
+#define CHIP_NAME               "WS2812"
+#elif LED_CHIP == LED_CHIP_WS2811
+#define CHIP_NAME               "WS2811"
+#elif LED_CHIP == LED_CHIP_SK6812_RGBW
+#define CHIP_NAME               "SK6812_RGBW"
+#elif LED_CHIP == LED_CHIP_UCS8903
+#define CHIP_NAME               "UCS8903"
+#endif
+
+static uint16_t levels[256];
+static uint8_t pixels[LED_FRAME_BYTES];
+static uint8_t spi_out[LED_STRIP_SPI_BYTES(LED_COUNT)];
+static rmt_encoder_handle_t rmt_encoder;
+static led_strip_spi_encoder_t spi_encoder;
+
+
+/* Wire time of `count` LEDs as each encoder produces it: RMT symbol durations, SPI bits and parallel bus slots
+ * at their clocks */
+static int64_t encoded_ns(led_output_backend_t backend, size_t first, size_t count, size_t segment_count) {
+    led_strip_frame_t frame = { .pixels = pixels + first * LED_PIXEL_BYTES, .pixel_count = count, .levels = levels,
+                                .dither_offset = first, .dither_stride = 71 };
+    if (backend == LED_OUTPUT_BACKEND_RMT) {
+        rmt_encode_state_t state;
+        rmt_encoder->encode(rmt_encoder, NULL, &frame, sizeof(frame), &state);
+        size_t symbol_count;
+        const rmt_symbol_word_t *symbols = rmt_host_symbols(&symbol_count);
+        int64_t ticks = 0;
+        for (size_t i = 0; i < symbol_count; ++i) ticks += symbols[i].duration0 + symbols[i].duration1;
+        return ticks * 1000000000 / RESOLUTION_HZ;
+    }
+    if (backend == LED_OUTPUT_BACKEND_SPI) {
+        size_t bytes = led_strip_spi_encode(&spi_encoder, &frame, spi_out);
+        return (int64_t)bytes * 8 * 1000000000 / LED_STRIP_SPI_CLOCK_HZ;
+    }
+    // One transfer for all lanes, each padded to the longest
+    size_t slots = LED_PARALLEL_BYTES(segment_count, count) / (LED_PARALLEL_BUS_WIDTH(segment_count) / 8);
+    return (int64_t)slots * 1000000000 / LED_PARALLEL_PCLK_HZ;
+}
+
+/* Splits the strip over `segment_count` segments as led_output_init does, checks the split and returns the
+ * encoded wire time of the frame: that of the longest segment */
+static int64_t frame_ns(led_output_backend_t backend, size_t segment_count) {
+    size_t covered = 0, longest = 0;
+    int64_t longest_ns = 0;
+    for (size_t s = 0; s < segment_count; ++s) {
+        size_t first = led_output_segment_first(s, segment_count);
+        size_t count = led_output_segment_first(s + 1, segment_count) - first;
+        CHECK_EQ(first, covered);
+        CHECK(count == LED_COUNT / segment_count || count == led_output_segment_pixels(segment_count));
+        covered += count;
+        if (count > longest) longest = count;
+        if (backend != LED_OUTPUT_BACKEND_PARALLEL) {
+            int64_t ns = encoded_ns(backend, first, count, segment_count);
+            if (ns > longest_ns) longest_ns = ns;
+        }
+    }
+    CHECK_EQ(covered, LED_COUNT);
+    CHECK_EQ(longest, led_output_segment_pixels(segment_count));
+    if (backend == LED_OUTPUT_BACKEND_PARALLEL) longest_ns = encoded_ns(backend, 0, longest, segment_count);
+    return longest_ns;
+}
+
+
+int main(void) {
+    for (int v = 0; v < 256; ++v) levels[v] = v * v;
+    srand(1);
+    for (size_t i = 0; i < sizeof(pixels); ++i) pixels[i] = rand();
+    CHECK_EQ(rmt_new_led_strip_encoder(&(led_strip_encoder_config_t){ .resolution = RESOLUTION_HZ }, &rmt_encoder),
+             ESP_OK);
+    led_strip_spi_encoder_init(&spi_encoder);
+
+    // The SPI and parallel encoders send every chip with the same bit period
+    CHECK_EQ((int64_t)LED_STRIP_SPI_BITS_PER_BIT * 1000000000 / LED_STRIP_SPI_CLOCK_HZ, LED_OUTPUT_SPI_BIT_NS);
+    CHECK_EQ(LED_STRIP_SPI_BIT_NS, LED_OUTPUT_SPI_BIT_NS);
+    CHECK_EQ(LED_PARALLEL_BIT_NS, LED_OUTPUT_SPI_BIT_NS);
+    printf("  %s: RMT bit %u ns at %d MHz (%d ns nominal), SPI and parallel bit %d ns\n", CHIP_NAME,
+           (unsigned)led_output_rmt_bit_ns(RESOLUTION_HZ), RESOLUTION_HZ / 1000000, LED_WIRE_BIT_NS,
+           LED_OUTPUT_SPI_BIT_NS);
+
+    static const char *const backend_names[] = { "RMT", "SPI", "parallel" };
+    static const size_t max_segments[] = { LED_OUTPUT_MAX_RMT_SEGMENTS, LED_OUTPUT_MAX_SPI_SEGMENTS,
+                                           LED_OUTPUT_MAX_SEGMENTS };
+    for (led_output_backend_t backend = LED_OUTPUT_BACKEND_RMT; backend <= LED_OUTPUT_BACKEND_PARALLEL; ++backend) {
+        int mismatches = 0;
+        for (size_t segment_count = 1; segment_count <= max_segments[backend]; ++segment_count) {
+            led_output_config_t config = { .backend = backend, .segment_count = segment_count,
+                                           .resolution_hz = RESOLUTION_HZ };
+            int64_t encoded = frame_ns(backend, segment_count);
+            int64_t modeled = (int64_t)led_output_wire_time_us(&config) * 1000;
+            // The model rounds down to whole microseconds
+            if (modeled > encoded || modeled <= encoded - 1000) {
+                printf("  %s, %zu segments: %lld us modeled, %lld ns encoded\n", backend_names[backend],
+                       segment_count, (long long)modeled / 1000, (long long)encoded);
+                ++mismatches;
+            }
+            if (segment_count == 1 || segment_count == max_segments[backend]) {
+                printf("  %-8s %2zu segments %6lld us\n", backend_names[backend], segment_count,
+                       (long long)modeled / 1000);
+            }
+        }
+        CHECK_EQ(mismatches, 0);
+    }
+
+    return test_finish("test_wire_time " CHIP_NAME);
+}